@@ -0,0 +1,279 @@
+#include "assemblyview.h"
+#include "filesystem.h"
+#include "project_build.h"
+#include "terminal.h"
+#include "info.h"
+#include "trace.h"
+#include <cxxabi.h>
+#include <cstdlib>
+
+AssemblyView::AssemblyView() {
+  //The pane is hidden until shown through the menu
+  set_no_show_all(true);
+  set_size_request(350, -1);
+  
+  label.set_ellipsize(Pango::ELLIPSIZE_END);
+  label.set_alignment(0.0);
+  
+  text_view.set_editable(false);
+  text_view.override_font(Pango::FontDescription("monospace"));
+  auto buffer=text_view.get_buffer();
+  buffer->create_tag("source_line")->property_background_rgba()=Gdk::RGBA("rgba(120, 160, 255, 0.3)");
+  buffer->create_tag("line_number")->property_foreground_rgba()=Gdk::RGBA("rgba(128, 128, 128, 1.0)");
+  buffer->signal_mark_set().connect([this](const Gtk::TextBuffer::iterator &iterator, const Glib::RefPtr<Gtk::TextBuffer::Mark> &mark) {
+    if(mark->get_name()=="insert")
+      highlight_source(iterator.get_line());
+  });
+  
+  scrolled_window.add(text_view);
+  pack_start(label, Gtk::PACK_SHRINK);
+  pack_start(scrolled_window);
+  label.show();
+  scrolled_window.show();
+  text_view.show();
+}
+
+AssemblyView::~AssemblyView() {
+  dispatcher.disconnect();
+  if(compile_thread.joinable())
+    compile_thread.join();
+}
+
+void AssemblyView::show_view(Source::ClangViewParse *view) {
+  if(this->view!=view) {
+    hide_view();
+    this->view=view;
+    view_mark_set_connection=view->get_buffer()->signal_mark_set().connect([this](const Gtk::TextBuffer::iterator &iterator, const Glib::RefPtr<Gtk::TextBuffer::Mark> &mark) {
+      if(mark->get_name()=="insert") {
+        delayed_update_connection.disconnect();
+        delayed_update_connection=Glib::signal_timeout().connect([this]() {
+          update();
+          return false;
+        }, 100);
+      }
+    });
+  }
+  show();
+  update();
+}
+
+void AssemblyView::hide_view() {
+  view_mark_set_connection.disconnect();
+  delayed_update_connection.disconnect();
+  if(view) {
+    auto buffer=view->get_buffer();
+    if(buffer->get_tag_table()->lookup("assembly_source_line"))
+      buffer->remove_tag_by_name("assembly_source_line", buffer->begin(), buffer->end());
+    view=nullptr;
+  }
+  function=nullptr;
+  function_start_line=0;
+  hide();
+}
+
+void AssemblyView::on_change_view(Source::View *view) {
+  if(!get_visible() || view==this->view)
+    return;
+  if(auto clang_view=dynamic_cast<Source::ClangViewParse*>(view))
+    show_view(clang_view);
+  else
+    hide_view();
+}
+
+void AssemblyView::on_close_view(Source::View *view) {
+  if(view==this->view)
+    hide_view();
+}
+
+void AssemblyView::update() {
+  if(!view)
+    return;
+  
+  auto buffer=view->get_buffer();
+  if(buffer->get_tag_table()->lookup("assembly_source_line"))
+    buffer->remove_tag_by_name("assembly_source_line", buffer->begin(), buffer->end());
+  
+  boost::system::error_code ec;
+  auto write_time=boost::filesystem::last_write_time(view->file_path, ec);
+  if(!functions || functions_file_path!=view->file_path || functions_write_time!=write_time) {
+    compile(view->file_path);
+    return;
+  }
+  
+  auto definition=view->get_function_definition_at_cursor();
+  if(!function || definition.start_line!=function_start_line)
+    show_function(definition);
+  highlight_assembly(buffer->get_insert()->get_iter().get_line()+1);
+}
+
+void AssemblyView::compile(const boost::filesystem::path &file_path) {
+  if(compile_running)
+    return;
+  compile_running=true;
+  if(compile_thread.joinable())
+    compile_thread.join();
+  
+  label.set_text("Compiling "+file_path.filename().string()+"...");
+  boost::system::error_code ec;
+  auto write_time=boost::filesystem::last_write_time(file_path, ec);
+  auto build_path=Project::Build::create(file_path)->get_default_path();
+  compile_thread=std::thread([this, file_path, write_time, build_path] {
+    TRACE_SCOPE("assembly", file_path.filename().string());
+    AssemblyFunctions functions;
+    std::string error;
+    auto command=Source::ClangViewParse::get_assembly_command(file_path, build_path);
+    if(command.empty())
+      error=file_path.filename().string()+": could not find compile command for assembly";
+    else {
+      auto key=std::to_string(std::hash<std::string>()(filesystem::read(file_path)))+' '+command;
+      auto it=cache.find(key);
+      if(it!=cache.end())
+        functions=it->second;
+      else {
+        std::string assembly;
+        std::string output;
+        Process process(command, build_path.string(), [&assembly](const char *bytes, size_t n) {
+          assembly.append(bytes, n);
+        }, [&output](const char *bytes, size_t n) {
+          output.append(bytes, n);
+        });
+        if(process.get_exit_status()==0) {
+          functions=std::make_shared<const std::vector<Source::ClangViewParse::AssemblyFunction> >(Source::ClangViewParse::get_assembly_functions(assembly, file_path));
+          if(cache.size()>=32)
+            cache.clear();
+          cache.emplace(key, functions);
+        }
+        else {
+          error=file_path.filename().string()+": compilation to assembly failed";
+          Terminal::get().async_print(output, true);
+        }
+      }
+    }
+    dispatcher.post("Assembly view compiled", [this, file_path, write_time, functions, error] {
+      compile_running=false;
+      if(!error.empty())
+        Info::get().print(error);
+      //The file is not compiled again until it is saved, also when the compilation failed
+      compile_error=error;
+      this->functions=functions?functions:std::make_shared<const std::vector<Source::ClangViewParse::AssemblyFunction> >();
+      functions_file_path=file_path;
+      functions_write_time=write_time;
+      function=nullptr;
+      update();
+    });
+  });
+}
+
+void AssemblyView::show_function(const Source::ClangViewParse::FunctionDefinition &definition) {
+  function=nullptr;
+  function_start_line=definition.start_line;
+  auto buffer=text_view.get_buffer();
+  if(!compile_error.empty()) {
+    label.set_text(compile_error);
+    buffer->set_text("");
+    return;
+  }
+  if(definition.spelling.empty()) {
+    label.set_text("No function at cursor");
+    buffer->set_text("");
+    return;
+  }
+  
+  if(!definition.mangled_name.empty()) {
+    for(auto &assembly_function: *functions) {
+      if(assembly_function.name==definition.mangled_name || assembly_function.name=="_"+definition.mangled_name) {
+        function=&assembly_function;
+        break;
+      }
+    }
+  }
+  //Without the mangled name, the function with the most instructions from the definition is used
+  if(!function) {
+    size_t max_count=0;
+    for(auto &assembly_function: *functions) {
+      size_t count=0;
+      for(auto &line: assembly_function.lines) {
+        if(line.second>=definition.start_line && line.second<=definition.end_line)
+          ++count;
+      }
+      if(count>max_count) {
+        max_count=count;
+        function=&assembly_function;
+      }
+    }
+  }
+  if(!function) {
+    label.set_text(definition.spelling+": no assembly, the function might be inlined or unused");
+    buffer->set_text("");
+    return;
+  }
+  
+  auto name=function->name;
+  int status;
+  auto demangled=abi::__cxa_demangle(name.c_str()+(name.compare(0, 2, "__")==0?1:0), nullptr, nullptr, &status);
+  if(demangled) {
+    if(status==0)
+      name=demangled;
+    free(demangled);
+  }
+  label.set_text(name);
+  label.set_tooltip_text(name);
+  
+  std::string text;
+  for(auto &line: function->lines) {
+    auto line_number=line.second>0?std::to_string(line.second):std::string();
+    if(line_number.size()<5)
+      text+=std::string(5-line_number.size(), ' ');
+    text+=line_number+"  ";
+    if(!line.first.empty() && line.first.back()!=':')
+      text+="  ";
+    text+=line.first+'\n';
+  }
+  buffer->set_text(text);
+  for(int c=0;c<buffer->get_line_count()-1;++c)
+    buffer->apply_tag_by_name("line_number", buffer->get_iter_at_line(c), buffer->get_iter_at_line_offset(c, 5));
+  text_view.scroll_to(buffer->get_insert(), 0.0, 0.0, 0.0);
+}
+
+void AssemblyView::highlight_assembly(int source_line) {
+  auto buffer=text_view.get_buffer();
+  buffer->remove_tag_by_name("source_line", buffer->begin(), buffer->end());
+  if(!function)
+    return;
+  int first_line=-1;
+  for(size_t c=0;c<function->lines.size();++c) {
+    if(function->lines[c].second==source_line) {
+      auto start=buffer->get_iter_at_line(c);
+      auto end=start;
+      end.forward_line();
+      buffer->apply_tag_by_name("source_line", start, end);
+      if(first_line==-1)
+        first_line=c;
+    }
+  }
+  if(first_line!=-1 && !text_view.has_focus())
+    text_view.scroll_to(buffer->get_iter_at_line(first_line), 0.1);
+}
+
+void AssemblyView::highlight_source(int assembly_line) {
+  //Only lines selected in the pane are highlighted in the source
+  if(!view || !function || !text_view.has_focus() || assembly_line<0 || static_cast<size_t>(assembly_line)>=function->lines.size())
+    return;
+  auto buffer=view->get_buffer();
+  auto tag=buffer->get_tag_table()->lookup("assembly_source_line");
+  if(!tag) {
+    tag=buffer->create_tag("assembly_source_line");
+    tag->property_background_rgba()=Gdk::RGBA("rgba(120, 160, 255, 0.3)");
+  }
+  buffer->remove_tag(tag, buffer->begin(), buffer->end());
+  
+  auto line=function->lines[assembly_line].second;
+  if(line<=0 || line>buffer->get_line_count())
+    return;
+  auto start=buffer->get_iter_at_line(line-1);
+  auto end=start;
+  end.forward_line();
+  buffer->apply_tag(tag, start, end);
+  view->scroll_to(start, 0.25);
+  highlight_assembly(line);
+}
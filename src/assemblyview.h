@@ -0,0 +1,62 @@
+#ifndef JUCI_ASSEMBLYVIEW_H_
+#define JUCI_ASSEMBLYVIEW_H_
+
+#include <gtkmm.h>
+#include <boost/filesystem.hpp>
+#include <thread>
+#include <memory>
+#include <unordered_map>
+#include <ctime>
+#include "source_clang.h"
+#include "dispatcher.h"
+
+///Side pane showing the optimized assembly of the function at the cursor, with the source line at the cursor highlighted in the assembly
+class AssemblyView : public Gtk::VBox {
+  AssemblyView();
+public:
+  static AssemblyView &get() {
+    static AssemblyView singleton;
+    return singleton;
+  }
+  ~AssemblyView();
+  
+  ///Shows the pane for the function at the cursor in view, and follows the cursor in view until the pane is hidden
+  void show_view(Source::ClangViewParse *view);
+  void hide_view();
+  ///Called when the current view changes or a view is closed
+  void on_change_view(Source::View *view);
+  void on_close_view(Source::View *view);
+
+private:
+  Gtk::Label label;
+  Gtk::ScrolledWindow scrolled_window;
+  Gtk::TextView text_view;
+  
+  Source::ClangViewParse *view=nullptr;
+  sigc::connection view_mark_set_connection;
+  sigc::connection delayed_update_connection;
+  
+  typedef std::shared_ptr<const std::vector<Source::ClangViewParse::AssemblyFunction> > AssemblyFunctions;
+  ///Functions of the saved file at functions_file_path
+  AssemblyFunctions functions;
+  boost::filesystem::path functions_file_path;
+  std::time_t functions_write_time=0;
+  const Source::ClangViewParse::AssemblyFunction *function=nullptr;
+  int function_start_line=0;
+  
+  ///Key is the hash of the file content followed by the compile command. Only used in compile_thread.
+  std::unordered_map<std::string, AssemblyFunctions> cache;
+  std::thread compile_thread;
+  ///The file of the current view is compiled again in update() when compile_thread is done, if needed
+  bool compile_running=false;
+  std::string compile_error;
+  Dispatcher dispatcher;
+  
+  void update();
+  void compile(const boost::filesystem::path &file_path);
+  void show_function(const Source::ClangViewParse::FunctionDefinition &definition);
+  void highlight_assembly(int source_line);
+  void highlight_source(int assembly_line);
+};
+
+#endif // JUCI_ASSEMBLYVIEW_H_
@@ -0,0 +1,242 @@
+#include "benchmark_results.h"
+#include "filesystem.h"
+#include <boost/property_tree/json_parser.hpp>
+#include <algorithm>
+#include <cmath>
+#include <regex>
+#include <sstream>
+#include <iomanip>
+
+bool BenchmarkResults::add(const std::string &json) {
+  boost::property_tree::ptree pt;
+  try {
+    std::stringstream ss(json);
+    boost::property_tree::read_json(ss, pt);
+  }
+  catch(const std::exception &) {
+    return false;
+  }
+  auto benchmarks=pt.get_child_optional("benchmarks");
+  if(!benchmarks)
+    return false;
+  
+  class Samples {
+  public:
+    std::vector<double> times;
+    double mean=-1.0, stddev=-1.0;
+  };
+  std::vector<std::string> names;
+  std::unordered_map<std::string, Samples> samples;
+  for(auto &node: *benchmarks) {
+    auto &benchmark=node.second;
+    auto name=benchmark.get<std::string>("name", "");
+    auto time=benchmark.get<double>("cpu_time", -1.0);
+    if(name.empty() || time<0.0 || benchmark.get<std::string>("error_occurred", "false")=="true")
+      continue;
+    auto time_unit=benchmark.get<std::string>("time_unit", "ns");
+    if(time_unit=="us")
+      time*=1.0e3;
+    else if(time_unit=="ms")
+      time*=1.0e6;
+    else if(time_unit=="s")
+      time*=1.0e9;
+    
+    //Older versions of Google Benchmark only mark aggregates with a suffix in the name
+    auto aggregate_name=benchmark.get<std::string>("aggregate_name", "");
+    if(aggregate_name.empty() && benchmark.get<std::string>("run_type", "").empty()) {
+      for(auto &suffix: {"mean", "median", "stddev", "cv"}) {
+        auto size=std::char_traits<char>::length(suffix);
+        if(name.size()>size+1 && name.compare(name.size()-size, size, suffix)==0 && name[name.size()-size-1]=='_') {
+          aggregate_name=suffix;
+          break;
+        }
+      }
+    }
+    if(!aggregate_name.empty())
+      name=benchmark.get<std::string>("run_name", name.substr(0, name.size()-std::min(name.size(), aggregate_name.size()+1)));
+    
+    auto it=samples.find(name);
+    if(it==samples.end()) {
+      names.emplace_back(name);
+      it=samples.emplace(name, Samples()).first;
+    }
+    if(aggregate_name.empty())
+      it->second.times.emplace_back(time);
+    else if(aggregate_name=="mean")
+      it->second.mean=time;
+    else if(aggregate_name=="stddev")
+      it->second.stddev=time;
+  }
+  
+  for(auto &name: names) {
+    auto &name_samples=samples[name];
+    Result result;
+    result.name=name;
+    if(name_samples.mean>=0.0) {
+      result.time=name_samples.mean;
+      result.stddev=std::max(name_samples.stddev, 0.0);
+    }
+    else if(!name_samples.times.empty()) {
+      auto &times=name_samples.times;
+      for(auto &time: times)
+        result.time+=time;
+      result.time/=times.size();
+      if(times.size()>1) {
+        double sum=0.0;
+        for(auto &time: times)
+          sum+=(time-result.time)*(time-result.time);
+        result.stddev=std::sqrt(sum/(times.size()-1));
+      }
+    }
+    else
+      continue;
+    results.emplace_back(std::move(result));
+  }
+  return true;
+}
+
+bool BenchmarkResults::save(const boost::filesystem::path &path) const {
+  boost::property_tree::ptree pt;
+  pt.put("commit", commit);
+  pt.put("time", time);
+  boost::property_tree::ptree benchmarks;
+  for(auto &result: results) {
+    boost::property_tree::ptree benchmark;
+    benchmark.put("name", result.name);
+    benchmark.put("time", result.time);
+    benchmark.put("stddev", result.stddev);
+    benchmarks.push_back(std::make_pair("", benchmark));
+  }
+  pt.add_child("benchmarks", benchmarks);
+  try {
+    boost::property_tree::write_json(path.string(), pt);
+  }
+  catch(const std::exception &) {
+    return false;
+  }
+  return true;
+}
+
+bool BenchmarkResults::load(const boost::filesystem::path &path) {
+  boost::property_tree::ptree pt;
+  try {
+    boost::property_tree::read_json(path.string(), pt);
+    commit=pt.get<std::string>("commit", "");
+    time=pt.get<std::time_t>("time", 0);
+    results.clear();
+    if(auto benchmarks=pt.get_child_optional("benchmarks")) {
+      for(auto &node: *benchmarks) {
+        Result result;
+        result.name=node.second.get<std::string>("name");
+        result.time=node.second.get<double>("time");
+        result.stddev=node.second.get<double>("stddev", 0.0);
+        results.emplace_back(std::move(result));
+      }
+    }
+  }
+  catch(const std::exception &) {
+    return false;
+  }
+  return true;
+}
+
+std::string BenchmarkResults::get_file_name() const {
+  return std::to_string(time)+'_'+(commit.empty()?std::string("unknown"):commit.substr(0, 12))+".json";
+}
+
+std::vector<boost::filesystem::path> BenchmarkResults::get_runs(const boost::filesystem::path &directory) {
+  std::vector<std::pair<long long, boost::filesystem::path> > runs;
+  boost::system::error_code ec;
+  boost::filesystem::directory_iterator end_it;
+  for(boost::filesystem::directory_iterator it(directory, ec);!ec && it!=end_it;it.increment(ec)) {
+    auto filename=it->path().filename().string();
+    if(it->path().extension()!=".json" || filename.empty() || filename[0]<'0' || filename[0]>'9')
+      continue;
+    runs.emplace_back(std::stoll(filename), it->path());
+  }
+  std::sort(runs.begin(), runs.end());
+  std::vector<boost::filesystem::path> paths;
+  for(auto &run: runs)
+    paths.emplace_back(std::move(run.second));
+  return paths;
+}
+
+std::vector<BenchmarkResults::Delta> BenchmarkResults::compare(const BenchmarkResults &baseline) const {
+  std::unordered_map<std::string, const Result*> baseline_results;
+  for(auto &result: baseline.results)
+    baseline_results.emplace(result.name, &result);
+  
+  std::vector<Delta> deltas;
+  for(auto &result: results) {
+    Delta delta;
+    delta.name=result.name;
+    delta.new_time=result.time;
+    delta.old_time=-1.0;
+    delta.change=0.0;
+    delta.significant=false;
+    auto it=baseline_results.find(result.name);
+    if(it!=baseline_results.end() && it->second->time>0.0) {
+      auto &old_result=*it->second;
+      delta.old_time=old_result.time;
+      delta.change=(result.time-old_result.time)/old_result.time;
+      //Changes within two standard deviations of the difference are noise. Without repetitions, 5% is used.
+      auto noise=2.0*std::sqrt(result.stddev*result.stddev+old_result.stddev*old_result.stddev);
+      auto threshold=std::max(noise, (result.stddev==0.0 && old_result.stddev==0.0?0.05:0.01)*old_result.time);
+      delta.significant=std::abs(result.time-old_result.time)>threshold;
+    }
+    deltas.emplace_back(std::move(delta));
+  }
+  return deltas;
+}
+
+std::string BenchmarkResults::get_function_name(const std::string &name) {
+  return name.substr(0, name.find_first_of("/<"));
+}
+
+std::unordered_map<std::string, std::pair<boost::filesystem::path, int> > BenchmarkResults::find_registrations(const boost::filesystem::path &project_path, const std::unordered_set<std::string> &function_names) {
+  const static std::regex registration_regex("BENCHMARK[A-Z0-9_]*\\(\\s*([A-Za-z_][A-Za-z_0-9]*)");
+  const static std::unordered_set<std::string> extensions={".c", ".cc", ".cpp", ".cxx", ".c++", ".h", ".hh", ".hpp", ".hxx"};
+  std::unordered_map<std::string, std::pair<boost::filesystem::path, int> > registrations;
+  boost::system::error_code ec;
+  boost::filesystem::recursive_directory_iterator end_it;
+  for(boost::filesystem::recursive_directory_iterator it(project_path, ec);!ec && it!=end_it;it.increment(ec)) {
+    auto filename=it->path().filename().string();
+    if(boost::filesystem::is_directory(it->path(), ec)) {
+      if((!filename.empty() && filename[0]=='.') || boost::filesystem::exists(it->path()/"CMakeCache.txt", ec))
+        it.no_push();
+      continue;
+    }
+    if(extensions.count(it->path().extension().string())==0)
+      continue;
+    auto content=filesystem::read(it->path());
+    if(content.find("BENCHMARK")==std::string::npos)
+      continue;
+    for(std::sregex_iterator match_it(content.begin(), content.end(), registration_regex), match_end;match_it!=match_end;++match_it) {
+      auto name=(*match_it)[1].str();
+      if(function_names.count(name)>0 && registrations.count(name)==0) {
+        auto line=std::count(content.begin(), content.begin()+match_it->position(), '\n')+1;
+        registrations.emplace(name, std::make_pair(it->path(), static_cast<int>(line)));
+      }
+    }
+  }
+  return registrations;
+}
+
+std::string BenchmarkResults::format_time(double time) {
+  const char *unit="ns";
+  if(time>=1.0e9) {
+    time/=1.0e9;
+    unit="s";
+  }
+  else if(time>=1.0e6) {
+    time/=1.0e6;
+    unit="ms";
+  }
+  else if(time>=1.0e3) {
+    time/=1.0e3;
+    unit="us";
+  }
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(time>=100.0?0:(time>=10.0?1:2)) << time << ' ' << unit;
+  return ss.str();
+}
@@ -0,0 +1,60 @@
+#ifndef JUCI_BENCHMARK_RESULTS_H_
+#define JUCI_BENCHMARK_RESULTS_H_
+#include <boost/filesystem.hpp>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <ctime>
+
+///Results of one run of the Google Benchmark executables of a project, stored per run in the build directory
+class BenchmarkResults {
+public:
+  class Result {
+  public:
+    std::string name;
+    ///Mean CPU time per iteration in nanoseconds
+    double time=0.0;
+    ///Standard deviation of time over the repetitions, or 0 if the benchmark was run once
+    double stddev=0.0;
+  };
+  class Delta {
+  public:
+    std::string name;
+    ///Negative if the benchmark is not in the baseline
+    double old_time, new_time;
+    ///Relative change of new_time compared to old_time
+    double change;
+    ///Set if the change is larger than the noise of the two runs
+    bool significant;
+  };
+  
+  std::string commit;
+  std::time_t time=0;
+  std::vector<Result> results;
+  
+  ///Adds the results in the --benchmark_format=json output of a benchmark executable.
+  ///Repetitions are combined into mean and standard deviation. Returns false if json could not be parsed.
+  bool add(const std::string &json);
+  bool save(const boost::filesystem::path &path) const;
+  bool load(const boost::filesystem::path &path);
+  
+  ///Returns the file name of a run in the runs directory, sorted on time
+  std::string get_file_name() const;
+  ///Returns the stored runs in directory, oldest first
+  static std::vector<boost::filesystem::path> get_runs(const boost::filesystem::path &directory);
+  
+  ///Returns the change of each benchmark compared to the same benchmark in baseline
+  std::vector<Delta> compare(const BenchmarkResults &baseline) const;
+  
+  ///Returns the function a benchmark is registered with, for instance BM_sort from BM_sort<int>/1024
+  static std::string get_function_name(const std::string &name);
+  ///Returns the location of the BENCHMARK registration of each of the function names found in the source files in project_path.
+  ///Directories containing CMakeCache.txt are skipped.
+  static std::unordered_map<std::string, std::pair<boost::filesystem::path, int> > find_registrations(const boost::filesystem::path &project_path, const std::unordered_set<std::string> &function_names);
+  
+  ///Returns time in ns, us, ms or s with 3 significant digits
+  static std::string format_time(double time);
+};
+
+#endif // JUCI_BENCHMARK_RESULTS_H_
@@ -3,7 +3,10 @@
 #include "dialogs.h"
 #include "config.h"
 #include "terminal.h"
+#include "trace.h"
 #include <regex>
+#include <mutex>
+#include <thread>
 
 CMake::CMake(const boost::filesystem::path &path) {
   const auto find_cmake_project=[this](const boost::filesystem::path &cmake_path) {
@@ -32,7 +35,7 @@ CMake::CMake(const boost::filesystem::path &path) {
   }
 }
 
-bool CMake::update_default_build(const boost::filesystem::path &default_build_path, bool force) {
+bool CMake::update_default_build(const boost::filesystem::path &default_build_path, bool force, bool background) {
   if(project_path.empty())
     return false;
   
@@ -41,11 +44,31 @@ bool CMake::update_default_build(const boost::filesystem::path &default_build_pa
   
   if(default_build_path.empty())
     return false;
+  
+  //Views parsed in background threads can update the same build at the same time.
+  //The main thread does not block on a run in a background thread, but handles events while waiting for it.
+  static std::mutex mutex;
+  std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+  if(background)
+    lock.lock();
+  else if(!lock.try_lock()) {
+    Dialog::Message message("Waiting for the default build to be updated");
+    while(!lock.try_lock()) {
+      while(Gtk::Main::events_pending())
+        Gtk::Main::iteration(false);
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    message.hide();
+  }
+  
   if(!boost::filesystem::exists(default_build_path)) {
     boost::system::error_code ec;
     boost::filesystem::create_directories(default_build_path, ec);
     if(ec) {
-      Terminal::get().print("Error: could not create "+default_build_path.string()+": "+ec.message()+"\n", true);
+      if(background)
+        Terminal::get().async_print("Error: could not create "+default_build_path.string()+": "+ec.message()+"\n", true);
+      else
+        Terminal::get().print("Error: could not create "+default_build_path.string()+": "+ec.message()+"\n", true);
       return false;
     }
   }
@@ -54,10 +77,16 @@ bool CMake::update_default_build(const boost::filesystem::path &default_build_pa
     return true;
   
   auto compile_commands_path=default_build_path/"compile_commands.json";
-  Dialog::Message message("Creating/updating default build");
+  std::unique_ptr<Dialog::Message> message;
+  if(background)
+    Terminal::get().async_print("Creating/updating default build in "+default_build_path.string()+"\n");
+  else
+    message=std::make_unique<Dialog::Message>("Creating/updating default build");
+  TRACE_SCOPE("CMake", default_build_path.string());
   auto exit_status=Terminal::get().process(Config::get().project.cmake_command+" "+
                                            filesystem::escape_argument(project_path)+" -DCMAKE_EXPORT_COMPILE_COMMANDS=ON", default_build_path);
-  message.hide();
+  if(message)
+    message->hide();
   if(exit_status==EXIT_SUCCESS) {
 #ifdef _WIN32 //Temporary fix to MSYS2's libclang
     auto compile_commands_file=filesystem::read(compile_commands_path);
@@ -102,6 +131,7 @@ bool CMake::update_debug_build(const boost::filesystem::path &debug_build_path,
     return true;
   
   auto message=std::make_unique<Dialog::Message>("Creating/updating debug build");
+  TRACE_SCOPE("CMake", debug_build_path.string());
   auto exit_status=Terminal::get().process(Config::get().project.cmake_command+" "+
                                            filesystem::escape_argument(project_path)+" -DCMAKE_BUILD_TYPE=Debug", debug_build_path);
   if(message)
@@ -136,6 +166,32 @@ boost::filesystem::path CMake::get_executable(const boost::filesystem::path &fil
   return executable_path;
 }
 
+std::vector<boost::filesystem::path> CMake::get_benchmark_executables() {
+  std::vector<boost::filesystem::path> benchmark_executables;
+  auto executables=get_functions_parameters("add_executable");
+  auto libraries=get_functions_parameters("target_link_libraries");
+  for(auto &executable: executables) {
+    if(executable.second.empty())
+      continue;
+    bool benchmark=false;
+    for(auto &target_libraries: libraries) {
+      if(target_libraries.second.empty() || target_libraries.second[0]!=executable.second[0])
+        continue;
+      for(size_t c=1;c<target_libraries.second.size();++c) {
+        auto &library=target_libraries.second[c];
+        if(library=="benchmark" || library=="benchmark_main" || library=="benchmark::benchmark" ||
+           library=="benchmark::benchmark_main" || library=="-lbenchmark") {
+          benchmark=true;
+          break;
+        }
+      }
+    }
+    if(benchmark)
+      benchmark_executables.emplace_back(executable.first.parent_path()/executable.second[0]);
+  }
+  return benchmark_executables;
+}
+
 void CMake::read_files() {
   for(auto &path: paths)
     files.emplace_back(filesystem::read(path));
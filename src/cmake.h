@@ -11,10 +11,13 @@ public:
   boost::filesystem::path project_path;
   std::vector<boost::filesystem::path> paths;
   
-  bool update_default_build(const boost::filesystem::path &default_build_path, bool force=false);
+  ///If background is true, the function can be called from a thread other than the main thread, and no dialog is shown
+  bool update_default_build(const boost::filesystem::path &default_build_path, bool force=false, bool background=false);
   bool update_debug_build(const boost::filesystem::path &debug_build_path, bool force=false);
   
   boost::filesystem::path get_executable(const boost::filesystem::path &file_path);
+  ///Returns the executables that link with the Google Benchmark library
+  std::vector<boost::filesystem::path> get_benchmark_executables();
   
   std::vector<std::pair<boost::filesystem::path, std::vector<std::string> > > get_functions_parameters(const std::string &name);
 private:
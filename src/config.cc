@@ -87,6 +87,7 @@ void Config::retrieve_config() {
   window.theme_variant=cfg.get<std::string>("gtk_theme.variant");
   window.version = cfg.get<std::string>("version");
   window.default_size = {cfg.get<int>("default_window_size.width"), cfg.get<int>("default_window_size.height")};
+  window.stall_log_threshold=cfg.get<int>("stall_log_threshold", 100);
   
   project.default_build_path=cfg.get<std::string>("project.default_build_path");
   project.debug_build_path=cfg.get<std::string>("project.debug_build_path");
@@ -95,6 +96,7 @@ void Config::retrieve_config() {
   project.save_on_compile_or_run=cfg.get<bool>("project.save_on_compile_or_run");
   project.clear_terminal_on_compile=cfg.get<bool>("project.clear_terminal_on_compile");
   project.ctags_command=cfg.get<std::string>("project.ctags_command");
+  project.debug_profile_sampling_interval=cfg.get<int>("project.debug_profile_sampling_interval", 10);
   
   terminal.history_size=cfg.get<int>("terminal.history_size");
   terminal.font=cfg.get<std::string>("terminal.font");
@@ -20,6 +20,7 @@ public:
     std::string theme_variant;
     std::string version;
     std::pair<int, int> default_size;
+    int stall_log_threshold;
   };
   
   class Terminal {
@@ -43,6 +44,7 @@ public:
     bool save_on_compile_or_run;
     bool clear_terminal_on_compile;
     std::string ctags_command;
+    int debug_profile_sampling_interval;
   };
   
   class Source {
@@ -4,12 +4,14 @@
 #include "project_build.h"
 #include "filesystem.h"
 #include "directories.h"
+#include "trace.h"
 #include <iostream>
 #include <vector>
 #include <regex>
 #include <climits>
 
 std::pair<boost::filesystem::path, std::unique_ptr<std::stringstream> > Ctags::get_result(const boost::filesystem::path &path) {
+  TRACE_SCOPE("Ctags::get_result", path.string());
   auto build=Project::Build::create(path);
   auto run_path=build->project_path;
   std::string exclude;
@@ -73,23 +75,13 @@ Ctags::Location Ctags::get_location(const std::string &line, bool markup) {
       size_t pos=location.source.find(location.symbol);
       if(pos!=std::string::npos)
         location.index+=pos;
-      
-      if(markup) {
-        location.source=Glib::Markup::escape_text(location.source);
-        pos=-1;
-        while((pos=location.source.find(location.symbol, pos+1))!=std::string::npos) {
-          location.source.insert(pos+location.symbol.size(), "</b>");
-          location.source.insert(pos, "<b>");
-          pos+=7+location.symbol.size();
-        }
-      }
     }
     else {
       location.index=0;
       location.source=location.symbol;
-      if(markup)
-        location.source="<b>"+Glib::Markup::escape_text(location.source)+"</b>";
     }
+    if(markup)
+      location.source=get_source_markup(location);
   }
   else
     std::cerr << "Warning (ctags): please report to the juCi++ project that the following line was not parsed:\n" << line << std::endl;
@@ -97,6 +89,18 @@ Ctags::Location Ctags::get_location(const std::string &line, bool markup) {
   return location;
 }
 
+std::string Ctags::get_source_markup(const Location &location) {
+  std::string source=Glib::Markup::escape_text(location.source);
+  std::string symbol=Glib::Markup::escape_text(location.symbol);
+  size_t pos=-1;
+  while((pos=source.find(symbol, pos+1))!=std::string::npos) {
+    source.insert(pos+symbol.size(), "</b>");
+    source.insert(pos, "<b>");
+    pos+=7+symbol.size();
+  }
+  return source;
+}
+
 ///Split up a type into its various significant parts
 std::vector<std::string> Ctags::get_type_parts(const std::string type) {
   std::vector<std::string> parts;
@@ -126,6 +130,10 @@ std::vector<Ctags::Location> Ctags::get_locations(const boost::filesystem::path
     return std::vector<Location>();
   result.second->seekg(0, std::ios::beg);
   
+  return get_locations(result.first, *result.second, name, type);
+}
+
+std::vector<Ctags::Location> Ctags::get_locations(const boost::filesystem::path &run_path, std::istream &stream, const std::string &name, const std::string &type) {
   //insert name into type
   size_t c=0;
   size_t bracket_count=0;
@@ -145,7 +153,7 @@ std::vector<Ctags::Location> Ctags::get_locations(const boost::filesystem::path
   std::string line;
   long best_score=LONG_MIN;
   std::vector<Location> best_locations;
-  while(std::getline(*result.second, line)) {
+  while(std::getline(stream, line)) {
     if(line.size()>2048)
       continue;
     auto location=Ctags::get_location(line, false);
@@ -156,7 +164,7 @@ std::vector<Ctags::Location> Ctags::get_locations(const boost::filesystem::path
     else if(location.symbol!=name)
       continue;
     
-    location.file_path=result.first/location.file_path;
+    location.file_path=run_path/location.file_path;
     
     auto source_parts=get_type_parts(location.source);
     
@@ -21,8 +21,12 @@ public:
   static std::pair<boost::filesystem::path, std::unique_ptr<std::stringstream> > get_result(const boost::filesystem::path &path);
   
   static Location get_location(const std::string &line, bool markup);
+  ///Returns location.source as markup with location.symbol in bold
+  static std::string get_source_markup(const Location &location);
   
   static std::vector<Location> get_locations(const boost::filesystem::path &path, const std::string &name, const std::string &type);
+  ///Returns the locations in the ctags output in stream that best match name and type
+  static std::vector<Location> get_locations(const boost::filesystem::path &run_path, std::istream &stream, const std::string &name, const std::string &type);
 private:
   static std::vector<std::string> get_type_parts(const std::string type);
 };
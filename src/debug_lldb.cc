@@ -1,5 +1,6 @@
 #include "debug_lldb.h"
 #include <stdio.h>
+#include <csignal>
 #ifdef __APPLE__
 #include <stdlib.h>
 #endif
@@ -29,7 +30,7 @@ void log(const char *msg, void *) {
   std::cout << "debugger log: " << msg << std::endl;
 }
 
-Debug::LLDB::LLDB(): state(lldb::StateType::eStateInvalid), buffer_size(131072) {
+Debug::LLDB::LLDB(): state(lldb::StateType::eStateInvalid), stop_id(0), buffer_size(131072) {
 #ifdef __APPLE__
   auto debugserver_path=boost::filesystem::path("/usr/local/opt/llvm/bin/debugserver");
   if(boost::filesystem::exists(debugserver_path))
@@ -42,7 +43,9 @@ void Debug::LLDB::start(const std::string &command, const boost::filesystem::pat
                   std::function<void(int exit_status)> callback,
                   std::function<void(const std::string &status)> status_callback,
                   std::function<void(const boost::filesystem::path &file_path, int line_nr, int line_index)> stop_callback,
-                  const std::string &remote_host) {
+                  const std::string &remote_host, int sampling_interval) {
+  if(sampling_thread.joinable())
+    sampling_thread.join();
   if(!debugger) {
     lldb::SBDebugger::Initialize();
     debugger=std::make_unique<lldb::SBDebugger>(lldb::SBDebugger::Create(true, log, nullptr));
@@ -112,7 +115,7 @@ void Debug::LLDB::start(const std::string &command, const boost::filesystem::pat
     }
     lldb::SBEvent event;
     while(true) {
-      if(listener->GetNextEvent(event)) {
+      if(listener->WaitForEvent(1, event)) {
         if((event.GetType() & lldb::SBProcess::eBroadcastBitStateChanged)>0) {
           auto state=process->GetStateFromEvent(event);
           this->state=state;
@@ -137,14 +140,50 @@ void Debug::LLDB::start(const std::string &command, const boost::filesystem::pat
   }
   if(debug_thread.joinable())
     debug_thread.join();
+  profile=Profile();
+  profile_start=std::chrono::steady_clock::now();
+  sample_pending=false;
+  sample_resuming=false;
+  variable_values.clear();
+  previous_variable_values.clear();
   debug_thread=std::thread([this, callback, status_callback, stop_callback]() {
     lldb::SBEvent event;
+    std::vector<char> buffer(buffer_size);
     while(true) {
-      std::unique_lock<std::mutex> lock(event_mutex);
-      if(listener->GetNextEvent(event)) {
+      //event_mutex is not locked while waiting, so that other threads can use the debugger meanwhile
+      if(listener->WaitForEvent(1, event)) {
+        std::unique_lock<std::mutex> lock(event_mutex);
         if((event.GetType() & lldb::SBProcess::eBroadcastBitStateChanged)>0) {
           auto state=process->GetStateFromEvent(event);
           this->state=state;
+          ++stop_id;
+          memory_pages.clear();
+          
+          //Processes stopped by the sampling thread are continued without notifying the callbacks
+          if(state==lldb::StateType::eStateStopped && sample_pending) {
+            sample_pending=false;
+            bool interrupted=true;
+            for(uint32_t c=0;c<process->GetNumThreads();c++) {
+              auto thread=process->GetThreadAtIndex(c);
+              auto stop_reason=thread.GetStopReason();
+              if(stop_reason!=lldb::eStopReasonInvalid && stop_reason!=lldb::eStopReasonNone &&
+                 !(stop_reason==lldb::eStopReasonSignal && thread.GetStopReasonDataAtIndex(0)==SIGSTOP)) {
+                interrupted=false;
+                break;
+              }
+            }
+            if(interrupted) {
+              add_sample();
+              sample_resuming=true;
+              process->Continue();
+              profile.overhead+=std::chrono::steady_clock::now()-sample_start;
+              continue;
+            }
+          }
+          else if(state==lldb::StateType::eStateRunning && sample_resuming) {
+            sample_resuming=false;
+            continue;
+          }
           
           if(state==lldb::StateType::eStateStopped) {
             for(uint32_t c=0;c<process->GetNumThreads();c++) {
@@ -154,6 +193,10 @@ void Debug::LLDB::start(const std::string &command, const boost::filesystem::pat
                 break;
               }
             }
+            //The values read at the last stop are kept until the variables are read again
+            for(auto &variable_value: variable_values)
+              previous_variable_values[variable_value.first]=std::move(variable_value.second);
+            variable_values.clear();
           }
           
           //Update debug status
@@ -223,23 +266,35 @@ void Debug::LLDB::start(const std::string &command, const boost::filesystem::pat
           }
         }
         if((event.GetType() & lldb::SBProcess::eBroadcastBitSTDOUT)>0) {
-          char buffer[buffer_size];
           size_t n;
-          while((n=process->GetSTDOUT(buffer, buffer_size))!=0)
-            Terminal::get().async_print(std::string(buffer, n));
+          while((n=process->GetSTDOUT(buffer.data(), buffer_size))!=0)
+            Terminal::get().async_print(std::string(buffer.data(), n));
         }
         //TODO: for some reason stderr is redirected to stdout
         if((event.GetType() & lldb::SBProcess::eBroadcastBitSTDERR)>0) {
-          char buffer[buffer_size];
           size_t n;
-          while((n=process->GetSTDERR(buffer, buffer_size))!=0)
-            Terminal::get().async_print(std::string(buffer, n), true);
+          while((n=process->GetSTDERR(buffer.data(), buffer_size))!=0)
+            Terminal::get().async_print(std::string(buffer.data(), n), true);
         }
       }
-      lock.unlock();
-      std::this_thread::sleep_for(std::chrono::milliseconds(200));
     }
   });
+  
+  if(sampling_interval>0) {
+    sampling_thread=std::thread([this, sampling_interval] {
+      while(true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(sampling_interval));
+        std::unique_lock<std::mutex> lock(event_mutex);
+        if(!process)
+          return;
+        if(state==lldb::StateType::eStateRunning && !sample_pending) {
+          sample_pending=true;
+          sample_start=std::chrono::steady_clock::now();
+          process->Stop();
+        }
+      }
+    });
+  }
 }
 
 void Debug::LLDB::continue_debug() {
@@ -299,11 +354,11 @@ std::pair<std::string, std::string> Debug::LLDB::run_command(const std::string &
   return command_return;
 }
 
-std::vector<Debug::LLDB::Frame> Debug::LLDB::get_backtrace() {
+std::vector<Debug::LLDB::Frame> Debug::LLDB::get_backtrace(uint32_t thread_index_id) {
   std::vector<Frame> backtrace;
   std::unique_lock<std::mutex> lock(event_mutex);
   if(state==lldb::StateType::eStateStopped) {
-    auto thread=process->GetSelectedThread();
+    auto thread=thread_index_id==0?process->GetSelectedThread():process->GetThreadByIndexID(thread_index_id);
     for(uint32_t c_f=0;c_f<thread.GetNumFrames();c_f++) {
       Frame backtrace_frame;
       auto frame=thread.GetFrameAtIndex(c_f);
@@ -335,61 +390,241 @@ std::vector<Debug::LLDB::Frame> Debug::LLDB::get_backtrace() {
   return backtrace;
 }
 
-std::vector<Debug::LLDB::Variable> Debug::LLDB::get_variables() {
-  std::vector<Debug::LLDB::Variable> variables;
+std::vector<std::pair<uint32_t, std::string> > Debug::LLDB::get_threads() {
+  std::vector<std::pair<uint32_t, std::string> > threads;
   std::unique_lock<std::mutex> lock(event_mutex);
   if(state==lldb::StateType::eStateStopped) {
+    auto add_thread=[&threads](lldb::SBThread &thread) {
+      std::string description;
+      if(thread.GetName()!=nullptr)
+        description=thread.GetName();
+      char buffer[100];
+      buffer[0]='\0';
+      thread.GetStopDescription(buffer, 100);
+      if(buffer[0]!='\0')
+        description+=(description.empty()?"":" ")+std::string("(")+buffer+")";
+      threads.emplace_back(thread.GetIndexID(), description);
+    };
+    auto selected_thread=process->GetSelectedThread();
+    add_thread(selected_thread);
     for(uint32_t c_t=0;c_t<process->GetNumThreads();c_t++) {
       auto thread=process->GetThreadAtIndex(c_t);
-      for(uint32_t c_f=0;c_f<thread.GetNumFrames();c_f++) {
-        auto frame=thread.GetFrameAtIndex(c_f);
-        auto values=frame.GetVariables(true, true, true, false);
-        for(uint32_t value_index=0;value_index<values.GetSize();value_index++) {
-          lldb::SBStream stream;
-          auto value=values.GetValueAtIndex(value_index);
-        
-          Debug::LLDB::Variable variable;
-          variable.thread_index_id=thread.GetIndexID();
-          variable.frame_index=c_f;
-          if(value.GetName()!=nullptr)
-            variable.name=value.GetName();
-          value.GetDescription(stream);
-          variable.value=stream.GetData();
-          
-          auto declaration=value.GetDeclaration();
-          if(declaration.IsValid()) {
-            variable.declaration_found=true;
-            variable.line_nr=declaration.GetLine();
-            variable.line_index=declaration.GetColumn();
-            if(variable.line_index==0)
-              variable.line_index=1;
+      if(thread.GetIndexID()!=selected_thread.GetIndexID())
+        add_thread(thread);
+    }
+  }
+  return threads;
+}
+
+std::vector<std::pair<uint32_t, uint32_t> > Debug::LLDB::get_frames() {
+  std::vector<std::pair<uint32_t, uint32_t> > frames;
+  std::unique_lock<std::mutex> lock(event_mutex);
+  if(state==lldb::StateType::eStateStopped) {
+    auto selected_thread=process->GetSelectedThread();
+    for(uint32_t c_f=0;c_f<selected_thread.GetNumFrames();c_f++)
+      frames.emplace_back(selected_thread.GetIndexID(), c_f);
+    for(uint32_t c_t=0;c_t<process->GetNumThreads();c_t++) {
+      auto thread=process->GetThreadAtIndex(c_t);
+      if(thread.GetIndexID()==selected_thread.GetIndexID())
+        continue;
+      for(uint32_t c_f=0;c_f<thread.GetNumFrames();c_f++)
+        frames.emplace_back(thread.GetIndexID(), c_f);
+    }
+  }
+  return frames;
+}
+
+std::vector<Debug::LLDB::Variable> Debug::LLDB::get_variables(uint32_t thread_index_id, uint32_t frame_index) {
+  std::vector<Debug::LLDB::Variable> variables;
+  std::unique_lock<std::mutex> lock(event_mutex);
+  if(state==lldb::StateType::eStateStopped) {
+    auto thread=process->GetThreadByIndexID(thread_index_id);
+    auto frame=thread.GetFrameAtIndex(frame_index);
+    auto frame_key=get_frame_key(thread, frame_index);
+    auto values=frame.GetVariables(true, true, true, false);
+    for(uint32_t value_index=0;value_index<values.GetSize();value_index++) {
+      auto value=values.GetValueAtIndex(value_index);
             
-            auto file_spec=declaration.GetFileSpec();
-            variable.file_path=filesystem::get_canonical_path(file_spec.GetDirectory());
-            variable.file_path/=file_spec.GetFilename();
-          }
-          else {
-            variable.declaration_found=false;
-            auto line_entry=frame.GetLineEntry();
-            if(line_entry.IsValid()) {
-              variable.line_nr=line_entry.GetLine();
-              variable.line_index=line_entry.GetColumn();
-              if(variable.line_index==0)
-                variable.line_index=1;
-              
-              auto file_spec=line_entry.GetFileSpec();
-              variable.file_path=filesystem::get_canonical_path(file_spec.GetDirectory());
-              variable.file_path/=file_spec.GetFilename();
-            }
-          }
-          variables.emplace_back(variable);
+      auto variable=get_variable(value, frame_key+':'+(value.GetName()!=nullptr?value.GetName():""));
+      variable.thread_index_id=thread_index_id;
+      variable.frame_index=frame_index;
+      variable.value_index=value_index;
+      
+      auto declaration=value.GetDeclaration();
+      if(declaration.IsValid()) {
+        variable.declaration_found=true;
+        variable.line_nr=declaration.GetLine();
+        variable.line_index=declaration.GetColumn();
+        if(variable.line_index==0)
+          variable.line_index=1;
+        variable.file_path=get_path(declaration.GetFileSpec());
+      }
+      else {
+        variable.declaration_found=false;
+        auto line_entry=frame.GetLineEntry();
+        if(line_entry.IsValid()) {
+          variable.line_nr=line_entry.GetLine();
+          variable.line_index=line_entry.GetColumn();
+          if(variable.line_index==0)
+            variable.line_index=1;
+          variable.file_path=get_path(line_entry.GetFileSpec());
         }
       }
+      variables.emplace_back(variable);
     }
   }
   return variables;
 }
 
+std::vector<Debug::LLDB::Variable> Debug::LLDB::get_variables() {
+  std::vector<Debug::LLDB::Variable> variables;
+  for(auto &frame: get_frames()) {
+    auto frame_variables=get_variables(frame.first, frame.second);
+    variables.insert(variables.end(), frame_variables.begin(), frame_variables.end());
+  }
+  return variables;
+}
+
+std::vector<Debug::LLDB::Variable> Debug::LLDB::get_children(const Variable &variable, uint32_t start, uint32_t max_children, uint32_t &children_size) {
+  std::vector<Variable> children;
+  children_size=0;
+  std::unique_lock<std::mutex> lock(event_mutex);
+  auto value=find_value(variable);
+  if(!value.IsValid())
+    return children;
+  
+  //Only the requested children are read, so that large containers can be read one page at a time
+  children_size=value.GetNumChildren();
+  for(auto c=start;c<children_size && c-start<max_children;++c) {
+    auto child=value.GetChildAtIndex(c);
+    auto name=child.GetName()!=nullptr?std::string(child.GetName()):'['+std::to_string(c)+']';
+    auto child_variable=get_variable(child, variable.key+'/'+name);
+    child_variable.name=name;
+    child_variable.thread_index_id=variable.thread_index_id;
+    child_variable.frame_index=variable.frame_index;
+    child_variable.value_index=variable.value_index;
+    child_variable.child_indices=variable.child_indices;
+    child_variable.child_indices.emplace_back(c);
+    child_variable.declaration_found=variable.declaration_found;
+    child_variable.file_path=variable.file_path;
+    child_variable.line_nr=variable.line_nr;
+    child_variable.line_index=variable.line_index;
+    children.emplace_back(std::move(child_variable));
+  }
+  return children;
+}
+
+std::string Debug::LLDB::get_variable_description(const Variable &variable, uint32_t max_children) {
+  std::string description;
+  std::unique_lock<std::mutex> lock(event_mutex);
+  auto value=find_value(variable);
+  if(value.IsValid()) {
+    if(value.GetTypeName()!=nullptr)
+      description+="("+std::string(value.GetTypeName())+") ";
+    description+=variable.name;
+    auto value_string=get_value_string(value);
+    if(!value_string.empty())
+      description+=" = "+value_string;
+    
+    //Only the direct children are fetched, and at most max_children of these
+    auto children_size=value.GetNumChildren();
+    for(uint32_t c=0;c<children_size && c<max_children;++c) {
+      auto child=value.GetChildAtIndex(c);
+      description+="\n  ";
+      if(child.GetName()!=nullptr)
+        description+=child.GetName();
+      auto child_value_string=get_value_string(child);
+      if(!child_value_string.empty())
+        description+=" = "+child_value_string;
+      else if(child.MightHaveChildren())
+        description+=" = {...}";
+    }
+    if(children_size>max_children)
+      description+="\n  ... and "+std::to_string(children_size-max_children)+" more";
+  }
+  return description;
+}
+
+boost::filesystem::path Debug::LLDB::get_path(const lldb::SBFileSpec &file_spec) {
+  auto directory=file_spec.GetDirectory();
+  if(directory==nullptr || file_spec.GetFilename()==nullptr)
+    return boost::filesystem::path();
+  auto it=canonical_directories.find(directory);
+  if(it==canonical_directories.end())
+    it=canonical_directories.emplace(directory, filesystem::get_canonical_path(directory)).first;
+  return it->second/file_spec.GetFilename();
+}
+
+void Debug::LLDB::add_sample() {
+  for(uint32_t c_t=0;c_t<process->GetNumThreads();c_t++) {
+    auto thread=process->GetThreadAtIndex(c_t);
+    std::vector<Profile::Frame> backtrace;
+    for(uint32_t c_f=0;c_f<thread.GetNumFrames();c_f++) {
+      auto frame=thread.GetFrameAtIndex(c_f);
+      Profile::Frame profile_frame;
+      if(frame.GetFunctionName()!=nullptr)
+        profile_frame.function_name=frame.GetFunctionName();
+      profile_frame.line_nr=0;
+      auto line_entry=frame.GetLineEntry();
+      if(line_entry.IsValid()) {
+        profile_frame.file_path=get_path(line_entry.GetFileSpec());
+        profile_frame.line_nr=line_entry.GetLine();
+      }
+      backtrace.emplace_back(std::move(profile_frame));
+    }
+    profile.add_backtrace(backtrace);
+  }
+  profile.duration=std::chrono::steady_clock::now()-profile_start;
+}
+
+Profile Debug::LLDB::get_profile() {
+  std::unique_lock<std::mutex> lock(event_mutex);
+  return profile;
+}
+
+std::string Debug::LLDB::get_frame_key(lldb::SBThread &thread, uint32_t frame_index) {
+  std::string function_name;
+  auto frame=thread.GetFrameAtIndex(frame_index);
+  if(frame.GetFunctionName()!=nullptr)
+    function_name=frame.GetFunctionName();
+  //The depth is counted from the outermost frame, so that it does not change when functions are called or return
+  auto depth=thread.GetNumFrames()-1-frame_index;
+  return std::to_string(thread.GetIndexID())+':'+std::to_string(depth)+':'+function_name;
+}
+
+Debug::LLDB::Variable Debug::LLDB::get_variable(lldb::SBValue &value, const std::string &key) {
+  Variable variable;
+  variable.stop_id=stop_id;
+  variable.key=key;
+  if(value.GetName()!=nullptr)
+    variable.name=value.GetName();
+  variable.value=get_value_string(value);
+  variable.might_have_children=value.MightHaveChildren();
+  auto it=previous_variable_values.find(key);
+  variable.changed=it!=previous_variable_values.end() && it->second!=variable.value;
+  variable_values[key]=variable.value;
+  return variable;
+}
+
+lldb::SBValue Debug::LLDB::find_value(const Variable &variable) {
+  if(state!=lldb::StateType::eStateStopped || variable.stop_id!=stop_id)
+    return lldb::SBValue();
+  auto frame=process->GetThreadByIndexID(variable.thread_index_id).GetFrameAtIndex(variable.frame_index);
+  auto value=frame.GetVariables(true, true, true, false).GetValueAtIndex(variable.value_index);
+  for(auto child_index: variable.child_indices)
+    value=value.GetChildAtIndex(child_index);
+  return value;
+}
+
+std::string Debug::LLDB::get_value_string(lldb::SBValue &value) {
+  auto value_string=value.GetValue();
+  if(value_string==nullptr)
+    value_string=value.GetSummary();
+  if(value_string==nullptr)
+    return std::string();
+  return value_string;
+}
+
 void Debug::LLDB::select_frame(uint32_t frame_index, uint32_t thread_index_id) {
   std::unique_lock<std::mutex> lock(event_mutex);
   if(state==lldb::StateType::eStateStopped) {
@@ -399,10 +634,64 @@ void Debug::LLDB::select_frame(uint32_t frame_index, uint32_t thread_index_id) {
   }
 }
 
+std::shared_ptr<const std::vector<unsigned char> > Debug::LLDB::get_memory_page(uint64_t page_address) {
+  std::unique_lock<std::mutex> lock(event_mutex);
+  if(state!=lldb::StateType::eStateStopped)
+    return nullptr;
+  auto it=memory_pages.find(page_address);
+  if(it!=memory_pages.end())
+    return it->second;
+  
+  if(memory_pages.size()>=maximum_memory_pages)
+    memory_pages.clear();
+  std::shared_ptr<std::vector<unsigned char> > page;
+  std::vector<unsigned char> buffer(memory_page_size);
+  lldb::SBError error;
+  auto size=process->ReadMemory(page_address, buffer.data(), buffer.size(), error);
+  if(size>0) {
+    buffer.resize(size);
+    page=std::make_shared<std::vector<unsigned char> >(std::move(buffer));
+  }
+  //Unreadable pages are also cached, as nullptr
+  memory_pages.emplace(page_address, page);
+  return page;
+}
+
+bool Debug::LLDB::get_address(const std::string &expression, uint64_t &address) {
+  std::unique_lock<std::mutex> lock(event_mutex);
+  if(state==lldb::StateType::eStateStopped) {
+    auto frame=process->GetSelectedThread().GetSelectedFrame();
+    auto value=frame.GetValueForVariablePath(expression.c_str());
+    if(!value.IsValid())
+      value=frame.EvaluateExpression(expression.c_str());
+    return get_address(value, address);
+  }
+  return false;
+}
+
+bool Debug::LLDB::get_address(const Variable &variable, uint64_t &address) {
+  std::unique_lock<std::mutex> lock(event_mutex);
+  auto value=find_value(variable);
+  return get_address(value, address);
+}
+
+bool Debug::LLDB::get_address(lldb::SBValue &value, uint64_t &address) {
+  if(value.IsValid() && value.GetError().Success()) {
+    if(value.GetType().IsPointerType())
+      address=value.GetValueAsUnsigned();
+    else
+      address=value.GetLoadAddress();
+    return address!=LLDB_INVALID_ADDRESS;
+  }
+  return false;
+}
+
 void Debug::LLDB::cancel() {
   kill();
   if(debug_thread.joinable())
     debug_thread.join();
+  if(sampling_thread.joinable())
+    sampling_thread.join();
 }
 
 std::string Debug::LLDB::get_value(const std::string &variable, const boost::filesystem::path &file_path, unsigned int line_nr, unsigned int line_index) {
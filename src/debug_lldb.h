@@ -7,7 +7,12 @@
 #include <lldb/API/SBListener.h>
 #include <lldb/API/SBProcess.h>
 #include <thread>
+#include <chrono>
+#include "profile.h"
 #include <mutex>
+#include <atomic>
+#include <map>
+#include <memory>
 
 namespace Debug {
   class LLDB {
@@ -25,8 +30,21 @@ namespace Debug {
     public:
       uint32_t thread_index_id;
       uint32_t frame_index;
+      ///Index in the variables of the frame
+      uint32_t value_index;
+      ///Child indices from the frame variable at value_index to this variable, empty for the frame variables
+      std::vector<uint32_t> child_indices;
+      ///The stop the variable was read at
+      uint32_t stop_id;
+      ///Identifies the variable across stops
+      std::string key;
       std::string name;
+      ///Value or summary, without the children of the variable
       std::string value;
+      ///True if value differs from the value the last time the variable was read at an earlier stop
+      bool changed;
+      ///False if the variable has no children
+      bool might_have_children;
       bool declaration_found;
       boost::filesystem::path file_path;
       int line_nr;
@@ -45,7 +63,9 @@ namespace Debug {
                std::function<void(int exit_status)> callback=nullptr,
                std::function<void(const std::string &status)> status_callback=nullptr,
                std::function<void(const boost::filesystem::path &file_path, int line_nr, int line_index)> stop_callback=nullptr,
-               const std::string &remote_host="");
+               const std::string &remote_host="", int sampling_interval=0);
+    ///Returns the backtraces sampled since start() was called with a sampling interval in milliseconds
+    Profile get_profile();
     void continue_debug(); //can't use continue as function name
     void stop();
     void kill();
@@ -53,10 +73,34 @@ namespace Debug {
     void step_into();
     void step_out();
     std::pair<std::string, std::string> run_command(const std::string &command);
-    std::vector<Frame> get_backtrace();
+    ///Returns the frames of the selected thread, or of the thread with thread_index_id if it is not 0
+    std::vector<Frame> get_backtrace(uint32_t thread_index_id=0);
+    ///Returns thread index id and stop description of the threads, the selected thread first
+    std::vector<std::pair<uint32_t, std::string> > get_threads();
+    ///Returns thread index id and frame index of all frames, the frames of the selected thread first
+    std::vector<std::pair<uint32_t, uint32_t> > get_frames();
+    ///Only the values of the variables that are read are compared with their values at earlier stops
+    std::vector<Variable> get_variables(uint32_t thread_index_id, uint32_t frame_index);
     std::vector<Variable> get_variables();
+    ///Returns at most max_children children of a variable from get_variables or get_children, starting at child start,
+    ///and sets children_size to the number of children.
+    ///Returns no children if the process has been resumed since the variable was read.
+    std::vector<Variable> get_children(const Variable &variable, uint32_t start, uint32_t max_children, uint32_t &children_size);
+    ///Returns type, value and the first max_children children of a variable from get_variables or get_children.
+    ///Returns empty string if the process has been resumed since the variable was read.
+    std::string get_variable_description(const Variable &variable, uint32_t max_children=100);
     void select_frame(uint32_t frame_index, uint32_t thread_index_id=0);
     
+    static const uint64_t memory_page_size=4096;
+    ///Returns the memory at page_address, which must be a multiple of memory_page_size.
+    ///The pages are cached until the process is resumed. Returns nullptr if the page could not be read.
+    std::shared_ptr<const std::vector<unsigned char> > get_memory_page(uint64_t page_address);
+    ///Sets address to the memory the variable or expression points to, or to its address if it is not a pointer.
+    ///Returns false if the address could not be found.
+    bool get_address(const std::string &expression, uint64_t &address);
+    ///Same as get_address, for a variable from get_variables or get_children
+    bool get_address(const Variable &variable, uint64_t &address);
+    
     void cancel();
     
     std::string get_value(const std::string &variable, const boost::filesystem::path &file_path, unsigned int line_nr, unsigned int line_index);
@@ -65,6 +109,8 @@ namespace Debug {
     bool is_invalid();
     bool is_stopped();
     bool is_running();
+    ///Changes every time the debugged process stops or resumes, does not lock event_mutex
+    uint32_t get_stop_id() {return stop_id;}
     
     void add_breakpoint(const boost::filesystem::path &file_path, int line_nr);
     void remove_breakpoint(const boost::filesystem::path &file_path, int line_nr, int line_count);
@@ -76,11 +122,40 @@ namespace Debug {
     std::unique_ptr<lldb::SBListener> listener;
     std::unique_ptr<lldb::SBProcess> process;
     std::thread debug_thread;
+    ///Interrupts the running process every sampling interval so that the backtraces can be sampled in debug_thread
+    std::thread sampling_thread;
+    bool sample_pending=false;
+    bool sample_resuming=false;
+    std::chrono::steady_clock::time_point sample_start;
+    std::chrono::steady_clock::time_point profile_start;
+    Profile profile;
     
     lldb::StateType state;
+    std::atomic<uint32_t> stop_id;
     std::mutex event_mutex;
     
     size_t buffer_size;
+    
+    std::unordered_map<std::string, boost::filesystem::path> canonical_directories;
+    ///Values of the variables read at the current stop, and the last values read at earlier stops.
+    ///Only the variables that have been read are stored, and variable_values is moved to previous_variable_values at a stop.
+    std::unordered_map<std::string, std::string> variable_values;
+    std::unordered_map<std::string, std::string> previous_variable_values;
+    static std::string get_frame_key(lldb::SBThread &thread, uint32_t frame_index);
+    ///Returns the variable read from value, and sets changed by comparing the value with previous_variable_values
+    Variable get_variable(lldb::SBValue &value, const std::string &key);
+    ///Returns an invalid value if the process has been resumed since the variable was read
+    lldb::SBValue find_value(const Variable &variable);
+    static bool get_address(lldb::SBValue &value, uint64_t &address);
+    
+    ///Cleared when the state of the process changes
+    std::map<uint64_t, std::shared_ptr<const std::vector<unsigned char> > > memory_pages;
+    static const size_t maximum_memory_pages=1024;
+    
+    static std::string get_value_string(lldb::SBValue &value);
+    ///Returns the path of file_spec, with the directory made canonical
+    boost::filesystem::path get_path(const lldb::SBFileSpec &file_spec);
+    void add_sample();
   };
 }
 
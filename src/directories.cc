@@ -5,6 +5,7 @@
 #include "notebook.h"
 #include "filesystem.h"
 #include "entrybox.h"
+#include "word_index.h"
 
 namespace sigc {
 #ifndef SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
@@ -414,6 +415,7 @@ void Directories::open(const boost::filesystem::path &dir_path) {
   }
   directories.clear();
   add_or_update_path(dir_path, Gtk::TreeModel::Row(), true);
+  WordIndex::get().open(dir_path);
   
   path=dir_path;
 }
@@ -560,6 +562,7 @@ void Directories::add_or_update_path(const boost::filesystem::path &dir_path, co
       if(monitor_event!=Gio::FileMonitorEvent::FILE_MONITOR_EVENT_CHANGES_DONE_HINT) {
         if(repository)
           repository->clear_saved_status();
+        WordIndex::get().update(file->get_path());
         connection->disconnect();
         *connection=Glib::signal_timeout().connect([path_and_row, this]() {
           add_or_update_path(path_and_row->first, path_and_row->second, true);
@@ -692,7 +695,7 @@ void Directories::colorize_path(const boost::filesystem::path &dir_path_, bool i
         Terminal::get().async_print(std::string("Error (git): ")+e.what()+'\n', true);
       }
       
-      dispatcher.post([this, dir_path, include_parent_paths, status] {
+      dispatcher.post("Directories git status", [this, dir_path, include_parent_paths, status] {
         auto it=directories.find(dir_path->string());
         if(it==directories.end())
           return;
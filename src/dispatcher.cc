@@ -1,10 +1,17 @@
 #include "dispatcher.h"
+#include "trace.h"
+#include "watchdog.h"
+
+std::atomic<size_t> Dispatcher::pending(0);
 
 Dispatcher::Dispatcher() {
   connection=dispatcher.connect([this] {
     std::unique_lock<std::mutex> lock(functions_mutex);
     for(auto &function: functions) {
-      function();
+      TRACE_SCOPE(function.first);
+      Watchdog::Task task(function.first);
+      function.second();
+      --pending;
     }
     functions.clear();
   });
@@ -13,13 +20,15 @@ Dispatcher::Dispatcher() {
 Dispatcher::~Dispatcher() {
   disconnect();
   std::unique_lock<std::mutex> lock(functions_mutex);
+  pending-=functions.size();
   functions.clear();
 }
 
-void Dispatcher::post(std::function<void()> &&function) {
+void Dispatcher::post(const char *name, std::function<void()> &&function) {
   {
     std::unique_lock<std::mutex> lock(functions_mutex);
-    functions.emplace_back(function);
+    functions.emplace_back(name, std::move(function));
+    ++pending;
   }
   dispatcher();
 }
@@ -3,18 +3,23 @@
 #include <gtkmm.h>
 #include <mutex>
 #include <vector>
+#include <atomic>
 
 class Dispatcher {
 private:
-  std::vector<std::function<void()>> functions;
+  std::vector<std::pair<const char *, std::function<void()>>> functions;
   std::mutex functions_mutex;
   Glib::Dispatcher dispatcher;
   sigc::connection connection;
 public:
   Dispatcher();
   ~Dispatcher();
-  void post(std::function<void()> &&function);
+  ///The name, which must be a string literal, is the Watchdog task and trace event while function runs
+  void post(const char *name, std::function<void()> &&function);
   void disconnect();
+  
+  ///Number of posted functions in all dispatchers that are not yet called
+  static std::atomic<size_t> pending;
 };
 
 #endif	/* DISPATCHER_H_ */
@@ -8,6 +8,8 @@ const std::string default_config_file = R"RAW({
         "width": 800,
         "height": 600
     },
+    "stall_log_threshold_comment": "Milliseconds the user interface can be unresponsive before a backtrace is written to stalls.log in the juCi++ home folder. Use 0 to disable",
+    "stall_log_threshold": 100,
     "gtk_theme": {
         "name_comment": "Use \"\" for default theme, At least these two exist on all systems: Adwaita, Raleigh",
         "name": "",
@@ -111,14 +113,21 @@ R"RAW(
         "source_implement_method": "<primary><shift>m",
         "source_goto_next_diagnostic": "<primary>e",
         "source_apply_fix_its": "<control>space",
+        "source_toggle_optimization_remarks": "",
+        "source_toggle_assembly": "",
+        "source_show_record_layout": "",
+        "source_show_record_layouts_report": "",
         "project_set_run_arguments": "",
         "compile_and_run": "<primary>Return",
         "compile": "<primary><shift>Return",
+        "project_run_benchmarks": "",
+        "project_toggle_benchmark_baseline": "",
         "run_command": "<alt>Return",
         "kill_last_running": "<primary>Escape",
         "force_kill_last_running": "<primary><shift>Escape",
         "debug_set_run_arguments": "",
         "debug_start_continue": "<primary>y",
+        "debug_profile": "",
         "debug_stop": "<primary><shift>y",
         "debug_kill": "<primary><shift>k",
         "debug_step_over": "<primary>j",
@@ -126,6 +135,7 @@ R"RAW(
         "debug_step_out": "<primary><shift>t",
         "debug_backtrace": "<primary><shift>j",
         "debug_show_variables": "<primary><shift>b",
+        "debug_show_memory": "",
         "debug_run_command": "<alt><shift>Return",
         "debug_toggle_breakpoint": "<primary>b",
         "debug_goto_stop": "<primary><shift>l",)RAW"
@@ -141,7 +151,9 @@ R"RAW(
 R"RAW(
         "close_tab": "<primary>w",
         "window_toggle_split": "",
-        "window_clear_terminal": ""
+        "window_clear_terminal": "",
+        "window_toggle_tracing": "",
+        "window_toggle_performance_hud": ""
     },
     "project": {
         "default_build_path_comment": "Use <project_directory_name> to insert the project top level directory name",
@@ -159,7 +171,9 @@ R"RAW(
         "make_command": "cmake --build .",
         "save_on_compile_or_run": true,
         "clear_terminal_on_compile": true,
-        "ctags_command": "ctags"
+        "ctags_command": "ctags",
+        "debug_profile_sampling_interval_comment": "Milliseconds between the backtrace samples taken by Debug Profile",
+        "debug_profile_sampling_interval": 10
     },
     "documentation_searches": {
         "clang": {
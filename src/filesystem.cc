@@ -4,11 +4,13 @@
 #include <algorithm>
 
 #include "filesystem.h"
+#include "trace.h"
 
 const size_t buffer_size=131072;
 
 //Only use on small files
 std::string filesystem::read(const std::string &path) {
+  TRACE_SCOPE("filesystem::read", path);
   std::stringstream ss;
   std::ifstream input(path, std::ofstream::binary);
   if(input) {
@@ -19,6 +21,7 @@ std::string filesystem::read(const std::string &path) {
 }
 
 int filesystem::read(const std::string &path, Glib::RefPtr<Gtk::TextBuffer> text_buffer) {
+  TRACE_SCOPE("filesystem::read", path);
   std::ifstream input(path, std::ofstream::binary);
   
   if(input) {
@@ -105,6 +108,7 @@ std::vector<std::string> filesystem::read_lines(const std::string &path) {
 
 //Only use on small files
 bool filesystem::write(const std::string &path, const std::string &new_content) {
+  TRACE_SCOPE("filesystem::write", path);
   std::ofstream output(path, std::ofstream::binary);
   if(output)
     output << new_content;
@@ -115,6 +119,7 @@ bool filesystem::write(const std::string &path, const std::string &new_content)
 }
 
 bool filesystem::write(const std::string &path, Glib::RefPtr<Gtk::TextBuffer> buffer) {
+  TRACE_SCOPE("filesystem::write", path);
   std::ofstream output(path, std::ofstream::binary);
   if(output) {
     auto start_iter=buffer->begin();
@@ -1,5 +1,8 @@
 #include "git.h"
+#include "trace.h"
+#include "filesystem.h"
 #include <cstring>
+#include <algorithm>
 
 bool Git::initialized=false;
 std::mutex Git::mutex;
@@ -25,35 +28,123 @@ Git::Repository::Diff::Diff(const boost::filesystem::path &path, git_repository
   
   git_diff_init_options(&options, GIT_DIFF_OPTIONS_VERSION);
   options.context_lines=0;
+  
+  auto text=static_cast<const char*>(git_blob_rawcontent(blob.get()));
+  auto size=static_cast<size_t>(git_blob_rawsize(blob.get()));
+  for(size_t offset=0;offset<size;) {
+    blob_line_offsets.emplace_back(offset);
+    auto newline=static_cast<const char*>(std::memchr(text+offset, '\n', size-offset));
+    offset=newline?newline-text+1:size;
+  }
 }
 
-//Based on https://github.com/atom/git-diff/blob/master/lib/git-diff-view.coffee
 int Git::Repository::Diff::hunk_cb(const git_diff_delta *delta, const git_diff_hunk *hunk, void *payload) noexcept {
-  auto lines=static_cast<Lines*>(payload);
-  auto start=hunk->new_start-1;
-  auto end=hunk->new_start+hunk->new_lines-1;
-  if(hunk->old_lines==0 && hunk->new_lines>0)
-    lines->added.emplace_back(start, end);
-  else if(hunk->new_lines==0 && hunk->old_lines>0)
-    lines->removed.emplace_back(start);
-  else
-    lines->modified.emplace_back(start, end);
-    
+  auto hunks=static_cast<std::vector<Hunk>*>(payload);
+  hunks->emplace_back(Hunk{hunk->old_lines==0?hunk->old_start:hunk->old_start-1, hunk->old_lines,
+                           hunk->new_lines==0?hunk->new_start:hunk->new_start-1, hunk->new_lines});
   return 0;
 }
 
 Git::Repository::Diff::Lines Git::Repository::Diff::get_lines(const std::string &buffer) {
+  return get_lines(get_hunks(buffer));
+}
+
+//Based on https://github.com/atom/git-diff/blob/master/lib/git-diff-view.coffee
+Git::Repository::Diff::Lines Git::Repository::Diff::get_lines(const std::vector<Hunk> &hunks) {
   Lines lines;
+  for(auto &hunk: hunks) {
+    if(hunk.old_lines==0 && hunk.new_lines>0)
+      lines.added.emplace_back(hunk.new_start, hunk.new_start+hunk.new_lines);
+    else if(hunk.new_lines==0 && hunk.old_lines>0)
+      lines.removed.emplace_back(hunk.new_start-1);
+    else
+      lines.modified.emplace_back(hunk.new_start, hunk.new_start+hunk.new_lines);
+  }
+  return lines;
+}
+
+std::vector<Git::Repository::Diff::Hunk> Git::Repository::Diff::get_hunks(const std::string &buffer) {
+  std::vector<Hunk> hunks;
   Error error;
   std::lock_guard<std::mutex> lock(mutex);
+  TRACE_SCOPE("git_diff_blob_to_buffer");
 #if LIBGIT2_SOVERSION>=23
-  error.code=git_diff_blob_to_buffer(blob.get(), nullptr, buffer.c_str(), buffer.size(), nullptr, &options, nullptr, nullptr, hunk_cb, nullptr, &lines);
+  error.code=git_diff_blob_to_buffer(blob.get(), nullptr, buffer.c_str(), buffer.size(), nullptr, &options, nullptr, nullptr, hunk_cb, nullptr, &hunks);
 #else
-  error.code=git_diff_blob_to_buffer(blob.get(), nullptr, buffer.c_str(), buffer.size(), nullptr, &options, nullptr, hunk_cb, nullptr, &lines);
+  error.code=git_diff_blob_to_buffer(blob.get(), nullptr, buffer.c_str(), buffer.size(), nullptr, &options, nullptr, hunk_cb, nullptr, &hunks);
 #endif
   if(error)
     throw std::runtime_error(error.message());
-  return lines;
+  return hunks;
+}
+
+std::vector<Git::Repository::Diff::Hunk> Git::Repository::Diff::get_hunks(const std::string &buffer, const std::vector<Hunk> &hunks,
+                                                                          int start_line, int previous_end_line, int end_line) {
+#if LIBGIT2_SOVERSION>=25
+  //The hunks that touch the replaced lines are diffed again, and the old lines of these hunks
+  //are found from the number of lines the hunks before them removed or added
+  size_t first=0;
+  int old_offset=0;
+  while(first<hunks.size() && hunks[first].new_start+hunks[first].new_lines<start_line) {
+    old_offset+=hunks[first].old_lines-hunks[first].new_lines;
+    ++first;
+  }
+  auto last=first;
+  int old_difference=0;
+  while(last<hunks.size() && hunks[last].new_start<=previous_end_line) {
+    start_line=std::min(start_line, hunks[last].new_start);
+    auto hunk_end=hunks[last].new_start+hunks[last].new_lines;
+    end_line+=std::max(hunk_end-previous_end_line, 0);
+    previous_end_line=std::max(previous_end_line, hunk_end);
+    old_difference+=hunks[last].old_lines-hunks[last].new_lines;
+    ++last;
+  }
+  auto old_start_line=start_line+old_offset;
+  auto old_end_line=previous_end_line+old_offset+old_difference;
+  
+  auto old_text=static_cast<const char*>(git_blob_rawcontent(blob.get()));
+  auto old_size=static_cast<size_t>(git_blob_rawsize(blob.get()));
+  auto old_line_offset=[this, old_size](int line) {
+    return static_cast<size_t>(line)<blob_line_offsets.size()?blob_line_offsets[line]:old_size;
+  };
+  auto old_start=old_line_offset(old_start_line);
+  auto old_end=old_line_offset(old_end_line);
+  
+  size_t start=buffer.size(), end=buffer.size();
+  size_t offset=0;
+  for(int line=0;offset<buffer.size();++line) {
+    if(line==start_line)
+      start=offset;
+    if(line==end_line) {
+      end=offset;
+      break;
+    }
+    auto newline=buffer.find('\n', offset);
+    offset=newline!=std::string::npos?newline+1:buffer.size();
+  }
+  
+  std::vector<Hunk> new_hunks(hunks.begin(), hunks.begin()+first);
+  {
+    Error error;
+    std::lock_guard<std::mutex> lock(mutex);
+    TRACE_SCOPE("git_diff_buffers");
+    error.code=git_diff_buffers(old_text+old_start, old_end-old_start, nullptr, buffer.c_str()+start, end-start, nullptr, &options, nullptr, nullptr, hunk_cb, nullptr, &new_hunks);
+    if(error)
+      throw std::runtime_error(error.message());
+  }
+  for(auto it=new_hunks.begin()+first;it!=new_hunks.end();++it) {
+    it->old_start+=old_start_line;
+    it->new_start+=start_line;
+  }
+  auto line_difference=end_line-previous_end_line;
+  for(auto it=hunks.begin()+last;it!=hunks.end();++it) {
+    new_hunks.emplace_back(*it);
+    new_hunks.back().new_start+=line_difference;
+  }
+  return new_hunks;
+#else
+  return get_hunks(buffer);
+#endif
 }
 
 int Git::Repository::Diff::line_cb(const git_diff_delta *delta, const git_diff_hunk *hunk, const git_diff_line *line, void *payload) noexcept {
@@ -74,6 +165,7 @@ std::string Git::Repository::Diff::get_details(const std::string &buffer, int li
   details.second=line_nr;
   Error error;
   std::lock_guard<std::mutex> lock(mutex);
+  TRACE_SCOPE("git_diff_blob_to_buffer");
 #if LIBGIT2_SOVERSION>=23
   error.code=git_diff_blob_to_buffer(blob.get(), nullptr, buffer.c_str(), buffer.size(), nullptr, &options, nullptr, nullptr, nullptr, line_cb, &details);
 #else
@@ -195,6 +287,7 @@ Git::Repository::Status Git::Repository::get_status() {
   };
   Error error;
   std::lock_guard<std::mutex> lock(mutex);
+  TRACE_SCOPE("Git::Repository::get_status", work_path.string());
   error.code = git_status_foreach(repository.get(), status_callback, &callback);
   if(error)
     throw std::runtime_error(error.message());
@@ -222,6 +315,16 @@ boost::filesystem::path Git::Repository::get_path() noexcept {
   return Git::path(git_repository_path(repository.get()));
 }
 
+std::string Git::Repository::get_head_commit() noexcept {
+  std::lock_guard<std::mutex> lock(mutex);
+  git_oid oid;
+  if(git_reference_name_to_id(&oid, repository.get(), "HEAD")!=0)
+    return std::string();
+  char oid_string[GIT_OID_HEXSZ+1];
+  git_oid_tostr(oid_string, sizeof(oid_string), &oid);
+  return oid_string;
+}
+
 boost::filesystem::path Git::Repository::get_root_path(const boost::filesystem::path &path) {
   initialize();
   git_buf root = {0, 0, 0};
@@ -238,6 +341,22 @@ boost::filesystem::path Git::Repository::get_root_path(const boost::filesystem::
   return root_path;
 }
 
+bool Git::Repository::is_ignored(const boost::filesystem::path &path) noexcept {
+  auto relative_path=filesystem::get_relative_path(path, work_path);
+  if(relative_path.empty())
+    return false;
+  auto path_str=relative_path.generic_string();
+  boost::system::error_code ec;
+  //Directories are only matched by directory patterns, like build/, when ending with /
+  if(boost::filesystem::is_directory(path, ec))
+    path_str+='/';
+  std::lock_guard<std::mutex> lock(mutex);
+  int ignored=0;
+  if(git_ignore_path_is_ignored(&ignored, repository.get(), path_str.c_str())!=0)
+    return false;
+  return ignored==1;
+}
+
 Git::Repository::Diff Git::Repository::get_diff(const boost::filesystem::path &path) {
   return Diff(path, repository.get());
 }
@@ -32,17 +32,30 @@ public:
         std::vector<std::pair<int, int> > modified;
         std::vector<int> removed;
       };
+      ///Line numbers start at 0. A side without lines starts at the number of lines before the hunk on that side.
+      class Hunk {
+      public:
+        int old_start, old_lines, new_start, new_lines;
+      };
     private:
       friend class Repository;
       Diff(const boost::filesystem::path &path, git_repository *repository);
       git_repository *repository;
       std::shared_ptr<git_blob> blob;
+      ///Byte offsets of the lines of blob
+      std::vector<size_t> blob_line_offsets;
       git_diff_options options;
       static int hunk_cb(const git_diff_delta *delta, const git_diff_hunk *hunk, void *payload) noexcept;
       static int line_cb(const git_diff_delta *delta, const git_diff_hunk *hunk, const git_diff_line *line, void *payload) noexcept;
     public:
       Diff() : repository(nullptr), blob(nullptr) {}
       Lines get_lines(const std::string &buffer);
+      std::vector<Hunk> get_hunks(const std::string &buffer);
+      ///Returns the hunks of buffer given the hunks of a previous buffer, where the lines [start_line, previous_end_line)
+      ///of the previous buffer were replaced by the lines [start_line, end_line) of buffer.
+      ///Only these lines and the hunks they touch are diffed again.
+      std::vector<Hunk> get_hunks(const std::string &buffer, const std::vector<Hunk> &hunks, int start_line, int previous_end_line, int end_line);
+      static Lines get_lines(const std::vector<Hunk> &hunks);
       std::string get_details(const std::string &buffer, int line_nr);
     };
     
@@ -75,7 +88,11 @@ public:
     
     boost::filesystem::path get_work_path() noexcept;
     boost::filesystem::path get_path() noexcept;
+    ///Returns the id of the commit at HEAD, or empty string if there are no commits
+    std::string get_head_commit() noexcept;
     static boost::filesystem::path get_root_path(const boost::filesystem::path &path);
+    ///Returns true if path, in the work path, is ignored by .gitignore
+    bool is_ignored(const boost::filesystem::path &path) noexcept;
     
     Diff get_diff(const boost::filesystem::path &path);
     
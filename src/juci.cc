@@ -4,10 +4,28 @@
 #include "directories.h"
 #include "menu.h"
 #include "config.h"
+#include "terminal.h"
+#include "trace.h"
+#include "watchdog.h"
+
+namespace sigc {
+#ifndef SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
+  template <typename Functor>
+  struct functor_trait<Functor, false> {
+    typedef decltype (::sigc::mem_fun(std::declval<Functor&>(),
+                                      &Functor::operator())) _intermediate;
+    typedef typename _intermediate::result_type result_type;
+    typedef Functor functor_type;
+  };
+#else
+  SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
+#endif
+}
 
 int Application::on_command_line(const Glib::RefPtr<Gio::ApplicationCommandLine> &cmd) {
   Glib::set_prgname("juci");
   Glib::OptionContext ctx("[PATH ...]");
+  ctx.set_description("--profile-startup: write a Chrome trace of the startup to the juCi++ home folder");
   Glib::OptionGroup gtk_group(gtk_get_option_group(true));
   ctx.add_group(gtk_group);
   int argc;
@@ -41,10 +59,25 @@ int Application::on_command_line(const Glib::RefPtr<Gio::ApplicationCommandLine>
 }
 
 void Application::on_activate() {
-  add_window(Window::get());
-  Window::get().show();
+  if(Trace::enabled) {
+    //Traced until the window is drawn the first time, which also keeps the startup trace from ending before that
+    auto first_paint_scope=std::make_shared<std::unique_ptr<Trace::Scope> >(new Trace::Scope("First paint"));
+    auto connection=std::make_shared<sigc::connection>();
+    *connection=Window::get().signal_draw().connect([first_paint_scope, connection](const Cairo::RefPtr<Cairo::Context> &) {
+      *first_paint_scope=nullptr;
+      connection->disconnect();
+      return false;
+    }, true);
+  }
+  {
+    TRACE_SCOPE("Window");
+    add_window(Window::get());
+    Window::get().show();
+  }
+  Watchdog::get().start(std::chrono::milliseconds(Config::get().window.stall_log_threshold), Config::get().juci_home_path()/"stalls.log");
   
   std::string last_current_file;
+  std::unordered_map<std::string, std::pair<int, int> > session_cursors;
   
   if(directories.empty() && files.empty()) {
     try {
@@ -56,8 +89,10 @@ void Application::on_activate() {
       for(auto &pt_file: pt.get_child("files")) {
         auto notebook=pt_file.second.get<size_t>("notebook", -1);
         auto file=pt_file.second.get<std::string>("file", "");
-        if(!file.empty() && boost::filesystem::exists(file) && !boost::filesystem::is_directory(file))
+        if(!file.empty() && boost::filesystem::exists(file) && !boost::filesystem::is_directory(file)) {
           files.emplace_back(file, notebook);
+          session_cursors[file]={pt_file.second.get<int>("line", 0), pt_file.second.get<int>("line_offset", 0)};
+        }
       }
       last_current_file=pt.get<std::string>("current_file");
       if(!boost::filesystem::exists(last_current_file) || boost::filesystem::is_directory(last_current_file))
@@ -69,6 +104,7 @@ void Application::on_activate() {
   bool first_directory=true;
   for(auto &directory: directories) {
     if(first_directory) {
+      TRACE_SCOPE("Directories::open");
       Directories::get().open(directory);
       first_directory=false;
     }
@@ -90,20 +126,57 @@ void Application::on_activate() {
     }
   }
   
-  for(auto &file: files)
-    Notebook::get().open(file.first, file.second);
+  //Only the current file of the last session is opened, the other files are opened when their tabs are selected
+  std::unique_ptr<Trace::Scope> trace_scope(Trace::enabled?new Trace::Scope("Restore session"):nullptr);
+  for(auto &file: files) {
+    auto it=session_cursors.find(file.first.string());
+    if(it==session_cursors.end())
+      Notebook::get().open(file.first, file.second);
+    else if(file.first==last_current_file) {
+      Notebook::get().open(file.first, file.second);
+      if(auto view=Notebook::get().get_current_view()) {
+        view->place_cursor_at_line_offset(it->second.first, it->second.second);
+        view->scroll_to_cursor_delayed(view, true, false);
+      }
+    }
+    else
+      Notebook::get().open_placeholder(file.first, file.second, it->second.first, it->second.second);
+  }
   
   for(auto &error: errors)
     Terminal::get().print(error, true);
   
   if(!last_current_file.empty())
     Notebook::get().open(last_current_file);
+  trace_scope=nullptr;
+  
+  if(Trace::enabled) {
+    //The startup is considered finished when no scopes, for instance parsing, have been active for a second
+    auto start_time=std::chrono::steady_clock::now();
+    Glib::signal_timeout().connect([start_time] {
+      auto now=std::chrono::steady_clock::now();
+      if((Trace::active_scopes>0 || now-Trace::get_last_event_time()<std::chrono::seconds(1)) && now-start_time<std::chrono::seconds(60))
+        return true;
+      Trace::enabled=false;
+      auto trace_path=Config::get().juci_home_path()/"startup_trace.json";
+      if(Trace::write(trace_path)) {
+        Terminal::get().print("Startup profile (open "+trace_path.string()+" in chrome://tracing):\n", true);
+        Terminal::get().print(Trace::get_summary(20));
+      }
+      else
+        Terminal::get().print("Error: could not write "+trace_path.string()+"\n", true);
+      return false;
+    }, 200);
+  }
 }
 
 void Application::on_startup() {
   Gtk::Application::on_startup();
   
-  Menu::get().build();
+  {
+    TRACE_SCOPE("Menu::build");
+    Menu::get().build();
+  }
 
   if (!Menu::get().juci_menu || !Menu::get().window_menu) {
     std::cerr << "Menu not found." << std::endl;
@@ -122,5 +195,17 @@ Application::Application() : Gtk::Application("no.sout.juci", Gio::APPLICATION_N
 }
 
 int main(int argc, char *argv[]) {
-  return Application().run(argc, argv);
+  //Parsed here since Application::on_startup is run before Application::on_command_line
+  for(int c=1;c<argc;++c) {
+    if(std::string(argv[c])=="--profile-startup") {
+      Trace::enabled=true;
+      for(;c<argc-1;++c)
+        argv[c]=argv[c+1];
+      --argc;
+      break;
+    }
+  }
+  auto exit_status=Application().run(argc, argv);
+  Watchdog::get().stop();
+  return exit_status;
 }
@@ -0,0 +1,168 @@
+#include "memoryview.h"
+#include <sstream>
+#include <iomanip>
+#include <limits>
+
+MemoryView::MemoryView() {
+  set_title("Memory");
+  set_default_size(720, 600);
+  
+  text_view.set_editable(false);
+  text_view.override_font(Pango::FontDescription("monospace"));
+  auto buffer=text_view.get_buffer();
+  buffer->create_tag("address")->property_weight()=Pango::WEIGHT_BOLD;
+  top_mark=buffer->create_mark(buffer->begin(), false);
+  
+  scrolled_window.add(text_view);
+  add(scrolled_window);
+  
+  scrolled_window.get_vadjustment()->signal_value_changed().connect([this] {
+    on_scroll();
+  });
+}
+
+void MemoryView::show_address(uint64_t address, uint64_t page_size, ReadPage read_page) {
+  this->address=address;
+  this->page_size=page_size;
+  this->read_page=std::move(read_page);
+  
+  std::stringstream ss;
+  ss << "Memory - 0x" << std::hex << address;
+  set_title(ss.str());
+  
+  updating=true;
+  text_view.get_buffer()->set_text("");
+  start_page=end_page=address-address%page_size;
+  append_page();
+  prepend_page();
+  append_page();
+  updating=false;
+  
+  highlight_address();
+  auto buffer=text_view.get_buffer();
+  auto iter=buffer->get_iter_at_line((address-start_page)/bytes_per_line);
+  buffer->place_cursor(iter);
+  buffer->move_mark(top_mark, iter);
+  text_view.scroll_to(top_mark, 0.0, 0.0, 0.3);
+  
+  show_all();
+  present();
+}
+
+void MemoryView::refresh() {
+  if(page_size==0)
+    return;
+  auto buffer=text_view.get_buffer();
+  Gtk::TextIter top_iter;
+  int line_top;
+  text_view.get_line_at_y(top_iter, scrolled_window.get_vadjustment()->get_value(), line_top);
+  auto top_line=top_iter.get_line();
+  
+  updating=true;
+  std::string text;
+  for(auto page_address=start_page;page_address!=end_page;page_address+=page_size)
+    text+=get_page_text(page_address);
+  buffer->set_text(text);
+  updating=false;
+  
+  highlight_address();
+  buffer->move_mark(top_mark, buffer->get_iter_at_line(top_line));
+  text_view.scroll_to(top_mark, 0.0, 0.0, 0.0);
+}
+
+std::string MemoryView::get_page_text(uint64_t page_address) {
+  static const char hex_digits[]="0123456789abcdef";
+  auto page=read_page?read_page(page_address):nullptr;
+  std::string text;
+  text.reserve((page_size/bytes_per_line)*(20+bytes_per_line*4));
+  for(uint64_t line=0;line<page_size;line+=bytes_per_line) {
+    auto line_address=page_address+line;
+    for(int shift=60;shift>=0;shift-=4)
+      text+=hex_digits[(line_address>>shift)&0xf];
+    text+="  ";
+    std::string chars;
+    for(uint64_t c=0;c<bytes_per_line;++c) {
+      if(page && line+c<page->size()) {
+        auto byte=(*page)[line+c];
+        text+=hex_digits[byte>>4];
+        text+=hex_digits[byte&0xf];
+        chars+=(byte>=32 && byte<127)?static_cast<char>(byte):'.';
+      }
+      else {
+        text+="??";
+        chars+=' ';
+      }
+      text+=' ';
+      if(c==bytes_per_line/2-1)
+        text+=' ';
+    }
+    text+=' '+chars+'\n';
+  }
+  return text;
+}
+
+void MemoryView::prepend_page() {
+  if(start_page<page_size)
+    return;
+  auto buffer=text_view.get_buffer();
+  Gtk::TextIter top_iter;
+  int line_top;
+  text_view.get_line_at_y(top_iter, scrolled_window.get_vadjustment()->get_value(), line_top);
+  buffer->move_mark(top_mark, top_iter);
+  
+  start_page-=page_size;
+  buffer->insert(buffer->begin(), get_page_text(start_page));
+  if(end_page-start_page>maximum_pages*page_size) {
+    end_page-=page_size;
+    buffer->erase(buffer->get_iter_at_line((end_page-start_page)/bytes_per_line), buffer->end());
+  }
+  
+  text_view.scroll_to(top_mark, 0.0, 0.0, 0.0);
+}
+
+void MemoryView::append_page() {
+  if(end_page>std::numeric_limits<uint64_t>::max()-page_size)
+    return;
+  auto buffer=text_view.get_buffer();
+  Gtk::TextIter top_iter;
+  int line_top;
+  text_view.get_line_at_y(top_iter, scrolled_window.get_vadjustment()->get_value(), line_top);
+  buffer->move_mark(top_mark, top_iter);
+  
+  buffer->insert(buffer->end(), get_page_text(end_page));
+  end_page+=page_size;
+  if(end_page-start_page>maximum_pages*page_size) {
+    start_page+=page_size;
+    buffer->erase(buffer->begin(), buffer->get_iter_at_line(page_size/bytes_per_line));
+    text_view.scroll_to(top_mark, 0.0, 0.0, 0.0);
+  }
+}
+
+void MemoryView::on_scroll() {
+  if(updating || page_size==0)
+    return;
+  auto adjustment=scrolled_window.get_vadjustment();
+  updating=true;
+  if(adjustment->get_value()<adjustment->get_page_size())
+    prepend_page();
+  else if(adjustment->get_value()+2*adjustment->get_page_size()>adjustment->get_upper())
+    append_page();
+  updating=false;
+}
+
+void MemoryView::highlight_address() {
+  auto buffer=text_view.get_buffer();
+  buffer->remove_tag_by_name("address", buffer->begin(), buffer->end());
+  if(address<start_page || address>=end_page)
+    return;
+  auto line=(address-start_page)/bytes_per_line;
+  auto iter=buffer->get_iter_at_line(line);
+  auto column=18+3*(address%bytes_per_line);
+  if(address%bytes_per_line>=bytes_per_line/2)
+    ++column;
+  auto start=buffer->get_iter_at_line_offset(line, column);
+  auto end=start;
+  end.forward_chars(2);
+  buffer->apply_tag_by_name("address", iter, buffer->get_iter_at_line_offset(line, 16));
+  buffer->apply_tag_by_name("address", start, end);
+}
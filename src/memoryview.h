@@ -0,0 +1,51 @@
+#ifndef JUCI_MEMORYVIEW_H_
+#define JUCI_MEMORYVIEW_H_
+
+#include <gtkmm.h>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+///Hex view of memory that is read one page at a time as the pages are scrolled into view
+class MemoryView : public Gtk::Window {
+  MemoryView();
+public:
+  static MemoryView &get() {
+    static MemoryView singleton;
+    return singleton;
+  }
+  
+  ///Returns the page at page_address, or nullptr if the page could not be read
+  typedef std::function<std::shared_ptr<const std::vector<unsigned char> >(uint64_t page_address)> ReadPage;
+  
+  ///Shows the pages around address. Other pages are read when scrolled to.
+  void show_address(uint64_t address, uint64_t page_size, ReadPage read_page);
+  ///Reads the shown pages again, for instance after the debugged process has stopped
+  void refresh();
+  
+  static const uint64_t bytes_per_line=16;
+  ///Pages are removed from the other end when more pages than this are shown
+  static const size_t maximum_pages=32;
+
+private:
+  Gtk::ScrolledWindow scrolled_window;
+  Gtk::TextView text_view;
+  ///Used to keep the same memory in view when lines are added or removed above it
+  Glib::RefPtr<Gtk::TextMark> top_mark;
+  
+  ReadPage read_page;
+  uint64_t page_size=0;
+  uint64_t address=0;
+  ///The shown pages are [start_page, end_page)
+  uint64_t start_page=0, end_page=0;
+  bool updating=false;
+  
+  std::string get_page_text(uint64_t page_address);
+  void prepend_page();
+  void append_page();
+  void on_scroll();
+  void highlight_address();
+};
+
+#endif // JUCI_MEMORYVIEW_H_
@@ -1,5 +1,6 @@
 #include "menu.h"
 #include "config.h"
+#include "watchdog.h"
 #include <string>
 #include <iostream>
 
@@ -226,6 +227,22 @@ Menu::Menu() {
           <attribute name='label' translatable='yes'>_Apply Fix-Its</attribute>
           <attribute name='action'>app.source_apply_fix_its</attribute>
         </item>
+        <item>
+          <attribute name='label' translatable='yes'>_Toggle _Optimization _Remarks</attribute>
+          <attribute name='action'>app.source_toggle_optimization_remarks</attribute>
+        </item>
+        <item>
+          <attribute name='label' translatable='yes'>_Toggle _Assembly</attribute>
+          <attribute name='action'>app.source_toggle_assembly</attribute>
+        </item>
+        <item>
+          <attribute name='label' translatable='yes'>_Show _Record _Layout</attribute>
+          <attribute name='action'>app.source_show_record_layout</attribute>
+        </item>
+        <item>
+          <attribute name='label' translatable='yes'>_Show _Record _Layouts _Report</attribute>
+          <attribute name='action'>app.source_show_record_layouts_report</attribute>
+        </item>
       </section>
     </submenu>
 
@@ -248,6 +265,14 @@ Menu::Menu() {
           <attribute name='label' translatable='yes'>_Recreate _Build</attribute>
           <attribute name='action'>app.project_recreate_build</attribute>
         </item>
+        <item>
+          <attribute name='label' translatable='yes'>_Run _Benchmarks</attribute>
+          <attribute name='action'>app.project_run_benchmarks</attribute>
+        </item>
+        <item>
+          <attribute name='label' translatable='yes'>_Toggle _Benchmark _Baseline</attribute>
+          <attribute name='action'>app.project_toggle_benchmark_baseline</attribute>
+        </item>
       </section>
       <section>
         <item>
@@ -276,6 +301,10 @@ Menu::Menu() {
           <attribute name='label' translatable='yes'>_Start/_Continue</attribute>
           <attribute name='action'>app.debug_start_continue</attribute>
         </item>
+        <item>
+          <attribute name='label' translatable='yes'>_Profile</attribute>
+          <attribute name='action'>app.debug_profile</attribute>
+        </item>
         <item>
           <attribute name='label' translatable='yes'>_Stop</attribute>
           <attribute name='action'>app.debug_stop</attribute>
@@ -308,6 +337,10 @@ Menu::Menu() {
           <attribute name='label' translatable='yes'>_Show _Variables</attribute>
           <attribute name='action'>app.debug_show_variables</attribute>
         </item>
+        <item>
+          <attribute name='label' translatable='yes'>_Show _Memory</attribute>
+          <attribute name='action'>app.debug_show_memory</attribute>
+        </item>
       </section>
       <section>
         <item>
@@ -357,6 +390,16 @@ Menu::Menu() {
           <attribute name='action'>app.window_clear_terminal</attribute>
         </item>
       </section>
+      <section>
+        <item>
+          <attribute name='label' translatable='yes'>_Toggle _Tracing</attribute>
+          <attribute name='action'>app.window_toggle_tracing</attribute>
+        </item>
+        <item>
+          <attribute name='label' translatable='yes'>_Toggle _Performance _HUD</attribute>
+          <attribute name='action'>app.window_toggle_performance_hud</attribute>
+        </item>
+      </section>
     </submenu>
   </menu>
 </interface>
@@ -368,7 +411,11 @@ void Menu::add_action(const std::string &name, std::function<void()> action) {
   auto gio_application=Glib::wrap(g_application, true);
   auto application=Glib::RefPtr<Gtk::Application>::cast_static(gio_application);
   
-  actions[name]=application->add_action(name, action);
+  //The task name is kept in the action, since it must be valid until the watchdog is stopped
+  actions[name]=application->add_action(name, [task_name="menu action "+name, action] {
+    Watchdog::Task task(task_name.c_str());
+    action();
+  });
 }
 
 void Menu::set_keys() {
@@ -5,6 +5,7 @@
 #include <regex>
 #include "project.h"
 #include "filesystem.h"
+#include "trace.h"
 
 #if GTKSOURCEVIEWMM_MAJOR_VERSION > 2 & GTKSOURCEVIEWMM_MINOR_VERSION > 17
 #include "gtksourceview-3.0/gtksourceview/gtksourcemap.h"
@@ -118,13 +119,14 @@ Source::View* Notebook::get_current_view() {
   //In case there exist a tab that has not yet received focus again in a different notebook
   for(int notebook_index=0;notebook_index<2;++notebook_index) {
     auto page=notebooks[notebook_index].get_current_page();
-    if(page>=0)
-      return get_view(notebook_index, page);
+    if(auto view=get_view(notebook_index, page))
+      return view;
   }
   return nullptr;
 }
 
 std::vector<Source::View*> &Notebook::get_views() {
+  open_placeholders();
   return source_views;
 }
 
@@ -140,6 +142,12 @@ void Notebook::open(const boost::filesystem::path &file_path, size_t notebook_in
       return;
     }
   }
+  for(auto it=placeholders.begin();it!=placeholders.end();++it) {
+    if(file_path==it->file_path) {
+      open(it);
+      return;
+    }
+  }
   
   if(boost::filesystem::exists(file_path)) {
     std::ifstream can_read(file_path.string());
@@ -152,6 +160,7 @@ void Notebook::open(const boost::filesystem::path &file_path, size_t notebook_in
   
   auto last_view=get_current_view();
   
+  TRACE_SCOPE("Notebook::open", file_path.filename().string());
   auto language=Source::guess_language(file_path);
   if(language && (language->get_id()=="chdr" || language->get_id()=="cpphdr" || language->get_id()=="c" || language->get_id()=="cpp" || language->get_id()=="objc"))
     source_views.emplace_back(new Source::ClangView(file_path, language));
@@ -272,6 +281,93 @@ void Notebook::open(const boost::filesystem::path &file_path, size_t notebook_in
   focus_view(source_view);
 }
 
+void Notebook::open_placeholder(const boost::filesystem::path &file_path, size_t notebook_index, int line, int line_offset) {
+  if(notebook_index==1 && !split)
+    toggle_split();
+  if(notebook_index>=notebooks.size())
+    notebook_index=0;
+  
+  placeholders.emplace_back();
+  auto placeholder=std::prev(placeholders.end());
+  placeholder->file_path=file_path;
+  placeholder->line=line;
+  placeholder->line_offset=line_offset;
+  placeholder->hbox=std::make_unique<Gtk::HBox>();
+  auto hbox=placeholder->hbox.get();
+  placeholder->tab_label=std::make_unique<TabLabel>(file_path, [this, hbox]() {
+    for(auto it=placeholders.begin();it!=placeholders.end();++it) {
+      if(it->hbox.get()==hbox) {
+        for(auto &notebook: notebooks) {
+          auto page=notebook.page_num(*hbox);
+          if(page>=0)
+            notebook.remove_page(page);
+        }
+        placeholders.erase(it);
+        break;
+      }
+    }
+  });
+  
+  //Open the file when the tab is shown, after the page switch is finished
+  placeholder->hbox->signal_map().connect([this, hbox] {
+    Glib::signal_idle().connect([this, hbox] {
+      for(auto it=placeholders.begin();it!=placeholders.end();++it) {
+        if(it->hbox.get()==hbox) {
+          if(hbox->get_mapped())
+            open(it);
+          break;
+        }
+      }
+      return false;
+    });
+  });
+  
+  notebooks[notebook_index].append_page(*placeholder->hbox, *placeholder->tab_label);
+  notebooks[notebook_index].set_tab_reorderable(*placeholder->hbox, true);
+  placeholder->hbox->show();
+}
+
+void Notebook::open(std::list<Placeholder>::iterator placeholder) {
+  size_t notebook_index=0;
+  int page=-1;
+  for(size_t c=0;c<notebooks.size();++c) {
+    page=notebooks[c].page_num(*placeholder->hbox);
+    if(page>=0) {
+      notebook_index=c;
+      break;
+    }
+  }
+  auto file_path=placeholder->file_path;
+  auto line=placeholder->line;
+  auto line_offset=placeholder->line_offset;
+  
+  if(page>=0)
+    notebooks[notebook_index].remove_page(page);
+  placeholders.erase(placeholder);
+  
+  open(file_path, notebook_index);
+  auto view=get_current_view();
+  if(view && view->file_path==file_path) {
+    if(page>=0)
+      notebooks[notebook_index].reorder_child(*hboxes[get_index(view)], page);
+    view->place_cursor_at_line_offset(line, line_offset);
+    view->scroll_to_cursor_delayed(view, true, false);
+  }
+}
+
+void Notebook::open_placeholders() {
+  if(placeholders.empty())
+    return;
+  auto current_view=get_current_view();
+  while(!placeholders.empty())
+    open(placeholders.begin());
+  if(current_view) {
+    auto notebook_page=get_notebook_page(get_index(current_view));
+    notebooks[notebook_page.first].set_current_page(notebook_page.second);
+    focus_view(current_view);
+  }
+}
+
 void Notebook::configure(size_t index) {
 #if GTKSOURCEVIEWMM_MAJOR_VERSION > 2 & GTKSOURCEVIEWMM_MINOR_VERSION > 17
   auto source_font_description=Pango::FontDescription(Config::get().source.font);
@@ -305,10 +401,24 @@ void Notebook::save_session() {
     pt_root.put("folder", Directories::get().path.string());
     for(size_t notebook_index=0;notebook_index<notebooks.size();++notebook_index) {
       for(int page=0;page<notebooks[notebook_index].get_n_pages();++page) {
-        auto view=get_view(notebook_index, page);
         boost::property_tree::ptree pt_child;
         pt_child.put("notebook", notebook_index);
-        pt_child.put("file", view->file_path.string());
+        if(auto view=get_view(notebook_index, page)) {
+          auto iter=view->get_buffer()->get_insert()->get_iter();
+          pt_child.put("file", view->file_path.string());
+          pt_child.put("line", iter.get_line());
+          pt_child.put("line_offset", iter.get_line_offset());
+        }
+        else {
+          for(auto &placeholder: placeholders) {
+            if(placeholder.hbox.get()==notebooks[notebook_index].get_nth_page(page)) {
+              pt_child.put("file", placeholder.file_path.string());
+              pt_child.put("line", placeholder.line);
+              pt_child.put("line_offset", placeholder.line_offset);
+              break;
+            }
+          }
+        }
         pt_files.push_back(std::make_pair("", pt_child));
       }
     }
@@ -420,6 +530,15 @@ void Notebook::toggle_split() {
       if(notebook_index==1 && !close(c))
         return;
     }
+    for(auto it=placeholders.begin();it!=placeholders.end();) {
+      auto page=notebooks[1].page_num(*it->hbox);
+      if(page>=0) {
+        notebooks[1].remove_page(page);
+        it=placeholders.erase(it);
+      }
+      else
+        ++it;
+    }
     remove(notebooks[1]);
   }
   split=!split;
@@ -447,11 +566,15 @@ Source::View *Notebook::get_view(size_t notebook_index, int page) {
      page<0 || page>=notebooks[notebook_index].get_n_pages())
     return nullptr;
   auto hbox=dynamic_cast<Gtk::HBox*>(notebooks[notebook_index].get_nth_page(page));
+  if(hbox->get_children().empty()) //Placeholder
+    return nullptr;
   auto scrolled_window=dynamic_cast<Gtk::ScrolledWindow*>(hbox->get_children()[0]);
   return dynamic_cast<Source::View*>(scrolled_window->get_children()[0]);
 }
 
 void Notebook::focus_view(Source::View *view) {
+  if(!view)
+    return;
   intermediate_view=view;
   view->grab_focus();
 }
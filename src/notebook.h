@@ -7,6 +7,7 @@
 #include "source_clang.h"
 #include <type_traits>
 #include <map>
+#include <list>
 #include <sigc++/sigc++.h>
 
 class Notebook : public Gtk::HPaned {
@@ -16,6 +17,16 @@ class Notebook : public Gtk::HPaned {
     Gtk::Label label;
   };
   
+  ///Tab of a file that is not yet opened, used when restoring a session
+  class Placeholder {
+  public:
+    boost::filesystem::path file_path;
+    int line;
+    int line_offset;
+    std::unique_ptr<Gtk::HBox> hbox;
+    std::unique_ptr<TabLabel> tab_label;
+  };
+  
 private:
   Notebook();
 public:
@@ -31,6 +42,8 @@ public:
   std::vector<Source::View*> &get_views();
   
   void open(const boost::filesystem::path &file_path, size_t notebook_index=-1);
+  ///Adds a tab for file_path that is opened when the tab is selected, or when all the views are needed through get_views()
+  void open_placeholder(const boost::filesystem::path &file_path, size_t notebook_index, int line, int line_offset);
   void configure(size_t index);
   bool save(size_t index);
   bool save_current();
@@ -60,6 +73,10 @@ private:
   std::vector<std::unique_ptr<Gtk::HBox> > hboxes;
   std::vector<std::unique_ptr<TabLabel> > tab_labels;
   
+  std::list<Placeholder> placeholders;
+  void open(std::list<Placeholder>::iterator placeholder);
+  void open_placeholders();
+  
   bool split=false;
   size_t last_index=-1;
   
@@ -0,0 +1,143 @@
+#include "performance_hud.h"
+#include "notebook.h"
+#include "terminal.h"
+#include "dispatcher.h"
+#include <sstream>
+#include <iomanip>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+  std::string duration_to_string(std::chrono::steady_clock::duration duration, size_t count) {
+    if(count==0)
+      return "-";
+    return std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count())+" ms";
+  }
+  
+  std::string memory_to_string(size_t bytes) {
+    if(bytes==0)
+      return "-";
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1) << bytes/(1024.0*1024.0) << " MB";
+    return ss.str();
+  }
+}
+
+PerformanceHud::PerformanceHud() : popover(*this) {
+  set_no_show_all(true);
+  set_tooltip_text("Click to show all views");
+  add(label);
+  label.show();
+  
+  grid.set_column_spacing(15);
+  grid.set_row_spacing(3);
+  grid.property_margin()=8;
+  popover.add(grid);
+  popover.set_position(Gtk::PositionType::POS_TOP);
+}
+
+void PerformanceHud::toggle() {
+  if(update_connection.connected()) {
+    update_connection.disconnect();
+    popover.hide();
+    hide();
+    return;
+  }
+  last_update_time=std::chrono::steady_clock::now();
+  last_cpu_time=get_cpu_time();
+  update();
+  show();
+  update_connection=Glib::signal_timeout().connect([this] {
+    update();
+    return true;
+  }, 250);
+}
+
+bool PerformanceHud::on_button_press_event(GdkEventButton *event) {
+  if(event->button==GDK_BUTTON_PRIMARY) {
+    if(popover.get_visible())
+      popover.hide();
+    else
+      show_views();
+    return true;
+  }
+  return Gtk::EventBox::on_button_press_event(event);
+}
+
+void PerformanceHud::update() {
+  auto now=std::chrono::steady_clock::now();
+  auto cpu_time=get_cpu_time();
+  auto seconds=std::chrono::duration<double>(now-last_update_time).count();
+  auto cpu=seconds>0.0?100.0*(cpu_time-last_cpu_time)/seconds:0.0;
+  last_update_time=now;
+  last_cpu_time=cpu_time;
+  
+  std::stringstream ss;
+  if(auto view=Notebook::get().get_current_view()) {
+    ss << "parse: " << duration_to_string(view->performance.parse_duration, view->performance.parses)
+       << "  completion: " << duration_to_string(view->performance.completion_latency, view->performance.completions);
+    if(view->get_translation_unit_memory)
+      ss << "  TU: " << memory_to_string(view->get_translation_unit_memory());
+    ss << "  ";
+  }
+  ss << "dispatcher: " << Dispatcher::pending << "  jobs: " << Terminal::get().get_background_job_count()
+     << "  CPU: " << std::fixed << std::setprecision(0) << cpu << "%  ";
+  if(label.get_text()!=ss.str())
+    label.set_text(ss.str());
+  
+  if(popover.get_visible())
+    show_views();
+}
+
+void PerformanceHud::show_views() {
+  for(auto widget: grid.get_children())
+    grid.remove(*widget);
+  
+  auto add_label=[this](const std::string &text, int column, int row) {
+    auto label=Gtk::manage(new Gtk::Label());
+    if(row==0)
+      label->set_markup("<b>"+Glib::Markup::escape_text(text)+"</b>");
+    else
+      label->set_text(text);
+    label->set_halign(column==0?Gtk::Align::ALIGN_START:Gtk::Align::ALIGN_END);
+    grid.attach(*label, column, row, 1, 1);
+  };
+  
+  int column=0;
+  for(auto &header: {"File", "Parses", "Last parse", "Completions", "Last completion", "TU memory"})
+    add_label(header, column++, 0);
+  for(size_t c=0;c<Notebook::get().size();++c) {
+    auto view=Notebook::get().get_view(c);
+    auto &performance=view->performance;
+    auto row=static_cast<int>(c+1);
+    add_label(view->file_path.filename().string(), 0, row);
+    add_label(std::to_string(performance.parses), 1, row);
+    add_label(duration_to_string(performance.parse_duration, performance.parses), 2, row);
+    add_label(std::to_string(performance.completions), 3, row);
+    add_label(duration_to_string(performance.completion_latency, performance.completions), 4, row);
+    add_label(view->get_translation_unit_memory?memory_to_string(view->get_translation_unit_memory()):"-", 5, row);
+  }
+  grid.show_all();
+  popover.show();
+}
+
+double PerformanceHud::get_cpu_time() {
+#ifdef _WIN32
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if(!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time))
+    return 0.0;
+  //FILETIME is in 100 nanosecond intervals
+  auto to_seconds=[](const FILETIME &time) {
+    return ((static_cast<unsigned long long>(time.dwHighDateTime)<<32)|time.dwLowDateTime)/1.0e7;
+  };
+  return to_seconds(kernel_time)+to_seconds(user_time);
+#else
+  rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage)!=0)
+    return 0.0;
+  return usage.ru_utime.tv_sec+usage.ru_utime.tv_usec/1.0e6+usage.ru_stime.tv_sec+usage.ru_stime.tv_usec/1.0e6;
+#endif
+}
@@ -0,0 +1,36 @@
+#ifndef JUCI_PERFORMANCE_HUD_H_
+#define JUCI_PERFORMANCE_HUD_H_
+
+#include <gtkmm.h>
+#include <chrono>
+
+///Status bar label with performance measurements of the current view, updated a few times per second while shown.
+///Clicking the label shows the measurements of every open view.
+class PerformanceHud : public Gtk::EventBox {
+  PerformanceHud();
+public:
+  static PerformanceHud &get() {
+    static PerformanceHud singleton;
+    return singleton;
+  }
+  
+  void toggle();
+
+protected:
+  bool on_button_press_event(GdkEventButton *event) override;
+private:
+  void update();
+  void show_views();
+  ///Returns the user and system time of the process in seconds
+  static double get_cpu_time();
+  
+  Gtk::Label label;
+  Gtk::Popover popover;
+  Gtk::Grid grid;
+  sigc::connection update_connection;
+  
+  std::chrono::steady_clock::time_point last_update_time;
+  double last_cpu_time;
+};
+
+#endif // JUCI_PERFORMANCE_HUD_H_
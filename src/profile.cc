@@ -0,0 +1,160 @@
+#include "profile.h"
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <iomanip>
+#include <tuple>
+
+void Profile::add_backtrace(const std::vector<Frame> &backtrace) {
+  if(backtrace.empty())
+    return;
+  ++samples;
+  
+  std::string stack;
+  for(auto it=backtrace.rbegin();it!=backtrace.rend();++it) {
+    if(!stack.empty())
+      stack+=';';
+    auto function_name=it->function_name.empty()?std::string("??"):it->function_name;
+    std::replace(function_name.begin(), function_name.end(), ';', ':');
+    stack+=function_name;
+  }
+  ++stacks[stack];
+  
+  //Lines of recursive calls are only counted once per sample
+  std::set<std::pair<std::string, int> > counted_lines;
+  bool self=true;
+  for(auto &frame: backtrace) {
+    if(frame.file_path.empty() || frame.line_nr<=0)
+      continue;
+    auto &line_samples=lines[frame.file_path.string()][frame.line_nr];
+    if(self) {
+      ++line_samples.self;
+      self=false;
+    }
+    if(counted_lines.emplace(frame.file_path.string(), frame.line_nr).second)
+      ++line_samples.total;
+  }
+}
+
+std::string Profile::get_summary(size_t max_lines) const {
+  std::stringstream ss;
+  auto duration_ms=std::chrono::duration_cast<std::chrono::microseconds>(duration).count()/1000.0;
+  auto overhead_ms=std::chrono::duration_cast<std::chrono::microseconds>(overhead).count()/1000.0;
+  ss << std::fixed << std::setprecision(1) << samples << " samples in " << duration_ms/1000.0 << " s, sampling overhead: " << overhead_ms << " ms";
+  if(duration_ms>0.0)
+    ss << " (" << 100.0*overhead_ms/duration_ms << "%)";
+  ss << '\n';
+  
+  std::vector<std::tuple<size_t, size_t, const std::string*, int> > hot_lines;
+  for(auto &file: lines) {
+    for(auto &line: file.second)
+      hot_lines.emplace_back(line.second.self, line.second.total, &file.first, line.first);
+  }
+  std::sort(hot_lines.begin(), hot_lines.end(), [](const std::tuple<size_t, size_t, const std::string*, int> &lhs,
+                                                   const std::tuple<size_t, size_t, const std::string*, int> &rhs) {
+    if(std::get<0>(lhs)!=std::get<0>(rhs))
+      return std::get<0>(lhs)>std::get<0>(rhs);
+    return std::get<1>(lhs)>std::get<1>(rhs);
+  });
+  for(size_t c=0;c<hot_lines.size() && c<max_lines;++c) {
+    ss << *std::get<2>(hot_lines[c]) << ':' << std::get<3>(hot_lines[c]) << ":1: "
+       << 100.0*std::get<0>(hot_lines[c])/samples << "% self, " << 100.0*std::get<1>(hot_lines[c])/samples << "% total\n";
+  }
+  return ss.str();
+}
+
+std::string Profile::get_flame_graph() const {
+  class Node {
+  public:
+    std::string name;
+    size_t samples=0;
+    std::map<std::string, size_t> children;
+  };
+  std::vector<Node> nodes(1);
+  nodes[0].name="all";
+  size_t max_depth=0;
+  for(auto &stack: stacks) {
+    size_t node=0;
+    size_t depth=0;
+    nodes[0].samples+=stack.second;
+    for(size_t start=0;start<=stack.first.size();) {
+      auto end=stack.first.find(';', start);
+      if(end==std::string::npos)
+        end=stack.first.size();
+      auto name=stack.first.substr(start, end-start);
+      auto it=nodes[node].children.find(name);
+      size_t child;
+      if(it!=nodes[node].children.end())
+        child=it->second;
+      else {
+        child=nodes.size();
+        nodes[node].children.emplace(name, child);
+        nodes.emplace_back();
+        nodes.back().name=std::move(name);
+      }
+      nodes[child].samples+=stack.second;
+      node=child;
+      ++depth;
+      start=end+1;
+    }
+    max_depth=std::max(max_depth, depth);
+  }
+  
+  auto escape=[](const std::string &text) {
+    std::string escaped;
+    for(auto &chr: text) {
+      if(chr=='&')
+        escaped+="&amp;";
+      else if(chr=='<')
+        escaped+="&lt;";
+      else if(chr=='>')
+        escaped+="&gt;";
+      else if(chr=='"')
+        escaped+="&quot;";
+      else
+        escaped+=chr;
+    }
+    return escaped;
+  };
+  
+  const double width=1200.0;
+  const double frame_height=16.0;
+  const double char_width=7.0;
+  double height=(max_depth+1)*frame_height+40.0;
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(1);
+  ss << "<?xml version=\"1.0\" standalone=\"no\"?>\n"
+     << "<svg version=\"1.1\" width=\"" << width << "\" height=\"" << height << "\" xmlns=\"http://www.w3.org/2000/svg\">\n"
+     << "<rect x=\"0\" y=\"0\" width=\"100%\" height=\"100%\" fill=\"#f8f8f8\"/>\n"
+     << "<text x=\"" << width/2 << "\" y=\"20\" text-anchor=\"middle\" font-family=\"sans-serif\" font-size=\"16\">Flame Graph (" << samples << " samples)</text>\n";
+  
+  std::function<void(size_t, double, size_t)> draw=[&](size_t node, double x, size_t depth) {
+    auto node_width=width*nodes[node].samples/nodes[0].samples;
+    if(node_width<0.1)
+      return;
+    auto y=height-(depth+1)*frame_height;
+    auto hash=std::hash<std::string>()(nodes[node].name);
+    auto name=escape(nodes[node].name);
+    ss << "<g><title>" << name << " (" << nodes[node].samples << " samples, " << 100.0*nodes[node].samples/nodes[0].samples << "%)</title>"
+       << "<rect x=\"" << x << "\" y=\"" << y << "\" width=\"" << node_width << "\" height=\"" << frame_height-1.0
+       << "\" fill=\"rgb(" << 205+hash%50 << ',' << (hash/50)%230 << ',' << (hash/11500)%55 << ")\" rx=\"2\"/>";
+    if(node_width>=6.0+3*char_width) {
+      size_t chars=(node_width-6.0)/char_width;
+      auto text=nodes[node].name;
+      if(text.size()>chars)
+        text=text.substr(0, chars-2)+"..";
+      ss << "<text x=\"" << x+3.0 << "\" y=\"" << y+frame_height-4.0 << "\" font-family=\"monospace\" font-size=\"12\">" << escape(text) << "</text>";
+    }
+    ss << "</g>\n";
+    for(auto &child: nodes[node].children) {
+      draw(child.second, x, depth+1);
+      x+=width*nodes[child.second].samples/nodes[0].samples;
+    }
+  };
+  if(nodes[0].samples>0)
+    draw(0, 0.0, 0);
+  
+  ss << "</svg>\n";
+  return ss.str();
+}
@@ -0,0 +1,48 @@
+#ifndef JUCI_PROFILE_H_
+#define JUCI_PROFILE_H_
+#include <boost/filesystem.hpp>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <chrono>
+
+///Backtraces sampled from a running process, counted per call stack and per source line
+class Profile {
+public:
+  class Frame {
+  public:
+    std::string function_name;
+    boost::filesystem::path file_path;
+    int line_nr;
+  };
+  class LineSamples {
+  public:
+    ///Samples where the line is in the innermost frame that has a source line
+    size_t self=0;
+    ///Samples where the line is in any frame
+    size_t total=0;
+  };
+  
+  ///Adds the backtrace of one thread, innermost frame first
+  void add_backtrace(const std::vector<Frame> &backtrace);
+  
+  ///Number of backtraces added
+  size_t samples=0;
+  ///Time from the first to the last sample
+  std::chrono::steady_clock::duration duration=std::chrono::steady_clock::duration::zero();
+  ///Time the process was stopped in order to take samples
+  std::chrono::steady_clock::duration overhead=std::chrono::steady_clock::duration::zero();
+  
+  ///Samples per call stack, with the function names separated by ';' and the outermost function first
+  std::map<std::string, size_t> stacks;
+  ///Samples per line per file path
+  std::unordered_map<std::string, std::map<int, LineSamples> > lines;
+  
+  ///Returns the sampling overhead followed by the lines with the most samples, one line per row
+  std::string get_summary(size_t max_lines) const;
+  ///Returns a flame graph of the call stacks as an SVG document
+  std::string get_flame_graph() const;
+};
+
+#endif // JUCI_PROFILE_H_
@@ -10,6 +10,12 @@
 #include "debug_lldb.h"
 #endif
 #include "info.h"
+#include "memoryview.h"
+#include "variablesview.h"
+#include "benchmark_results.h"
+#include "git.h"
+#include <sstream>
+#include <iomanip>
 
 boost::filesystem::path Project::debug_last_stop_file_path;
 std::unordered_map<std::string, std::string> Project::run_arguments;
@@ -80,6 +86,7 @@ void Project::debug_update_status(const std::string &debug_status) {
   menu.actions["debug_step_out"]->set_enabled(!debug_status.empty());
   menu.actions["debug_backtrace"]->set_enabled(!debug_status.empty());
   menu.actions["debug_show_variables"]->set_enabled(!debug_status.empty());
+  menu.actions["debug_show_memory"]->set_enabled(!debug_status.empty());
   menu.actions["debug_run_command"]->set_enabled(!debug_status.empty());
   menu.actions["debug_goto_stop"]->set_enabled(!debug_status.empty());
 }
@@ -106,6 +113,9 @@ void Project::debug_update_stop() {
       break;
     }
   }
+  
+  if(MemoryView::get().get_visible())
+    MemoryView::get().refresh();
 }
 
 std::unique_ptr<Project::Base> Project::create() {
@@ -151,6 +161,14 @@ void Project::Base::recreate_build() {
   Info::get().print("Could not find a supported project");
 }
 
+void Project::Base::run_benchmarks() {
+  Info::get().print("Could not find a supported project");
+}
+
+void Project::Base::toggle_benchmark_baseline() {
+  Info::get().print("Could not find a supported project");
+}
+
 std::pair<std::string, std::string> Project::Base::debug_get_run_arguments() {
   Info::get().print("Could not find a supported project");
   return {"", ""};
@@ -325,6 +343,120 @@ void Project::Clang::recreate_build() {
   }
 }
 
+void Project::Clang::run_benchmarks() {
+  auto default_build_path=build->get_default_path();
+  if(default_build_path.empty() || !build->update_default())
+    return;
+  
+  auto project_path=build->project_path;
+  std::vector<boost::filesystem::path> executables;
+  for(auto &executable: build->get_benchmark_executables()) {
+    auto executable_string=executable.string();
+    size_t pos=executable_string.find(project_path.string());
+    if(pos!=std::string::npos)
+      executable_string.replace(pos, project_path.string().size(), default_build_path.string());
+    executables.emplace_back(executable_string);
+  }
+  if(executables.empty()) {
+    Terminal::get().print("Warning: could not find executables that link with benchmark in "+project_path.string()+"\n");
+    return;
+  }
+  
+  if(Config::get().project.clear_terminal_on_compile)
+    Terminal::get().clear();
+  
+  compiling=true;
+  Terminal::get().print("Compiling and running benchmarks in "+project_path.string()+"\n");
+  Terminal::get().async_process(Config::get().project.make_command, default_build_path, [project_path, default_build_path, executables](int exit_status) {
+    compiling=false;
+    if(exit_status!=EXIT_SUCCESS)
+      return;
+    
+    BenchmarkResults results;
+    results.time=std::time(nullptr);
+    try {
+      results.commit=Git::get_repository(project_path)->get_head_commit();
+    }
+    catch(const std::exception &) {}
+    for(auto &executable: executables) {
+      Terminal::get().async_print("Running "+executable.string()+"\n");
+      std::string output;
+      //The repetitions give the standard deviations that are used to tell changes from noise
+      Process process(filesystem::escape_argument(executable.string())+" --benchmark_format=json --benchmark_repetitions=5 --benchmark_report_aggregates_only=true",
+                      executable.parent_path().string(), [&output](const char *bytes, size_t n) {
+        output.append(bytes, n);
+      }, [](const char *bytes, size_t n) {
+        Terminal::get().async_print(std::string(bytes, n), true);
+      });
+      if(process.get_exit_status()!=EXIT_SUCCESS || !results.add(output))
+        Terminal::get().async_print("Error: "+executable.string()+" failed\n", true);
+    }
+    
+    //Results are compared to the baseline if set, and otherwise to the previous run
+    auto runs_path=default_build_path/"benchmarks";
+    BenchmarkResults baseline;
+    std::string compared_to;
+    auto baseline_file_name=filesystem::read(runs_path/"baseline");
+    if(!baseline_file_name.empty() && baseline.load(runs_path/baseline_file_name))
+      compared_to="baseline";
+    else {
+      auto runs=BenchmarkResults::get_runs(runs_path);
+      if(!runs.empty() && baseline.load(runs.back()))
+        compared_to="previous run";
+    }
+    
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(runs_path, ec);
+    if(!results.save(runs_path/results.get_file_name()))
+      Terminal::get().async_print("Error: could not save benchmark results to "+runs_path.string()+"\n", true);
+    
+    std::unordered_set<std::string> function_names;
+    for(auto &result: results.results)
+      function_names.emplace(BenchmarkResults::get_function_name(result.name));
+    auto registrations=BenchmarkResults::find_registrations(project_path, function_names);
+    
+    if(!compared_to.empty())
+      Terminal::get().async_print("Compared to "+compared_to+" at commit "+baseline.commit.substr(0, 12)+":\n");
+    for(auto &delta: results.compare(baseline)) {
+      std::string row;
+      auto it=registrations.find(BenchmarkResults::get_function_name(delta.name));
+      if(it!=registrations.end())
+        row=it->second.first.string()+':'+std::to_string(it->second.second)+":1: ";
+      row+=delta.name+": "+BenchmarkResults::format_time(delta.new_time);
+      if(delta.old_time>=0.0) {
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(1) << std::showpos << 100.0*delta.change << '%';
+        row+=" (was "+BenchmarkResults::format_time(delta.old_time)+", "+ss.str()+")";
+        if(delta.significant)
+          row+=delta.change>0.0?" regression":" improvement";
+      }
+      Terminal::get().async_print(row+'\n', delta.significant && delta.change>0.0);
+    }
+  });
+}
+
+void Project::Clang::toggle_benchmark_baseline() {
+  auto default_build_path=build->get_default_path();
+  if(default_build_path.empty())
+    return;
+  auto runs_path=default_build_path/"benchmarks";
+  boost::system::error_code ec;
+  if(boost::filesystem::exists(runs_path/"baseline", ec)) {
+    boost::filesystem::remove(runs_path/"baseline", ec);
+    Info::get().print("Benchmarks are compared to the previous run");
+    return;
+  }
+  
+  auto runs=BenchmarkResults::get_runs(runs_path);
+  BenchmarkResults baseline;
+  if(runs.empty() || !baseline.load(runs.back())) {
+    Info::get().print("Run the benchmarks before setting a baseline");
+    return;
+  }
+  if(filesystem::write(runs_path/"baseline", runs.back().filename().string()))
+    Info::get().print("Benchmarks are compared to the run at commit "+baseline.commit.substr(0, 12));
+}
+
 #ifdef JUCI_ENABLE_DEBUG
 std::pair<std::string, std::string> Project::Clang::debug_get_run_arguments() {
   auto build_path=build->get_debug_path();
@@ -361,6 +493,14 @@ Gtk::Popover *Project::Clang::debug_get_options() {
 }
 
 void Project::Clang::debug_start() {
+  debug_start(0);
+}
+
+void Project::Clang::debug_profile() {
+  debug_start(Config::get().project.debug_profile_sampling_interval);
+}
+
+void Project::Clang::debug_start(int sampling_interval) {
   auto debug_build_path=build->get_debug_path();
   if(debug_build_path.empty() || !build->update_debug())
     return;
@@ -390,11 +530,11 @@ void Project::Clang::debug_start() {
   
   debugging=true;
   Terminal::get().print("Compiling and debugging "+*run_arguments+"\n");
-  Terminal::get().async_process(Config::get().project.make_command, debug_build_path, [this, run_arguments, project_path](int exit_status){
+  Terminal::get().async_process(Config::get().project.make_command, debug_build_path, [this, run_arguments, project_path, sampling_interval](int exit_status){
     if(exit_status!=EXIT_SUCCESS)
       debugging=false;
     else {
-      dispatcher.post([this, run_arguments, project_path] {
+      dispatcher.post("Debug start", [this, run_arguments, project_path, sampling_interval] {
         std::vector<std::pair<boost::filesystem::path, int> > breakpoints;
         for(size_t c=0;c<Notebook::get().size();c++) {
           auto view=Notebook::get().get_view(c);
@@ -411,29 +551,87 @@ void Project::Clang::debug_start() {
         auto options_it=debug_options.find(project_path->string());
         if(options_it!=debug_options.end() && options_it->second.remote_enabled.get_active())
           remote_host=options_it->second.remote_host.get_text();
-        Debug::LLDB::get().start(*run_arguments, *project_path, breakpoints, [this, run_arguments](int exit_status){
+        debug_update_profile_marks(nullptr);
+        Debug::LLDB::get().start(*run_arguments, *project_path, breakpoints, [this, run_arguments, sampling_interval](int exit_status){
           debugging=false;
           Terminal::get().async_print(*run_arguments+" returned: "+std::to_string(exit_status)+'\n');
+          if(sampling_interval>0) {
+            dispatcher.post("Debug show profile", [this] {
+              debug_show_profile();
+            });
+          }
         }, [this](const std::string &status) {
-          dispatcher.post([this, status] {
+          dispatcher.post("Debug status", [this, status] {
             debug_update_status(status);
           });
         }, [this](const boost::filesystem::path &file_path, int line_nr, int line_index) {
-          dispatcher.post([this, file_path, line_nr, line_index] {
+          dispatcher.post("Debug stop", [this, file_path, line_nr, line_index] {
             Project::debug_stop.first=file_path;
             Project::debug_stop.second.first=line_nr-1;
             Project::debug_stop.second.second=line_index-1;
             
             debug_update_stop();
+            //Only the rows of the changed values are updated, and the expanded rows are kept expanded
+            if(VariablesView::get().get_visible() && Debug::LLDB::get().is_stopped())
+              VariablesView::get().refresh();
             if(auto view=Notebook::get().get_current_view())
               view->get_buffer()->place_cursor(view->get_buffer()->get_insert()->get_iter());
           });
-        }, remote_host);
+        }, remote_host, sampling_interval);
       });
     }
   });
 }
 
+void Project::Clang::debug_show_profile() {
+  auto profile=Debug::LLDB::get().get_profile();
+  Terminal::get().print("Profile: "+profile.get_summary(20));
+  debug_update_profile_marks(&profile);
+  
+  auto flame_graph_path=build->get_debug_path()/"profile.svg";
+  if(!filesystem::write(flame_graph_path, profile.get_flame_graph())) {
+    Terminal::get().print("Error: could not write flame graph to "+flame_graph_path.string()+"\n", true);
+    return;
+  }
+  Terminal::get().print("Flame graph written to "+flame_graph_path.string()+"\n");
+  auto uri=flame_graph_path.string();
+#ifdef __APPLE__
+  Terminal::get().process("open "+filesystem::escape_argument(uri));
+#else
+#ifdef __linux
+  uri="file://"+uri;
+#endif
+  GError* error=nullptr;
+  gtk_show_uri(nullptr, uri.c_str(), GDK_CURRENT_TIME, &error);
+  g_clear_error(&error);
+#endif
+}
+
+void Project::Clang::debug_update_profile_marks(const Profile *profile) {
+  for(size_t c=0;c<Notebook::get().size();c++) {
+    auto view=Notebook::get().get_view(c);
+    for(auto &category: {"debug_profile_1", "debug_profile_2", "debug_profile_3"})
+      view->get_source_buffer()->remove_source_marks(view->get_buffer()->begin(), view->get_buffer()->end(), category);
+    if(!profile || profile->samples==0)
+      continue;
+    auto it=profile->lines.find(view->file_path.string());
+    if(it==profile->lines.end())
+      continue;
+    //Lines where much time is spent are marked more strongly than the lines calling these
+    for(auto &line: it->second) {
+      std::string category;
+      if(line.second.self*10>=profile->samples)
+        category="debug_profile_3";
+      else if(line.second.self*100>=profile->samples)
+        category="debug_profile_2";
+      else if(line.second.total*100>=profile->samples)
+        category="debug_profile_1";
+      if(!category.empty() && line.first-1<view->get_buffer()->get_line_count())
+        view->get_source_buffer()->create_source_mark(category, view->get_buffer()->get_iter_at_line(line.first-1));
+    }
+  }
+}
+
 void Project::Clang::debug_continue() {
   Debug::LLDB::get().continue_debug();
 }
@@ -514,75 +712,152 @@ void Project::Clang::debug_backtrace() {
 }
 
 void Project::Clang::debug_show_variables() {
-  auto view=Notebook::get().get_current_view();
-  if(debugging && view) {
-    auto variables=Debug::LLDB::get().get_variables();
-    
-    auto iter=view->get_iter_for_dialog();
-    view->selection_dialog=std::make_unique<SelectionDialog>(*view, view->get_buffer()->create_mark(iter), true, true);
-    auto rows=std::make_shared<std::unordered_map<std::string, Debug::LLDB::Variable> >();
-    if(variables.size()==0)
-      return;
+  if(debugging) {
+    //The threads, frames and variables that have been shown, used to read their children.
+    //The keys do not change between stops, and the children are read after their parents when the view is refreshed.
+    class Rows {
+    public:
+      std::unordered_map<std::string, uint32_t> threads;
+      std::unordered_map<std::string, std::pair<uint32_t, Debug::LLDB::Frame> > frames;
+      std::unordered_map<std::string, Debug::LLDB::Variable> variables;
+    };
+    auto rows=std::make_shared<Rows>();
     
-    for(auto &variable: variables) {
-      std::string row="#"+std::to_string(variable.thread_index_id)+":#"+std::to_string(variable.frame_index)+":"+variable.file_path.filename().string()+":"+std::to_string(variable.line_nr)+" - <b>"+Glib::Markup::escape_text(variable.name)+"</b>";
-      
-      (*rows)[row]=variable;
-      view->selection_dialog->add_row(row);
-    }
+    auto get_variable_row=[rows](Debug::LLDB::Variable &&variable) {
+      VariablesView::Row row;
+      row.key=variable.key;
+      row.name=variable.name;
+      row.value=variable.value;
+      row.changed=variable.changed;
+      row.has_children=variable.might_have_children;
+      rows->variables[variable.key]=std::move(variable);
+      return row;
+    };
     
-    view->selection_dialog->on_select=[this, rows](const std::string& selected, bool hide_window) {
-      auto variable=rows->at(selected);
-      Debug::LLDB::get().select_frame(variable.frame_index, variable.thread_index_id);
-      if(!variable.file_path.empty()) {
-        Notebook::get().open(variable.file_path);
-        if(auto view=Notebook::get().get_current_view()) {
-          view->place_cursor_at_line_index(variable.line_nr-1, variable.line_index-1);
-          view->scroll_to_cursor_delayed(view, true, true);
+    //Only the children of the expanded rows are read, and at most one page of children at a time
+    VariablesView::get().show([rows, get_variable_row](const std::string &key, size_t start, size_t count, size_t &size) {
+      std::vector<VariablesView::Row> children;
+      size=0;
+      if(key.empty()) {
+        auto threads=Debug::LLDB::get().get_threads();
+        size=threads.size();
+        for(size_t c=start;c<threads.size() && c-start<count;++c) {
+          VariablesView::Row row;
+          row.key="#"+std::to_string(threads[c].first);
+          row.name="Thread #"+std::to_string(threads[c].first);
+          row.value=threads[c].second;
+          row.has_children=true;
+          rows->threads[row.key]=threads[c].first;
+          children.emplace_back(std::move(row));
         }
       }
-      if(!variable.declaration_found)
-        Info::get().print("Debugger did not find declaration for the variable: "+variable.name);
-    };
-    
-    view->selection_dialog->on_hide=[this]() {
-      debug_variable_tooltips.hide();
-      debug_variable_tooltips.clear();
-    };
+      else if(rows->threads.count(key)) {
+        auto thread_index_id=rows->threads.at(key);
+        auto backtrace=Debug::LLDB::get().get_backtrace(thread_index_id);
+        size=backtrace.size();
+        for(size_t c=start;c<backtrace.size() && c-start<count;++c) {
+          auto &frame=backtrace[c];
+          VariablesView::Row row;
+          //The depth is counted from the outermost frame, so that the key does not change when functions are called or return
+          row.key=key+':'+std::to_string(backtrace.size()-1-c)+':'+frame.function_name;
+          row.name="#"+std::to_string(frame.index)+" "+frame.function_name;
+          if(!frame.file_path.empty())
+            row.value=frame.file_path.filename().string()+":"+std::to_string(frame.line_nr);
+          row.has_children=true;
+          rows->frames[row.key]={thread_index_id, frame};
+          children.emplace_back(std::move(row));
+        }
+      }
+      else if(rows->frames.count(key)) {
+        auto &frame=rows->frames.at(key);
+        auto variables=Debug::LLDB::get().get_variables(frame.first, frame.second.index);
+        size=variables.size();
+        for(size_t c=start;c<variables.size() && c-start<count;++c)
+          children.emplace_back(get_variable_row(std::move(variables[c])));
+      }
+      else if(rows->variables.count(key)) {
+        uint32_t children_size;
+        auto variables=Debug::LLDB::get().get_children(rows->variables.at(key), start, count, children_size);
+        size=children_size;
+        for(auto &variable: variables)
+          children.emplace_back(get_variable_row(std::move(variable)));
+      }
+      return children;
+    }, 2);
     
-    view->selection_dialog->on_changed=[this, rows, iter](const std::string &selected) {
-      if(selected.empty()) {
-        debug_variable_tooltips.hide();
+    VariablesView::get().on_activate=[rows](const std::string &key) {
+      auto frame_it=rows->frames.find(key);
+      if(frame_it!=rows->frames.end()) {
+        auto &frame=frame_it->second.second;
+        Debug::LLDB::get().select_frame(frame.index, frame_it->second.first);
+        if(!frame.file_path.empty()) {
+          Notebook::get().open(frame.file_path);
+          if(auto view=Notebook::get().get_current_view()) {
+            view->place_cursor_at_line_index(frame.line_nr-1, frame.line_index-1);
+            view->scroll_to_cursor_delayed(view, true, true);
+          }
+        }
         return;
       }
-      if(auto view=Notebook::get().get_current_view()) {
-        debug_variable_tooltips.clear();
-        auto create_tooltip_buffer=[this, rows, view, selected]() {
-          auto variable=rows->at(selected);
-          auto tooltip_buffer=Gtk::TextBuffer::create(view->get_buffer()->get_tag_table());
-          
-          Glib::ustring value=variable.value;
-          if(!value.empty()) {
-            Glib::ustring::iterator iter;
-            while(!value.validate(iter)) {
-              auto next_char_iter=iter;
-              next_char_iter++;
-              value.replace(iter, next_char_iter, "?");
-            } 
-            tooltip_buffer->insert_with_tag(tooltip_buffer->get_insert()->get_iter(), value.substr(0, value.size()-1), "def:note");
+      auto variable_it=rows->variables.find(key);
+      if(variable_it!=rows->variables.end()) {
+        auto &variable=variable_it->second;
+        Debug::LLDB::get().select_frame(variable.frame_index, variable.thread_index_id);
+        if(!variable.file_path.empty()) {
+          Notebook::get().open(variable.file_path);
+          if(auto view=Notebook::get().get_current_view()) {
+            view->place_cursor_at_line_index(variable.line_nr-1, variable.line_index-1);
+            view->scroll_to_cursor_delayed(view, true, true);
           }
-          
-          return tooltip_buffer;
-        };
-        
-        debug_variable_tooltips.emplace_back(create_tooltip_buffer, *view, view->get_buffer()->create_mark(iter), view->get_buffer()->create_mark(iter));
+        }
+        if(!variable.declaration_found)
+          Info::get().print("Debugger did not find declaration for the variable: "+variable.name);
+      }
+    };
     
-        debug_variable_tooltips.show(true);
+    VariablesView::get().on_show_memory=[rows](const std::string &key) {
+      auto variable_it=rows->variables.find(key);
+      if(variable_it==rows->variables.end())
+        return;
+      uint64_t address;
+      if(!Debug::LLDB::get().get_address(variable_it->second, address)) {
+        Info::get().print("Debugger did not find the address of: "+variable_it->second.name);
+        return;
       }
+      MemoryView::get().show_address(address, Debug::LLDB::memory_page_size, [](uint64_t page_address) {
+        return Debug::LLDB::get().get_memory_page(page_address);
+      });
     };
     
-    view->hide_tooltips();
-    view->selection_dialog->show();
+    //The type of the variable is only read when the tooltip is shown
+    VariablesView::get().get_tooltip=[rows](const std::string &key) {
+      auto variable_it=rows->variables.find(key);
+      if(variable_it==rows->variables.end())
+        return std::string();
+      return Debug::LLDB::get().get_variable_description(variable_it->second, 0);
+    };
+  }
+}
+
+void Project::Clang::debug_show_memory(const std::string &expression) {
+  if(debugging) {
+    uint64_t address;
+    size_t pos=0;
+    try {
+      address=std::stoull(expression, &pos, 0);
+    }
+    catch(...) {}
+    if(pos==0 || pos!=expression.size()) {
+      if(!Debug::LLDB::get().get_address(expression, address)) {
+        Info::get().print("Debugger did not find the address of: "+expression);
+        return;
+      }
+    }
+    
+    //Only the pages that are scrolled to are read from the debugged process
+    MemoryView::get().show_address(address, Debug::LLDB::memory_page_size, [](uint64_t page_address) {
+      return Debug::LLDB::get().get_memory_page(page_address);
+    });
   }
 }
 
@@ -5,10 +5,10 @@
 #include <boost/filesystem.hpp>
 #include <atomic>
 #include <unordered_map>
-#include "tooltips.h"
 #include "dispatcher.h"
 #include <iostream>
 #include "project_build.h"
+#include "profile.h"
 
 namespace Project {
   Gtk::Label &debug_status_label();
@@ -44,11 +44,15 @@ namespace Project {
     virtual void compile();
     virtual void compile_and_run();
     virtual void recreate_build();
+    ///Compiles and runs the Google Benchmark executables, and compares the results to the baseline or the previous run
+    virtual void run_benchmarks();
+    ///Sets the last benchmark run as the baseline, or removes the baseline if set
+    virtual void toggle_benchmark_baseline();
     
     virtual std::pair<std::string, std::string> debug_get_run_arguments();
     virtual Gtk::Popover *debug_get_options() { return nullptr; }
-    Tooltips debug_variable_tooltips;
     virtual void debug_start();
+    virtual void debug_profile() { debug_start(); }
     virtual void debug_continue() {}
     virtual void debug_stop() {}
     virtual void debug_kill() {}
@@ -57,6 +61,7 @@ namespace Project {
     virtual void debug_step_out() {}
     virtual void debug_backtrace() {}
     virtual void debug_show_variables() {}
+    virtual void debug_show_memory(const std::string &expression) {}
     virtual void debug_run_command(const std::string &command) {}
     virtual void debug_add_breakpoint(const boost::filesystem::path &file_path, int line_nr) {}
     virtual void debug_remove_breakpoint(const boost::filesystem::path &file_path, int line_nr, int line_count) {}
@@ -85,11 +90,15 @@ namespace Project {
     void compile() override;
     void compile_and_run() override;
     void recreate_build() override;
+    void run_benchmarks() override;
+    void toggle_benchmark_baseline() override;
     
 #ifdef JUCI_ENABLE_DEBUG
     std::pair<std::string, std::string> debug_get_run_arguments() override;
     Gtk::Popover *debug_get_options() override;
     void debug_start() override;
+    ///Runs the debugger while sampling the backtraces of all threads, and shows the profile when the program exits
+    void debug_profile() override;
     void debug_continue() override;
     void debug_stop() override;
     void debug_kill() override;
@@ -98,12 +107,18 @@ namespace Project {
     void debug_step_out() override;
     void debug_backtrace() override;
     void debug_show_variables() override;
+    void debug_show_memory(const std::string &expression) override;
     void debug_run_command(const std::string &command) override;
     void debug_add_breakpoint(const boost::filesystem::path &file_path, int line_nr) override;
     void debug_remove_breakpoint(const boost::filesystem::path &file_path, int line_nr, int line_count) override;
     bool debug_is_running() override;
     void debug_write(const std::string &buffer) override;
     void debug_cancel() override;
+  private:
+    void debug_start(int sampling_interval);
+    void debug_show_profile();
+    ///Marks the lines of the open views that have samples, or removes the marks if profile is nullptr
+    void debug_update_profile_marks(const Profile *profile);
 #endif
   };
   
@@ -70,8 +70,8 @@ Project::CMakeBuild::CMakeBuild(const boost::filesystem::path &path) : Project::
   project_path=cmake.project_path;
 }
 
-bool Project::CMakeBuild::update_default(bool force) {
-  return cmake.update_default_build(get_default_path(), force);
+bool Project::CMakeBuild::update_default(bool force, bool background) {
+  return cmake.update_default_build(get_default_path(), force, background);
 }
 
 bool Project::CMakeBuild::update_debug(bool force) {
@@ -81,3 +81,7 @@ bool Project::CMakeBuild::update_debug(bool force) {
 boost::filesystem::path Project::CMakeBuild::get_executable(const boost::filesystem::path &path) {
   return cmake.get_executable(path);
 }
+
+std::vector<boost::filesystem::path> Project::CMakeBuild::get_benchmark_executables() {
+  return cmake.get_benchmark_executables();
+}
@@ -13,11 +13,13 @@ namespace Project {
     boost::filesystem::path project_path;
     
     boost::filesystem::path get_default_path();
-    virtual bool update_default(bool force=false) {return false;}
+    ///If background is true, the function can be called from a thread other than the main thread
+    virtual bool update_default(bool force=false, bool background=false) {return false;}
     boost::filesystem::path get_debug_path();
     virtual bool update_debug(bool force=false) {return false;}
     
     virtual boost::filesystem::path get_executable(const boost::filesystem::path &path) {return boost::filesystem::path();}
+    virtual std::vector<boost::filesystem::path> get_benchmark_executables() {return std::vector<boost::filesystem::path>();}
     
     static std::unique_ptr<Build> create(const boost::filesystem::path &path);
   };
@@ -27,10 +29,11 @@ namespace Project {
   public:
     CMakeBuild(const boost::filesystem::path &path);
     
-    bool update_default(bool force=false) override;
+    bool update_default(bool force=false, bool background=false) override;
     bool update_debug(bool force=false) override;
     
     boost::filesystem::path get_executable(const boost::filesystem::path &path) override;
+    std::vector<boost::filesystem::path> get_benchmark_executables() override;
   };
 }
 
@@ -0,0 +1,161 @@
+#include "record_layout.h"
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <tuple>
+
+namespace {
+  ///A field, or a run of bit-fields that are moved together
+  class Unit {
+  public:
+    std::vector<RecordLayout::Field> fields;
+    int64_t size, alignment;
+  };
+  
+  int64_t align(int64_t offset, int64_t alignment) {
+    return alignment>1?(offset+alignment-1)/alignment*alignment:offset;
+  }
+  
+  ///Returns empty vector if fields overlap, as in unions, since these cannot be reordered
+  std::vector<Unit> get_units(const std::vector<RecordLayout::Field> &fields) {
+    std::vector<Unit> units;
+    int64_t end=0;
+    for(auto &field: fields) {
+      if(!units.empty() && field.offset<end)
+        return std::vector<Unit>();
+      end=field.offset+field.size;
+      if(field.bit_field && !units.empty() && units.back().fields.back().bit_field) {
+        auto &unit=units.back();
+        unit.fields.emplace_back(field);
+        unit.alignment=std::max(unit.alignment, field.alignment);
+        unit.size=(end-unit.fields.front().offset/8*8+7)/8;
+      }
+      else {
+        units.emplace_back();
+        units.back().fields.emplace_back(field);
+        units.back().alignment=field.alignment;
+        units.back().size=(field.offset%8+field.size+7)/8;
+      }
+    }
+    std::stable_sort(units.begin(), units.end(), [](const Unit &lhs, const Unit &rhs) {
+      if(lhs.alignment!=rhs.alignment)
+        return lhs.alignment>rhs.alignment;
+      return lhs.size>rhs.size;
+    });
+    return units;
+  }
+}
+
+std::vector<RecordLayout::Padding> RecordLayout::get_paddings() const {
+  std::vector<Padding> paddings;
+  if(fields.empty())
+    return paddings;
+  int64_t end=fields[0].offset;
+  for(auto &field: fields) {
+    auto start_byte=(end+7)/8;
+    auto end_byte=field.offset/8;
+    if(end_byte>start_byte)
+      paddings.emplace_back(Padding{start_byte, end_byte-start_byte});
+    end=std::max(end, field.offset+field.size);
+  }
+  auto start_byte=(end+7)/8;
+  if(size>start_byte)
+    paddings.emplace_back(Padding{start_byte, size-start_byte});
+  return paddings;
+}
+
+int64_t RecordLayout::get_padding_size() const {
+  int64_t padding_size=0;
+  for(auto &padding: get_paddings())
+    padding_size+=padding.size;
+  return padding_size;
+}
+
+std::vector<RecordLayout::Field> RecordLayout::get_optimal_order() const {
+  auto units=get_units(fields);
+  if(units.empty())
+    return fields;
+  std::vector<Field> optimal_order;
+  for(auto &unit: units)
+    optimal_order.insert(optimal_order.end(), unit.fields.begin(), unit.fields.end());
+  return optimal_order;
+}
+
+int64_t RecordLayout::get_optimal_size() const {
+  auto units=get_units(fields);
+  if(units.empty())
+    return size;
+  //The fields start after the base classes and the virtual table pointer
+  auto offset=fields[0].offset/8;
+  for(auto &unit: units)
+    offset=align(offset, unit.alignment)+unit.size;
+  return std::min(align(offset, alignment), size);
+}
+
+std::string RecordLayout::get_text() const {
+  std::stringstream ss;
+  ss << name << ": " << size << " bytes, alignment " << alignment << ", " << get_padding_size() << " bytes padding\n";
+  ss << "  offset   size  align  field\n";
+  
+  //Rows are sorted on offset in bits, with cache line boundaries before fields at the same offset
+  std::vector<std::tuple<int64_t, int, std::string> > rows;
+  for(auto &field: fields) {
+    std::stringstream row;
+    if(field.bit_field) {
+      row << std::setw(8) << std::to_string(field.offset/8)+':'+std::to_string(field.offset%8)
+          << std::setw(7) << std::to_string(field.size)+"b";
+    }
+    else
+      row << std::setw(8) << field.offset/8 << std::setw(7) << field.size/8;
+    row << std::setw(7) << field.alignment << "  " << field.type << ' ' << field.name;
+    if(!field.bit_field && field.size>0 && field.offset/8/cache_line_size!=(field.offset/8+field.size/8-1)/cache_line_size)
+      row << " (crosses cache line)";
+    rows.emplace_back(field.offset, 1, row.str());
+  }
+  for(auto &padding: get_paddings()) {
+    std::stringstream row;
+    row << std::setw(8) << padding.offset << std::setw(7) << padding.size << std::setw(9) << ' ' << padding.size << " bytes padding";
+    rows.emplace_back(padding.offset*8, 1, row.str());
+  }
+  for(int64_t offset=cache_line_size;offset<size;offset+=cache_line_size)
+    rows.emplace_back(offset*8, 0, "  --- cache line boundary at "+std::to_string(offset)+" ---");
+  std::stable_sort(rows.begin(), rows.end(), [](const std::tuple<int64_t, int, std::string> &lhs, const std::tuple<int64_t, int, std::string> &rhs) {
+    return std::make_pair(std::get<0>(lhs), std::get<1>(lhs))<std::make_pair(std::get<0>(rhs), std::get<1>(rhs));
+  });
+  for(auto &row: rows)
+    ss << std::get<2>(row) << '\n';
+  
+  auto optimal_size=get_optimal_size();
+  if(optimal_size<size) {
+    ss << "Reordering saves " << size-optimal_size << " bytes (" << optimal_size << " bytes):";
+    auto optimal_order=get_optimal_order();
+    for(size_t c=0;c<optimal_order.size();++c)
+      ss << (c==0?" ":", ") << optimal_order[c].name;
+    ss << '\n';
+  }
+  return ss.str();
+}
+
+std::string RecordLayout::get_report(const std::vector<RecordLayout> &layouts, size_t max_records) {
+  std::vector<std::pair<int64_t, const RecordLayout*> > paddings;
+  for(auto &layout: layouts) {
+    auto padding_size=layout.get_padding_size();
+    if(padding_size>0)
+      paddings.emplace_back(padding_size, &layout);
+  }
+  std::stable_sort(paddings.begin(), paddings.end(), [](const std::pair<int64_t, const RecordLayout*> &lhs, const std::pair<int64_t, const RecordLayout*> &rhs) {
+    return lhs.first>rhs.first;
+  });
+  
+  std::stringstream ss;
+  ss << paddings.size() << " of " << layouts.size() << " records have padding\n";
+  for(size_t c=0;c<paddings.size() && c<max_records;++c) {
+    auto &layout=*paddings[c].second;
+    ss << layout.file_path.string() << ':' << layout.line << ":1: " << layout.name << ": " << paddings[c].first << " bytes padding of " << layout.size << " bytes";
+    auto optimal_size=layout.get_optimal_size();
+    if(optimal_size<layout.size)
+      ss << ", reordering saves " << layout.size-optimal_size << " bytes";
+    ss << '\n';
+  }
+  return ss.str();
+}
@@ -0,0 +1,52 @@
+#ifndef JUCI_RECORD_LAYOUT_H_
+#define JUCI_RECORD_LAYOUT_H_
+#include <boost/filesystem.hpp>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+///Field offsets, sizes and alignments of a class, struct or union, with padding, cache line boundaries and the field order with the least padding
+class RecordLayout {
+public:
+  class Field {
+  public:
+    std::string name;
+    std::string type;
+    ///Offset and size are in bits, since bit-fields need not start or end at a byte
+    int64_t offset;
+    int64_t size;
+    ///Alignment in bytes
+    int64_t alignment;
+    bool bit_field;
+  };
+  class Padding {
+  public:
+    int64_t offset, size;
+  };
+  
+  std::string name;
+  boost::filesystem::path file_path;
+  int line=0;
+  ///Size and alignment in bytes
+  int64_t size=0;
+  int64_t alignment=1;
+  ///Fields in declaration order. Base classes and the virtual table pointer are not fields.
+  std::vector<Field> fields;
+  
+  static const int64_t cache_line_size=64;
+  
+  ///Returns the unused bytes after the fields, from the first field to the end of the record
+  std::vector<Padding> get_paddings() const;
+  int64_t get_padding_size() const;
+  ///Returns the fields sorted by alignment and then size, with runs of bit-fields kept together
+  std::vector<Field> get_optimal_order() const;
+  ///Returns the size of the record with the fields in the optimal order
+  int64_t get_optimal_size() const;
+  
+  ///Returns a table of the fields and paddings, followed by the optimal order if it saves bytes
+  std::string get_text() const;
+  ///Returns the records with the most padding, one record per row starting with its location
+  static std::string get_report(const std::vector<RecordLayout> &layouts, size_t max_records);
+};
+
+#endif // JUCI_RECORD_LAYOUT_H_
@@ -1,5 +1,6 @@
 #include "selectiondialog.h"
 #include <algorithm>
+#include <chrono>
 
 namespace sigc {
 #ifndef SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
@@ -15,17 +16,49 @@ namespace sigc {
 #endif
 }
 
-SelectionDialogBase::ListViewText::ListViewText(bool use_markup) : Gtk::TreeView(), use_markup(use_markup) {
+void SelectionDialogBase::Rows::emplace_back(std::string &&text, std::string &&search_text) {
+  size_t index=size;
+  if(index%chunk_size==0) {
+    std::unique_lock<std::mutex> lock(chunks_mutex);
+    chunks.emplace_back(new Row[chunk_size]);
+  }
+  auto &row=chunks[index/chunk_size][index%chunk_size];
+  row.text=std::move(text);
+  row.search_text=std::move(search_text);
+  size=index+1;
+}
+
+std::vector<const SelectionDialogBase::Row*> SelectionDialogBase::Rows::get_chunks() {
+  std::unique_lock<std::mutex> lock(chunks_mutex);
+  std::vector<const Row*> chunks_copy;
+  chunks_copy.reserve(chunks.size());
+  for(auto &chunk: chunks)
+    chunks_copy.emplace_back(chunk.get());
+  return chunks_copy;
+}
+
+SelectionDialogBase::ListViewText::ListViewText(const Rows &rows, bool use_markup) : Gtk::TreeView(), use_markup(use_markup), rows(rows) {
   list_store = Gtk::ListStore::create(column_record);
   set_model(list_store);
   append_column("", cell_renderer);
-  if(use_markup)
-    get_column(0)->add_attribute(cell_renderer.property_markup(), column_record.text);
-  else
-    get_column(0)->add_attribute(cell_renderer.property_text(), column_record.text);
+  get_column(0)->set_cell_data_func(cell_renderer, [this](Gtk::CellRenderer *renderer, const Gtk::TreeModel::iterator &iter) {
+    auto &row=get_row(iter);
+    if(!this->use_markup)
+      cell_renderer.property_text()=row;
+    else if(get_markup)
+      cell_renderer.property_markup()=get_markup(row);
+    else
+      cell_renderer.property_markup()=row;
+  });
   
   get_selection()->set_mode(Gtk::SelectionMode::SELECTION_BROWSE);
   set_enable_search(true);
+  set_search_column(column_record.index);
+  //Same as the default search, but on the row text instead of the index column
+  set_search_equal_func([this](const Glib::RefPtr<Gtk::TreeModel>& model, int column, const Glib::ustring& key, const Gtk::TreeModel::iterator& iter) {
+    auto key_casefold=key.casefold();
+    return Glib::ustring(get_row(iter)).casefold().compare(0, key_casefold.size(), key_casefold)!=0;
+  });
   set_headers_visible(false);
   set_hscroll_policy(Gtk::ScrollablePolicy::SCROLL_NATURAL);
   set_activate_on_single_click(true);
@@ -33,18 +66,43 @@ SelectionDialogBase::ListViewText::ListViewText(bool use_markup) : Gtk::TreeView
   set_rules_hint(true);
 }
 
-void SelectionDialogBase::ListViewText::append(const std::string& value) {
+void SelectionDialogBase::ListViewText::append(size_t index) {
   auto new_row=list_store->append();
-  new_row->set_value(column_record.text, value);
+  new_row->set_value(column_record.index, index);
+}
+
+void SelectionDialogBase::ListViewText::set_rows(const std::vector<size_t> &indices) {
+  rows_list_store=Gtk::ListStore::create(column_record);
+  for(auto &index: indices) {
+    auto new_row=rows_list_store->append();
+    new_row->set_value(column_record.index, index);
+  }
+  set_model(rows_list_store);
+}
+
+void SelectionDialogBase::ListViewText::set_appended_rows() {
+  if(get_model()!=list_store) {
+    set_model(list_store);
+    rows_list_store.reset();
+  }
 }
 
 void SelectionDialogBase::ListViewText::clear() {
   unset_model();
   list_store.reset();
+  rows_list_store.reset();
+}
+
+size_t SelectionDialogBase::ListViewText::get_index(const Gtk::TreeModel::const_iterator &iter) {
+  return iter->get_value(column_record.index);
+}
+
+const std::string &SelectionDialogBase::ListViewText::get_row(const Gtk::TreeModel::const_iterator &iter) {
+  return rows[get_index(iter)].text;
 }
 
 SelectionDialogBase::SelectionDialogBase(Gtk::TextView& text_view, Glib::RefPtr<Gtk::TextBuffer::Mark> start_mark, bool show_search_entry, bool use_markup):
-    text_view(text_view), window(Gtk::WindowType::WINDOW_POPUP), list_view_text(use_markup), start_mark(start_mark), show_search_entry(show_search_entry) {
+    text_view(text_view), window(Gtk::WindowType::WINDOW_POPUP), list_view_text(rows, use_markup), start_mark(start_mark), show_search_entry(show_search_entry) {
   auto g_application=g_application_get_default();
   auto gio_application=Glib::wrap(g_application, true);
   auto application=Glib::RefPtr<Gtk::Application>::cast_static(gio_application);
@@ -95,7 +153,7 @@ void SelectionDialogBase::cursor_changed() {
   auto it=list_view_text.get_selection()->get_selected();
   std::string row;
   if(it)
-    it->get_value(0, row);
+    row=list_view_text.get_row(it);
   if(last_row==row)
     return;
   if(on_changed)
@@ -104,11 +162,101 @@ void SelectionDialogBase::cursor_changed() {
 }
 
 SelectionDialogBase::~SelectionDialogBase() {
+  if(rows_producer_stop)
+    *rows_producer_stop=true;
   text_view.get_buffer()->delete_mark(start_mark);
 }
 
 void SelectionDialogBase::add_row(const std::string& row) {
-  list_view_text.append(row);
+  rows.emplace_back(std::string(row), show_search_entry ? get_search_text(row) : std::string());
+  list_view_text.append(rows.get_size()-1);
+}
+
+void SelectionDialogBase::add_rows_async(std::function<void(const AddRow &add_row)> &&producer) {
+  //Not destroyed, since producer threads might still be running when juCi++ exits
+  static auto dispatcher=new Dispatcher();
+  
+  if(rows_producer_stop)
+    *rows_producer_stop=true;
+  auto stop=std::make_shared<std::atomic<bool> >(false);
+  rows_producer_stop=stop;
+  
+  std::thread([this, producer, stop] {
+    auto rows=std::make_shared<std::vector<std::string> >();
+    auto last_post_time=std::chrono::steady_clock::now();
+    auto post_rows=[this, &rows, &last_post_time, stop] {
+      dispatcher->post("Selection dialog rows added", [this, rows, stop] {
+        if(*stop)
+          return;
+        for(auto &row: *rows)
+          add_row(row);
+        auto children=list_view_text.get_model()->children();
+        if(shown && !list_view_text.get_selection()->get_selected() && children.size()>0) {
+          list_view_text.set_cursor(list_view_text.get_model()->get_path(children.begin()));
+          cursor_changed();
+        }
+        if(shown)
+          resize();
+        rows_added();
+      });
+      rows=std::make_shared<std::vector<std::string> >();
+      last_post_time=std::chrono::steady_clock::now();
+    };
+    
+    producer([&rows, &post_rows, &last_post_time, stop](std::string &&row) {
+      if(*stop)
+        return false;
+      rows->emplace_back(std::move(row));
+      if(rows->size()>=10000 || std::chrono::steady_clock::now()-last_post_time>std::chrono::milliseconds(50))
+        post_rows();
+      return true;
+    });
+    
+    if(*stop)
+      return;
+    post_rows();
+    dispatcher->post("Selection dialog rows finished", [this, stop] {
+      if(*stop)
+        return;
+      if(on_rows_finished)
+        on_rows_finished();
+    });
+  }).detach();
+}
+
+void SelectionDialogBase::set_row_markup(std::function<std::string(const std::string &row)> &&get_markup) {
+  list_view_text.get_markup=std::move(get_markup);
+}
+
+std::string SelectionDialogBase::get_search_text(const std::string &row) {
+  static std::vector<std::pair<std::string, char> > entities={{"&lt;", '<'}, {"&gt;", '>'}, {"&amp;", '&'}, {"&quot;", '"'}, {"&apos;", '\''}};
+  std::string search_text;
+  search_text.reserve(row.size());
+  for(size_t c=0;c<row.size();++c) {
+    auto chr=row[c];
+    if(list_view_text.use_markup && !list_view_text.get_markup) {
+      if(chr=='<') {
+        auto pos=row.find('>', c+1);
+        if(pos==std::string::npos)
+          break;
+        c=pos;
+        continue;
+      }
+      if(chr=='&') {
+        for(auto &entity: entities) {
+          if(row.compare(c, entity.first.size(), entity.first)==0) {
+            chr=entity.second;
+            c+=entity.first.size()-1;
+            break;
+          }
+        }
+      }
+    }
+    if(chr>='A' && chr<='Z')
+      chr+='a'-'A';
+    search_text+=chr;
+  }
+  return search_text;
 }
 
 void SelectionDialogBase::show() {
@@ -141,6 +289,8 @@ void SelectionDialogBase::hide() {
   if(!shown)
     return;
   shown=false;
+  if(rows_producer_stop)
+    *rows_producer_stop=true;
   window.hide();
   if(on_hide)
     on_hide();
@@ -148,7 +298,7 @@ void SelectionDialogBase::hide() {
 }
 
 void SelectionDialogBase::resize() {
-  if(list_view_text.get_realized()) {
+  if(list_view_text.get_realized() && list_view_text.get_model()->children().size()>0) {
     int row_width=0, row_height;
     Gdk::Rectangle rect;
     list_view_text.get_cell_area(list_view_text.get_model()->get_path(list_view_text.get_model()->children().begin()), *(list_view_text.get_column(0)), rect);
@@ -171,49 +321,30 @@ void SelectionDialogBase::resize() {
 }
 
 SelectionDialog::SelectionDialog(Gtk::TextView& text_view, Glib::RefPtr<Gtk::TextBuffer::Mark> start_mark, bool show_search_entry, bool use_markup) : SelectionDialogBase(text_view, start_mark, show_search_entry, use_markup) {
-  std::shared_ptr<std::string> search_key(new std::string());
-  auto filter_model=Gtk::TreeModelFilter::create(list_view_text.get_model());
-  
-  filter_model->set_visible_func([this, search_key](const Gtk::TreeModel::const_iterator& iter){
-    std::string row_lc;
-    iter->get_value(0, row_lc);
-    auto search_key_lc=*search_key;
-    std::transform(row_lc.begin(), row_lc.end(), row_lc.begin(), ::tolower);
-    std::transform(search_key_lc.begin(), search_key_lc.end(), search_key_lc.begin(), ::tolower);
-    if(list_view_text.use_markup) {
-      size_t pos=0;
-      while((pos=row_lc.find('<', pos))!=std::string::npos) {
-        auto pos2=row_lc.find('>', pos+1);
-        row_lc.erase(pos, pos2-pos+1);
-      }
-      search_key_lc=Glib::Markup::escape_text(search_key_lc);
-    }
-    if(row_lc.find(search_key_lc)!=std::string::npos)
-      return true;
-    return false;
-  });
-  
-  list_view_text.set_model(filter_model);
+  filter_generation=0;
   
   list_view_text.set_search_equal_func([this](const Glib::RefPtr<Gtk::TreeModel>& model, int column, const Glib::ustring& key, const Gtk::TreeModel::iterator& iter) {
     return false;
   });
   
-  search_entry.signal_changed().connect([this, search_key, filter_model](){
-    *search_key=search_entry.get_text();
-    filter_model->refilter();
-    list_view_text.set_search_entry(search_entry); //TODO:Report the need of this to GTK's git (bug)
-    if(search_key->empty()) {
+  search_entry.signal_changed().connect([this](){
+    std::string key=search_entry.get_text();
+    std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+    if(key.empty()) {
+      ++filter_generation;
+      list_view_text.set_appended_rows();
+      list_view_text.set_search_entry(search_entry); //TODO:Report the need of this to GTK's git (bug)
       if(list_view_text.get_model()->children().size()>0)
         list_view_text.set_cursor(list_view_text.get_model()->get_path(list_view_text.get_model()->children().begin()));
+      return;
     }
+    filter_start(std::move(key), true);
   });
   
   auto activate=[this](){
     auto it=list_view_text.get_selection()->get_selected();
     if(on_select && it) {
-      std::string row;
-      it->get_value(0, row);
+      auto row=list_view_text.get_row(it);
       hide();
       on_select(row, true);
     }
@@ -228,6 +359,179 @@ SelectionDialog::SelectionDialog(Gtk::TextView& text_view, Glib::RefPtr<Gtk::Tex
   });
 }
 
+void SelectionDialog::filter_start(std::string &&key, bool cancel) {
+  if(!filter_thread.joinable()) {
+    filter_thread=std::thread([this]() {
+      while(true) {
+        std::unique_ptr<std::string> key;
+        size_t generation;
+        bool keep_cursor;
+        {
+          std::unique_lock<std::mutex> lock(filter_mutex);
+          filter_condition_variable.wait(lock, [this] {
+            return filter_stop || filter_key;
+          });
+          if(filter_stop)
+            return;
+          key=std::move(filter_key);
+          generation=filter_generation;
+          keep_cursor=filter_keep_cursor;
+        }
+        filter(*key, generation, keep_cursor);
+      }
+    });
+  }
+  
+  {
+    std::unique_lock<std::mutex> lock(filter_mutex);
+    if(cancel) {
+      ++filter_generation;
+      filter_key=std::make_unique<std::string>(std::move(key));
+      filter_keep_cursor=false;
+    }
+    else if(!filter_key) {
+      filter_key=std::make_unique<std::string>(std::move(key));
+      filter_keep_cursor=true;
+    }
+  }
+  filter_condition_variable.notify_one();
+}
+
+void SelectionDialog::rows_added() {
+  std::string key=search_entry.get_text();
+  std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+  if(!key.empty())
+    filter_start(std::move(key), false);
+}
+
+SelectionDialog::~SelectionDialog() {
+  filter_dispatcher.disconnect();
+  ++filter_generation;
+  {
+    std::unique_lock<std::mutex> lock(filter_mutex);
+    filter_stop=true;
+  }
+  filter_condition_variable.notify_one();
+  if(filter_thread.joinable())
+    filter_thread.join();
+}
+
+size_t SelectionDialog::fuzzy_score(const std::string &text, const std::string &key) {
+  auto is_word_start=[&text](size_t pos) {
+    auto is_word_char=[](char chr) {
+      return (chr>='a' && chr<='z') || (chr>='0' && chr<='9') || static_cast<unsigned char>(chr)>=128;
+    };
+    return pos==0 || (!is_word_char(text[pos-1]) && is_word_char(text[pos]));
+  };
+  
+  //Substring matches are placed before the other matches
+  auto pos=text.find(key);
+  if(pos!=std::string::npos)
+    return 1000+(is_word_start(pos) ? 500 : 0)+std::max<int>(0, 100-static_cast<int>(text.size()/16));
+  
+  size_t score=1;
+  size_t text_pos=0;
+  size_t last_pos=std::string::npos;
+  for(auto &chr: key) {
+    pos=text.find(chr, text_pos);
+    if(pos==std::string::npos)
+      return 0;
+    if(last_pos!=std::string::npos && pos==last_pos+1)
+      score+=5;
+    else
+      ++score;
+    if(is_word_start(pos))
+      score+=3;
+    last_pos=pos;
+    text_pos=pos+1;
+  }
+  return std::min<size_t>(score, 999);
+}
+
+void SelectionDialog::filter(const std::string &key, size_t generation, bool keep_cursor) {
+  auto compare=[](const Match &lhs, const Match &rhs) {
+    if(lhs.first!=rhs.first)
+      return lhs.first>rhs.first;
+    return lhs.second<rhs.second;
+  };
+  auto keep_best=[&compare](std::vector<Match> &matches) {
+    if(matches.size()>max_filtered_rows) {
+      std::partial_sort(matches.begin(), matches.begin()+max_filtered_rows, matches.end(), compare);
+      matches.resize(max_filtered_rows);
+    }
+    else
+      std::sort(matches.begin(), matches.end(), compare);
+  };
+  
+  //The size is read before the chunks, so that the chunks contain all the rows below the size
+  auto rows_size_total=rows.get_size();
+  auto chunks=rows.get_chunks();
+    
+  //If the key is unchanged, only the rows added since the last filtering are scored
+  size_t begin=0;
+  if(key==filtered_key)
+    begin=filtered_rows_size;
+  auto rows_size=rows_size_total-begin;
+  size_t threads_size=1;
+  if(rows_size>=10000)
+    threads_size=std::max(1u, std::thread::hardware_concurrency());
+  auto rows_per_thread=(rows_size+threads_size-1)/threads_size;
+  std::vector<std::vector<Match> > threads_matches(threads_size);
+  auto score_rows=[this, &key, generation, &chunks, begin, rows_size, rows_per_thread, &threads_matches, &keep_best](size_t thread_index) {
+    auto &matches=threads_matches[thread_index];
+    auto end=begin+std::min((thread_index+1)*rows_per_thread, rows_size);
+    for(size_t c=begin+thread_index*rows_per_thread;c<end;++c) {
+      if(c%1024==0 && generation!=filter_generation)
+        return;
+      auto score=fuzzy_score(chunks[c/Rows::chunk_size][c%Rows::chunk_size].search_text, key);
+      if(score>0)
+        matches.emplace_back(score, c);
+    }
+    keep_best(matches);
+  };
+  std::vector<std::thread> threads;
+  for(size_t c=1;c<threads_size;++c)
+    threads.emplace_back(score_rows, c);
+  score_rows(0);
+  for(auto &thread: threads)
+    thread.join();
+  if(generation!=filter_generation)
+    return;
+  
+  auto &matches=threads_matches[0];
+  for(size_t c=1;c<threads_size;++c)
+    matches.insert(matches.end(), threads_matches[c].begin(), threads_matches[c].end());
+  if(begin>0)
+    matches.insert(matches.end(), filtered_matches.begin(), filtered_matches.end());
+  keep_best(matches);
+  filtered_key=key;
+  filtered_matches=matches;
+  filtered_rows_size=rows_size_total;
+  auto indices=std::make_shared<std::vector<size_t> >();
+  indices->reserve(matches.size());
+  for(auto &match: matches)
+    indices->emplace_back(match.second);
+  
+  filter_dispatcher.post("Selection dialog filter", [this, generation, keep_cursor, indices] {
+    if(generation!=filter_generation || !shown)
+      return;
+    size_t index=0;
+    if(keep_cursor) {
+      auto it=list_view_text.get_selection()->get_selected();
+      if(it) {
+        auto indices_it=std::find(indices->begin(), indices->end(), list_view_text.get_index(it));
+        if(indices_it!=indices->end())
+          index=indices_it-indices->begin();
+      }
+    }
+    list_view_text.set_rows(*indices);
+    list_view_text.set_search_entry(search_entry); //TODO:Report the need of this to GTK's git (bug)
+    auto children=list_view_text.get_model()->children();
+    if(index<children.size())
+      list_view_text.set_cursor(list_view_text.get_model()->get_path(children[index]));
+  });
+}
+
 bool SelectionDialog::on_key_press(GdkEventKey* key) {
   if(key->keyval==GDK_KEY_Down && list_view_text.get_model()->children().size()>0) {
     auto it=list_view_text.get_selection()->get_selected();
@@ -296,8 +600,7 @@ CompletionDialog::CompletionDialog(Gtk::TextView& text_view, Glib::RefPtr<Gtk::T
   auto filter_model=Gtk::TreeModelFilter::create(list_view_text.get_model());  
   if(show_offset==start_mark->get_iter().get_offset()) {
     filter_model->set_visible_func([this, search_key](const Gtk::TreeModel::const_iterator& iter){
-      std::string row_lc;
-      iter->get_value(0, row_lc);
+      auto row_lc=list_view_text.get_row(iter);
       auto search_key_lc=*search_key;
       std::transform(row_lc.begin(), row_lc.end(), row_lc.begin(), ::tolower);
       std::transform(search_key_lc.begin(), search_key_lc.end(), search_key_lc.begin(), ::tolower);
@@ -308,9 +611,7 @@ CompletionDialog::CompletionDialog(Gtk::TextView& text_view, Glib::RefPtr<Gtk::T
   }
   else {
     filter_model->set_visible_func([this, search_key](const Gtk::TreeModel::const_iterator& iter){
-      std::string row;
-      iter->get_value(0, row);
-      if(row.find(*search_key)==0)
+      if(list_view_text.get_row(iter).find(*search_key)==0)
         return true;
       return false;
     });
@@ -338,8 +639,7 @@ void CompletionDialog::select(bool hide_window) {
   
   auto it=list_view_text.get_selection()->get_selected();
   if(on_select && it) {
-    std::string row;
-    it->get_value(0, row);
+    auto row=list_view_text.get_row(it);
     on_select(row, hide_window);
   }
   if(hide_window)
@@ -2,24 +2,70 @@
 #define JUCI_SELECTIONDIALOG_H_
 
 #include "gtkmm.h"
+#include "dispatcher.h"
 #include <unordered_map>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 class SelectionDialogBase {
+protected:
+  class Row {
+  public:
+    Row() {}
+    std::string text;
+    ///Lower case plain text of text, used when filtering. Only set if show_search_entry is true.
+    std::string search_text;
+  };
+  
+  ///Append-only storage of the rows, read by the tree models and the filter thread.
+  ///Rows are stored in chunks that are never moved, and are added from the main thread only.
+  class Rows {
+  public:
+    static const size_t chunk_size=1024;
+    Rows() : size(0) {}
+    void emplace_back(std::string &&text, std::string &&search_text);
+    ///Only used in the main thread
+    const Row &operator[](size_t index) const {return chunks[index/chunk_size][index%chunk_size];}
+    ///Rows below the returned size can be read from other threads through get_chunks
+    size_t get_size() const {return size;}
+    ///Returns the chunks of chunk_size rows, the rows below a previously returned get_size() are stored
+    std::vector<const Row*> get_chunks();
+  private:
+    std::vector<std::unique_ptr<Row[]> > chunks;
+    std::mutex chunks_mutex;
+    std::atomic<size_t> size;
+  };
+  
+private:
   class ListViewText : public Gtk::TreeView {
     class ColumnRecord : public Gtk::TreeModel::ColumnRecord {
     public:
       ColumnRecord() {
-        add(text);
+        add(index);
       }
-      Gtk::TreeModelColumn<std::string> text;
+      ///Index in rows, the text of a row is only stored in rows
+      Gtk::TreeModelColumn<size_t> index;
     };
   public:
     bool use_markup;
-    ListViewText(bool use_markup);
-    void append(const std::string& value);
+    ///If set, rows are plain text and get_markup returns the markup of the rows that are drawn
+    std::function<std::string(const std::string &row)> get_markup;
+    ListViewText(const Rows &rows, bool use_markup);
+    void append(size_t index);
+    ///Shows the rows with the given indices in a new model instead of the appended rows
+    void set_rows(const std::vector<size_t> &indices);
+    ///Shows the appended rows again after set_rows
+    void set_appended_rows();
     void clear();
+    size_t get_index(const Gtk::TreeModel::const_iterator &iter);
+    const std::string &get_row(const Gtk::TreeModel::const_iterator &iter);
   private:
+    const Rows &rows;
     Glib::RefPtr<Gtk::ListStore> list_store;
+    Glib::RefPtr<Gtk::ListStore> rows_list_store;
     ColumnRecord column_record;
     Gtk::CellRendererText cell_renderer;
   };
@@ -32,8 +78,16 @@ class SelectionDialogBase {
   
 public:
   SelectionDialogBase(Gtk::TextView& text_view, Glib::RefPtr<Gtk::TextBuffer::Mark> start_mark, bool show_search_entry, bool use_markup);
-  ~SelectionDialogBase();
+  virtual ~SelectionDialogBase();
   void add_row(const std::string& row);
+  ///Returns false if the producer should stop, for instance when the dialog is destroyed
+  typedef std::function<bool(std::string &&row)> AddRow;
+  ///Calls producer in a separate thread. Its rows are added in batches, also while the dialog is shown.
+  void add_rows_async(std::function<void(const AddRow &add_row)> &&producer);
+  ///Called after the last rows from add_rows_async are added
+  std::function<void()> on_rows_finished;
+  ///Rows are plain text, and get_markup is only called for the rows that are drawn
+  void set_row_markup(std::function<std::string(const std::string &row)> &&get_markup);
   void set_cursor_at_last_row();
   void show();
   void hide();
@@ -46,9 +100,12 @@ public:
   bool shown=false;
 protected:
   void cursor_changed();
+  ///Called after a batch of rows from add_rows_async is added
+  virtual void rows_added() {}
   
   void resize();
   Gtk::TextView& text_view;
+  Rows rows;
   Gtk::Window window;
   Gtk::VBox vbox;
   Gtk::ScrolledWindow scrolled_window;
@@ -57,12 +114,43 @@ protected:
   bool show_search_entry;
   
   std::string last_row;
+  
+  std::string get_search_text(const std::string &row);
+  
+  ///Set to true when the dialog is destroyed, the thread running the producer is not joined
+  std::shared_ptr<std::atomic<bool> > rows_producer_stop;
 };
 
 class SelectionDialog : public SelectionDialogBase {
 public:
   SelectionDialog(Gtk::TextView& text_view, Glib::RefPtr<Gtk::TextBuffer::Mark> start_mark, bool show_search_entry=true, bool use_markup=false);
+  ~SelectionDialog();
   bool on_key_press(GdkEventKey* key);
+  
+  ///Maximum number of rows shown while filtering
+  static const size_t max_filtered_rows=1000;
+protected:
+  void rows_added() override;
+private:
+  ///Filters the rows with key in filter_thread. If cancel is false, a filtering that is already running is completed first.
+  void filter_start(std::string &&key, bool cancel);
+  ///Returns 0 if the characters of key are not found in order in text, otherwise a score where a higher score is a better match
+  static size_t fuzzy_score(const std::string &text, const std::string &key);
+  ///Runs in filter_thread, and scores the rows in parallel if there are many rows
+  void filter(const std::string &key, size_t generation, bool keep_cursor);
+  typedef std::pair<size_t, size_t> Match; //score and row index
+  ///The key, best matches and number of scored rows of the last completed filtering
+  std::string filtered_key;
+  std::vector<Match> filtered_matches;
+  size_t filtered_rows_size=0;
+  Dispatcher filter_dispatcher;
+  std::thread filter_thread;
+  std::mutex filter_mutex;
+  std::condition_variable filter_condition_variable;
+  std::unique_ptr<std::string> filter_key;
+  bool filter_keep_cursor=false;
+  std::atomic<size_t> filter_generation;
+  bool filter_stop=false;
 };
 
 class CompletionDialog : public SelectionDialogBase {
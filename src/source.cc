@@ -4,6 +4,7 @@
 #include "terminal.h"
 #include "info.h"
 #include "directories.h"
+#include "word_index.h"
 #include <gtksourceview/gtksource.h>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/spirit/home/qi/char.hpp>
@@ -89,7 +90,7 @@ const std::regex Source::View::bracket_regex("^([ \\t]*).*\\{ *$");
 const std::regex Source::View::no_bracket_statement_regex("^([ \\t]*)(if|for|else if|while) *\\(.*[^;}] *$");
 const std::regex Source::View::no_bracket_no_para_statement_regex("^([ \\t]*)(else) *$");
 
-Source::View::View(const boost::filesystem::path &file_path, Glib::RefPtr<Gsv::Language> language): Gsv::View(), SpellCheckView(), DiffView(file_path), language(language) {
+Source::View::View(const boost::filesystem::path &file_path, Glib::RefPtr<Gsv::Language> language): Gsv::View(), SnapshotView(), SpellCheckView(), DiffView(file_path), language(language) {
   get_source_buffer()->begin_not_undoable_action();
   last_read_time=std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
   if(language) {
@@ -107,16 +108,23 @@ Source::View::View(const boost::filesystem::path &file_path, Glib::RefPtr<Gsv::L
   search_settings = gtk_source_search_settings_new();
   gtk_source_search_settings_set_wrap_around(search_settings, true);
   search_context = gtk_source_search_context_new(get_source_buffer()->gobj(), search_settings);
-  gtk_source_search_context_set_highlight(search_context, true);
-  //TODO: why does this not work?: Might be best to use the styles from sourceview. These has to be read from file, search-matches got style "search-match"
-  //TODO: in header if trying again: GtkSourceStyle* search_match_style;
-  //TODO: We can drop this, only work on newer versions of gtksourceview.
-  //search_match_style=(GtkSourceStyle*)g_object_new(GTK_SOURCE_TYPE_STYLE, "background-set", 1, "background", "#00FF00", nullptr);
-  //gtk_source_search_context_set_match_style(search_context, search_match_style);
+  //Matches are highlighted by search_start() instead, since GtkSourceSearchContext scans the whole buffer in the main thread.
+  //For the same reason, the search text of search_context is only set while navigating or replacing, see search_context_begin().
+  gtk_source_search_context_set_highlight(search_context, false);
   
-  //TODO: either use lambda if possible or create a gtkmm wrapper around search_context (including search_settings):
-  //TODO: (gtkmm's Gtk::Object has connect_property_changed, so subclassing this might be an idea)
-  g_signal_connect(search_context, "notify::occurrences-count", G_CALLBACK(search_occurrences_updated), this);
+  search_match_tag=get_buffer()->create_tag("search_match");
+  get_buffer()->signal_changed().connect([this] {
+    if(search_text.empty())
+      return;
+    ++search_generation;
+    delayed_search_connection.disconnect();
+    delayed_search_connection=Glib::signal_timeout().connect([this]() {
+      search_start();
+      return false;
+    }, 100);
+  });
+  
+  search_generation=0;
   
   get_buffer()->create_tag("def:warning");
   get_buffer()->create_tag("def:warning_underline");
@@ -139,6 +147,16 @@ Source::View::View(const boost::filesystem::path &file_path, Glib::RefPtr<Gsv::L
   rgba.set_blue(1.0);
   mark_attr_debug_stop->set_background(rgba);
   set_mark_attributes("debug_stop", mark_attr_debug_stop, 101);
+  //Lines sampled by Debug Profile, the most sampled lines in debug_profile_3
+  for(int level=1;level<=3;++level) {
+    auto mark_attr_debug_profile=Gsv::MarkAttributes::create();
+    rgba.set_red(1.0);
+    rgba.set_green(0.6);
+    rgba.set_blue(0.0);
+    rgba.set_alpha(0.15*level);
+    mark_attr_debug_profile->set_background(rgba);
+    set_mark_attributes("debug_profile_"+std::to_string(level), mark_attr_debug_profile, 90+level);
+  }
   
   get_buffer()->signal_changed().connect([this](){
     set_info(info);
@@ -439,6 +457,7 @@ bool Source::View::save(const std::vector<Source::View*> &views) {
     last_read_time=std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
     get_buffer()->set_modified(false);
     Directories::get().on_save_file(file_path);
+    WordIndex::get().update(file_path);
     return true;
   }
   else {
@@ -522,6 +541,14 @@ void Source::View::configure() {
   }
   //TODO: clear tag_class and param_spec?
 
+  style=scheme->get_style("search-match");
+  if(style && style->property_background_set())
+    search_match_tag->property_background()=style->property_background();
+  else
+    search_match_tag->property_background()="#FFFF00";
+  if(style && style->property_foreground_set())
+    search_match_tag->property_foreground()=style->property_foreground();
+  
   //Add tooltip foreground and background
   style = scheme->get_style("def:note");
   auto note_tag=get_buffer()->get_tag_table()->lookup("def:note_background");
@@ -541,7 +568,7 @@ void Source::View::set_tooltip_and_dialog_events() {
   
   signal_motion_notify_event().connect([this](GdkEventMotion* event) {
     if(on_motion_last_x!=event->x || on_motion_last_y!=event->y) {
-      delayed_tooltips_connection.disconnect();
+      hide_tooltips();
       if((event->state&GDK_BUTTON1_MASK)==0) {
         gdouble x=event->x;
         gdouble y=event->y;
@@ -555,8 +582,6 @@ void Source::View::set_tooltip_and_dialog_events() {
           return false;
         }, 100);
       }
-      type_tooltips.hide();
-      diagnostic_tooltips.hide();
     }
     on_motion_last_x=event->x;
     on_motion_last_y=event->y;
@@ -611,13 +636,8 @@ void Source::View::set_tooltip_and_dialog_events() {
   });
 }
 
-void Source::View::search_occurrences_updated(GtkWidget* widget, GParamSpec* property, gpointer data) {
-  auto view=static_cast<Source::View*>(data);
-  if(view->update_search_occurrences)
-    view->update_search_occurrences(gtk_source_search_context_get_occurrences_count(view->search_context));
-}
-
 Source::View::~View() {
+  search_thread_stop();
   g_clear_object(&search_context);
   g_clear_object(&search_settings);
   
@@ -625,11 +645,210 @@ Source::View::~View() {
   renderer_activate_connection.disconnect();
 }
 
+void Source::View::search_thread_stop() {
+  search_dispatcher.disconnect();
+  delayed_search_connection.disconnect();
+  ++search_generation;
+  {
+    std::unique_lock<std::mutex> lock(search_mutex);
+    search_stop=true;
+  }
+  search_condition_variable.notify_one();
+  if(search_thread.joinable())
+    search_thread.join();
+}
+
 void Source::View::search_highlight(const std::string &text, bool case_sensitive, bool regex) {
-  gtk_source_search_settings_set_case_sensitive(search_settings, case_sensitive);
-  gtk_source_search_settings_set_regex_enabled(search_settings, regex);
-  gtk_source_search_settings_set_search_text(search_settings, text.c_str());
-  search_occurrences_updated(nullptr, nullptr, this);
+  search_text=text;
+  search_case_sensitive=case_sensitive;
+  search_regex=regex;
+  delayed_search_connection.disconnect();
+  search_start();
+}
+
+std::shared_ptr<GRegex> Source::View::get_search_regex() {
+  auto key=std::string(search_case_sensitive?"1":"0")+(search_regex?"1":"0")+search_text;
+  if(search_compiled_regex && key==search_compiled_regex_key)
+    return search_compiled_regex;
+  
+  int flags=G_REGEX_MULTILINE|G_REGEX_OPTIMIZE;
+  if(!search_case_sensitive)
+    flags|=G_REGEX_CASELESS;
+  GRegex *regex;
+  if(search_regex)
+    regex=g_regex_new(search_text.c_str(), static_cast<GRegexCompileFlags>(flags), static_cast<GRegexMatchFlags>(0), nullptr);
+  else {
+    auto escaped_text=g_regex_escape_string(search_text.c_str(), -1);
+    regex=g_regex_new(escaped_text, static_cast<GRegexCompileFlags>(flags), static_cast<GRegexMatchFlags>(0), nullptr);
+    g_free(escaped_text);
+  }
+  
+  search_compiled_regex_key=key;
+  if(regex)
+    search_compiled_regex=std::shared_ptr<GRegex>(regex, [](GRegex *regex) {
+      g_regex_unref(regex);
+    });
+  else
+    search_compiled_regex=nullptr;
+  return search_compiled_regex;
+}
+
+void Source::View::search_context_begin() {
+  gtk_source_search_settings_set_case_sensitive(search_settings, search_case_sensitive);
+  gtk_source_search_settings_set_regex_enabled(search_settings, search_regex);
+  gtk_source_search_settings_set_search_text(search_settings, search_text.c_str());
+}
+
+void Source::View::search_context_end() {
+  gtk_source_search_settings_set_search_text(search_settings, nullptr);
+}
+
+void Source::View::search_start() {
+  if(search_stop)
+    return;
+  if(!search_thread.joinable()) {
+    search_thread=std::thread([this]() {
+      while(true) {
+        std::unique_ptr<SearchJob> job;
+        {
+          std::unique_lock<std::mutex> lock(search_mutex);
+          search_condition_variable.wait(lock, [this] {
+            return search_stop || search_job;
+          });
+          if(search_stop)
+            return;
+          job=std::move(search_job);
+        }
+        search_matches(*job);
+      }
+    });
+  }
+  
+  auto generation=++search_generation;
+  get_buffer()->remove_tag(search_match_tag, get_buffer()->begin(), get_buffer()->end());
+  
+  std::shared_ptr<GRegex> regex;
+  if(!search_text.empty())
+    regex=get_search_regex();
+  if(!regex) {
+    if(update_search_occurrences)
+      update_search_occurrences(0);
+    return;
+  }
+  
+  auto job=std::make_unique<SearchJob>();
+  job->generation=generation;
+  //The text of the snapshot is put together in search_thread
+  job->buffer=get_snapshot();
+  job->regex=regex;
+  Gdk::Rectangle visible_rect;
+  get_visible_rect(visible_rect);
+  Gtk::TextIter iter;
+  int line_top;
+  get_line_at_y(iter, visible_rect.get_y(), line_top);
+  job->visible_start_line=iter.get_line();
+  get_line_at_y(iter, visible_rect.get_y()+visible_rect.get_height(), line_top);
+  job->visible_end_line=iter.get_line();
+  
+  {
+    std::unique_lock<std::mutex> lock(search_mutex);
+    search_job=std::move(job);
+  }
+  search_condition_variable.notify_one();
+}
+
+///Finds the matches in the visible lines first, then in the whole buffer while updating the number of occurrences.
+///Runs in search_thread.
+void Source::View::search_matches(const SearchJob &job) {
+  typedef std::vector<std::pair<std::pair<int, int>, std::pair<int, int> > > Matches;
+  const auto &buffer=job.buffer.str();
+  
+  //Converts increasing byte offsets to line and line index
+  class LineIndex {
+  public:
+    LineIndex(const std::string &buffer) : buffer(buffer) {}
+    std::pair<int, int> get(size_t offset) {
+      for(;pos<offset;++pos) {
+        if(buffer[pos]=='\n') {
+          ++line;
+          line_start=pos+1;
+        }
+      }
+      return {line, static_cast<int>(offset-line_start)};
+    }
+    size_t get_line_offset(int line_nr) {
+      while(line<line_nr && pos<buffer.size()) {
+        if(buffer[pos]=='\n') {
+          ++line;
+          line_start=pos+1;
+        }
+        ++pos;
+      }
+      if(line<line_nr)
+        return buffer.size();
+      return line_start;
+    }
+  private:
+    const std::string &buffer;
+    size_t pos=0;
+    int line=0;
+    size_t line_start=0;
+  };
+  
+  auto post=[this, &job](const std::shared_ptr<Matches> &matches, int occurrences) {
+    auto generation=job.generation;
+    search_dispatcher.post("Search matches", [this, generation, matches, occurrences] {
+      if(generation!=search_generation)
+        return;
+      for(auto &match: *matches)
+        get_buffer()->apply_tag(search_match_tag, get_buffer()->get_iter_at_line_index(match.first.first, match.first.second),
+                                get_buffer()->get_iter_at_line_index(match.second.first, match.second.second));
+      if(occurrences>=0 && update_search_occurrences)
+        update_search_occurrences(occurrences);
+    });
+  };
+  
+  //Returns false if a newer search has been started. Matches between skip_start and skip_end are counted, but not tagged.
+  auto find=[this, &job, &buffer, &post](LineIndex &line_index, size_t start, size_t end, bool count, size_t skip_start, size_t skip_end) {
+    auto matches=std::make_shared<Matches>();
+    int occurrences=0;
+    GMatchInfo *match_info=nullptr;
+    g_regex_match_full(job.regex.get(), buffer.c_str(), end, start, static_cast<GRegexMatchFlags>(0), &match_info, nullptr);
+    while(g_match_info_matches(match_info)) {
+      if(job.generation!=search_generation) {
+        g_match_info_free(match_info);
+        return false;
+      }
+      gint match_start, match_end;
+      g_match_info_fetch_pos(match_info, 0, &match_start, &match_end);
+      if(match_end>match_start) {
+        ++occurrences;
+        if(static_cast<size_t>(match_start)<skip_start || static_cast<size_t>(match_end)>skip_end) {
+          auto match_start_index=line_index.get(match_start);
+          matches->emplace_back(match_start_index, line_index.get(match_end));
+          if(matches->size()>=1000) {
+            post(matches, count?occurrences:-1);
+            matches=std::make_shared<Matches>();
+          }
+        }
+      }
+      g_match_info_next(match_info, nullptr);
+    }
+    g_match_info_free(match_info);
+    post(matches, count?occurrences:-1);
+    return true;
+  };
+  
+  LineIndex visible_line_index(buffer);
+  auto visible_start=visible_line_index.get_line_offset(job.visible_start_line);
+  LineIndex visible_end_line_index(buffer);
+  auto visible_end=visible_end_line_index.get_line_offset(job.visible_end_line+1);
+  if(!find(visible_line_index, visible_start, visible_end, false, 0, 0))
+    return;
+  
+  //The matches in the visible lines are already tagged
+  LineIndex line_index(buffer);
+  find(line_index, 0, buffer.size(), true, visible_start, visible_end);
 }
 
 void Source::View::search_forward() {
@@ -637,10 +856,12 @@ void Source::View::search_forward() {
   get_buffer()->get_selection_bounds(insert, selection_bound);
   auto& start=selection_bound;
   Gtk::TextIter match_start, match_end;
+  search_context_begin();
   if(gtk_source_search_context_forward(search_context, start.gobj(), match_start.gobj(), match_end.gobj())) {
     get_buffer()->select_range(match_start, match_end);
     scroll_to(get_buffer()->get_insert());
   }
+  search_context_end();
 }
 
 void Source::View::search_backward() {
@@ -648,10 +869,12 @@ void Source::View::search_backward() {
   get_buffer()->get_selection_bounds(insert, selection_bound);
   auto &start=insert;
   Gtk::TextIter match_start, match_end;
+  search_context_begin();
   if(gtk_source_search_context_backward(search_context, start.gobj(), match_start.gobj(), match_end.gobj())) {
     get_buffer()->select_range(match_start, match_end);
     scroll_to(get_buffer()->get_insert());
   }
+  search_context_end();
 }
 
 void Source::View::replace_forward(const std::string &replacement) {
@@ -659,6 +882,7 @@ void Source::View::replace_forward(const std::string &replacement) {
   get_buffer()->get_selection_bounds(insert, selection_bound);
   auto &start=insert;
   Gtk::TextIter match_start, match_end;
+  search_context_begin();
   if(gtk_source_search_context_forward(search_context, start.gobj(), match_start.gobj(), match_end.gobj())) {
     auto offset=match_start.get_offset();
     gtk_source_search_context_replace(search_context, match_start.gobj(), match_end.gobj(), replacement.c_str(), replacement.size(), nullptr);
@@ -667,6 +891,7 @@ void Source::View::replace_forward(const std::string &replacement) {
     get_buffer()->select_range(get_buffer()->get_iter_at_offset(offset), get_buffer()->get_iter_at_offset(offset+replacement_ustring.size()));
     scroll_to(get_buffer()->get_insert());
   }
+  search_context_end();
 }
 
 void Source::View::replace_backward(const std::string &replacement) {
@@ -674,6 +899,7 @@ void Source::View::replace_backward(const std::string &replacement) {
   get_buffer()->get_selection_bounds(insert, selection_bound);
   auto &start=selection_bound;
   Gtk::TextIter match_start, match_end;
+  search_context_begin();
   if(gtk_source_search_context_backward(search_context, start.gobj(), match_start.gobj(), match_end.gobj())) {
     auto offset=match_start.get_offset();
     gtk_source_search_context_replace(search_context, match_start.gobj(), match_end.gobj(), replacement.c_str(), replacement.size(), nullptr);
@@ -681,10 +907,13 @@ void Source::View::replace_backward(const std::string &replacement) {
     get_buffer()->select_range(get_buffer()->get_iter_at_offset(offset), get_buffer()->get_iter_at_offset(offset+replacement.size()));
     scroll_to(get_buffer()->get_insert());
   }
+  search_context_end();
 }
 
 void Source::View::replace_all(const std::string &replacement) {
+  search_context_begin();
   gtk_source_search_context_replace_all(search_context, replacement.c_str(), replacement.size(), nullptr);
+  search_context_end();
 }
 
 void Source::View::paste() {
@@ -1801,38 +2030,89 @@ Source::GenericView::GenericView(const boost::filesystem::path &file_path, Glib:
   auto completion_words=Gsv::CompletionWords::create("", Glib::RefPtr<Gdk::Pixbuf>());
   completion_words->register_provider(get_buffer());
   completion->add_provider(completion_words);
+  completion->add_provider(ProjectWordsProvider::create(this));
   
   if(language) {
-    auto language_manager=Gsv::LanguageManager::get_default();
-    auto search_paths=language_manager->get_search_path();
-    bool found_language_file=false;
-    boost::filesystem::path language_file;
-    for(auto &search_path: search_paths) {
-      boost::filesystem::path p(static_cast<std::string>(search_path)+'/'+static_cast<std::string>(language->get_id())+".lang");
-      if(boost::filesystem::exists(p) && boost::filesystem::is_regular_file(p)) {
-        language_file=p;
-        found_language_file=true;
-        break;
-      }
-    }
-    if(found_language_file) {
-      auto completion_buffer_keywords=CompletionBuffer::create();
-      boost::property_tree::ptree pt;
-      try {
-        boost::property_tree::xml_parser::read_xml(language_file.string(), pt);
-      }
-      catch(const std::exception &e) {
-        Terminal::get().print("Error: error parsing language file "+language_file.string()+": "+e.what()+'\n', true);
-      }
-      bool has_context_class=false;
-      parse_language_file(completion_buffer_keywords, has_context_class, pt);
-      if(!has_context_class)
+    auto language_data=get_language_data(language);
+    if(language_data->keywords) {
+      if(!language_data->has_context_class)
         spellcheck_all=false;
-      completion_words->register_provider(completion_buffer_keywords);
+      completion->add_provider(language_data->keywords_provider);
     }
   }
 }
 
+std::unordered_map<std::string, std::shared_ptr<Source::GenericView::LanguageData> > Source::GenericView::languages_data;
+
+std::shared_ptr<Source::GenericView::LanguageData> Source::GenericView::get_language_data(Glib::RefPtr<Gsv::Language> language) {
+  auto language_id=static_cast<std::string>(language->get_id());
+  auto it=languages_data.find(language_id);
+  if(it!=languages_data.end())
+    return it->second;
+  
+  auto language_data=std::make_shared<LanguageData>();
+  languages_data.emplace(language_id, language_data);
+  
+  auto language_manager=Gsv::LanguageManager::get_default();
+  auto search_paths=language_manager->get_search_path();
+  bool found_language_file=false;
+  boost::filesystem::path language_file;
+  for(auto &search_path: search_paths) {
+    boost::filesystem::path p(static_cast<std::string>(search_path)+'/'+language_id+".lang");
+    if(boost::filesystem::exists(p) && boost::filesystem::is_regular_file(p)) {
+      language_file=p;
+      found_language_file=true;
+      break;
+    }
+  }
+  if(found_language_file) {
+    language_data->keywords=CompletionBuffer::create();
+    boost::property_tree::ptree pt;
+    try {
+      boost::property_tree::xml_parser::read_xml(language_file.string(), pt);
+    }
+    catch(const std::exception &e) {
+      Terminal::get().print("Error: error parsing language file "+language_file.string()+": "+e.what()+'\n', true);
+    }
+    parse_language_file(language_data->keywords, language_data->has_context_class, pt);
+    //A buffer can only be registered with one words provider, so the provider is shared instead of the buffer
+    language_data->keywords_provider=Gsv::CompletionWords::create("", Glib::RefPtr<Gdk::Pixbuf>());
+    language_data->keywords_provider->register_provider(language_data->keywords);
+  }
+  return language_data;
+}
+
+Source::GenericView::ProjectWordsProvider::ProjectWordsProvider(GenericView *view) :
+  Glib::ObjectBase(typeid(ProjectWordsProvider)), Glib::Object(), Gsv::CompletionProvider(), view(view) {}
+
+Glib::ustring Source::GenericView::ProjectWordsProvider::get_name_vfunc() const {
+  return "Project words";
+}
+
+void Source::GenericView::ProjectWordsProvider::populate_vfunc(const Glib::RefPtr<Gsv::CompletionContext> &context) {
+  std::vector<Glib::RefPtr<Gsv::CompletionProposal> > proposals;
+  auto end_iter=context->get_iter();
+  auto start_iter=end_iter;
+  while(start_iter.backward_char() && (*start_iter=='_' || Glib::Unicode::isalnum(*start_iter))) {}
+  if(!(*start_iter=='_' || Glib::Unicode::isalnum(*start_iter)))
+    start_iter.forward_char();
+  auto prefix=view->get_buffer()->get_text(start_iter, end_iter).raw();
+  if(prefix.size()>=2) {
+    std::unique_lock<std::mutex> lock(view->file_path_mutex);
+    auto file_path=view->file_path;
+    lock.unlock();
+    auto language_id=view->language?view->language->get_id().raw():std::string();
+    for(auto &word: WordIndex::get().get_words(prefix, 100, language_id, file_path))
+      proposals.emplace_back(Gsv::CompletionItem::create(word, word, Glib::RefPtr<Gdk::Pixbuf>(), ""));
+  }
+  reference();
+  context->add_proposals(Glib::RefPtr<Gsv::CompletionProvider>(this), proposals, true);
+}
+
+int Source::GenericView::ProjectWordsProvider::get_priority_vfunc() const {
+  return -1;
+}
+
 void Source::GenericView::parse_language_file(Glib::RefPtr<CompletionBuffer> &completion_buffer, bool &has_context_class, const boost::property_tree::ptree &pt) {
   bool case_insensitive=false;
   for(auto &node: pt) {
@@ -9,6 +9,8 @@
 #include <unordered_map>
 #include <vector>
 #include <regex>
+#include <condition_variable>
+#include <chrono>
 
 namespace Source {
   Glib::RefPtr<Gsv::Language> guess_language(const boost::filesystem::path &file_path);
@@ -69,6 +71,9 @@ namespace Source {
     std::function<std::vector<std::pair<boost::filesystem::path, size_t> >(const std::vector<Source::View*> &views, const std::string &text)> rename_similar_tokens;
     std::function<void()> goto_next_diagnostic;
     std::function<std::vector<FixIt>()> get_fix_its;
+    std::function<void()> toggle_optimization_remarks;
+    std::function<void()> show_record_layout;
+    std::function<void(const std::vector<Source::View*> &views)> show_record_layouts_report;
     std::function<void()> toggle_comments;
     std::function<void()> add_documentation;
     std::function<void(int)> toggle_breakpoint;
@@ -91,6 +96,20 @@ namespace Source {
     std::string status;
     std::string info;
     
+    ///Measurements shown in the performance HUD
+    class Performance {
+    public:
+      ///Time from the start of the last parse until its result was shown
+      std::chrono::steady_clock::duration parse_duration=std::chrono::steady_clock::duration::zero();
+      size_t parses=0;
+      ///Time from the start of the last completion until the completion dialog was shown
+      std::chrono::steady_clock::duration completion_latency=std::chrono::steady_clock::duration::zero();
+      size_t completions=0;
+    };
+    Performance performance;
+    ///Returns the memory used by the translation unit in bytes, or 0 if not known
+    std::function<size_t()> get_translation_unit_memory;
+    
     void set_tab_char_and_size(char tab_char, unsigned tab_size);
     std::pair<char, unsigned> get_tab_char_and_size() {return {tab_char, tab_size};}
     
@@ -146,13 +165,46 @@ namespace Source {
     std::string tab;
     
     guint previous_non_modifier_keyval=0;
+    
+    ///Stops the search thread. Must be called before the view is deleted in another thread.
+    void search_thread_stop();
   private:
     void cleanup_whitespace_characters();
     Gsv::DrawSpacesFlags parse_show_whitespace_characters(const std::string &text);
     
     GtkSourceSearchContext *search_context;
     GtkSourceSearchSettings *search_settings;
-    static void search_occurrences_updated(GtkWidget* widget, GParamSpec* property, gpointer data);
+    ///Sets the search settings of search_context from search_text, search_case_sensitive and search_regex
+    void search_context_begin();
+    ///Clears the search text of search_context, so that it stops scanning the buffer
+    void search_context_end();
+    
+    class SearchJob {
+    public:
+      size_t generation;
+      Snapshot buffer;
+      std::shared_ptr<GRegex> regex;
+      int visible_start_line;
+      int visible_end_line;
+    };
+    std::string search_text;
+    bool search_case_sensitive=false;
+    bool search_regex=false;
+    Glib::RefPtr<Gtk::TextTag> search_match_tag;
+    ///Last compiled regex, reused as long as the search text and options are unchanged
+    std::shared_ptr<GRegex> search_compiled_regex;
+    std::string search_compiled_regex_key;
+    std::shared_ptr<GRegex> get_search_regex();
+    void search_start();
+    void search_matches(const SearchJob &job);
+    Dispatcher search_dispatcher;
+    std::thread search_thread;
+    std::mutex search_mutex;
+    std::condition_variable search_condition_variable;
+    std::unique_ptr<SearchJob> search_job;
+    std::atomic<size_t> search_generation;
+    bool search_stop=false;
+    sigc::connection delayed_search_connection;
     
     sigc::connection renderer_activate_connection;
   };
@@ -163,10 +215,34 @@ namespace Source {
     public:
       static Glib::RefPtr<CompletionBuffer> create() {return Glib::RefPtr<CompletionBuffer>(new CompletionBuffer());}
     };
+    
+    ///Language file data, parsed once per language and shared between the views
+    class LanguageData {
+    public:
+      Glib::RefPtr<CompletionBuffer> keywords;
+      ///Completes the keywords, added to the completion of every view of the language
+      Glib::RefPtr<Gsv::CompletionWords> keywords_provider;
+      bool has_context_class=false;
+    };
+    static std::unordered_map<std::string, std::shared_ptr<LanguageData> > languages_data;
+    static std::shared_ptr<LanguageData> get_language_data(Glib::RefPtr<Gsv::Language> language);
+    
+    ///Completes words from the other files in the project, see WordIndex
+    class ProjectWordsProvider : public Glib::Object, public Gsv::CompletionProvider {
+      ProjectWordsProvider(GenericView *view);
+    public:
+      static Glib::RefPtr<ProjectWordsProvider> create(GenericView *view) {return Glib::RefPtr<ProjectWordsProvider>(new ProjectWordsProvider(view));}
+    protected:
+      Glib::ustring get_name_vfunc() const override;
+      void populate_vfunc(const Glib::RefPtr<Gsv::CompletionContext> &context) override;
+      int get_priority_vfunc() const override;
+    private:
+      GenericView *view;
+    };
   public:
     GenericView(const boost::filesystem::path &file_path, Glib::RefPtr<Gsv::Language> language);
     
-    void parse_language_file(Glib::RefPtr<CompletionBuffer> &completion_buffer, bool &has_context_class, const boost::property_tree::ptree &pt);
+    static void parse_language_file(Glib::RefPtr<CompletionBuffer> &completion_buffer, bool &has_context_class, const boost::property_tree::ptree &pt);
   };
 }
 #endif  // JUCI_SOURCE_H_
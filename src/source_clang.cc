@@ -8,6 +8,10 @@
 #include "info.h"
 #include "dialogs.h"
 #include "ctags.h"
+#include "trace.h"
+#include "filesystem.h"
+#include <sstream>
+#include <algorithm>
 
 namespace sigc {
 #ifndef SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
@@ -27,14 +31,65 @@ clang::Index Source::ClangViewParse::clang_index(0, 0);
 
 Source::ClangViewParse::ClangViewParse(const boost::filesystem::path &file_path, Glib::RefPtr<Gsv::Language> language):
     Source::View(file_path, language) {
+  parse_generation=0;
+  type_tooltips_generation=0;
+  type_tooltips_thread=std::thread([this]() {
+    while(true) {
+      std::unique_ptr<TypeTooltipsRequest> request;
+      {
+        std::unique_lock<std::mutex> lock(type_tooltips_mutex);
+        type_tooltips_condition_variable.wait(lock, [this] {
+          return type_tooltips_stop || type_tooltips_request;
+        });
+        if(type_tooltips_stop)
+          return;
+        request=std::move(type_tooltips_request);
+      }
+      get_type_tooltips(*request);
+    }
+  });
+  
   auto tag_table=get_buffer()->get_tag_table();
   for (auto &item : Config::get().source.clang_types) {
     if(!tag_table->lookup(item.second)) {
       get_buffer()->create_tag(item.second);
     }
   }
+  auto tag=get_buffer()->create_tag("optimization_remark_missed");
+  tag->property_underline()=Pango::Underline::UNDERLINE_ERROR;
+#if GTK_VERSION_GE(3, 16)
+  tag->set_property("underline-rgba", Gdk::RGBA("#ff8800"));
+#endif
+  tag=get_buffer()->create_tag("optimization_remark_passed");
+  tag->property_underline()=Pango::Underline::UNDERLINE_SINGLE;
+#if GTK_VERSION_GE(3, 16)
+  tag->set_property("underline-rgba", Gdk::RGBA("#00aa00"));
+#endif
   configure();
   
+  toggle_optimization_remarks=[this] {
+    optimization_remarks_enabled=!optimization_remarks_enabled;
+    if(optimization_remarks_enabled)
+      optimization_remarks_start();
+    else {
+      optimization_remarks_pending=false;
+      update_optimization_remarks({});
+    }
+  };
+  
+  get_translation_unit_memory=[this]() -> size_t {
+    //The last value is returned while the translation unit is in use
+    std::unique_lock<std::mutex> parse_lock(parse_mutex, std::defer_lock);
+    if(!parse_lock.try_lock() || !clang_tu)
+      return translation_unit_memory;
+    auto usage=clang_getCXTUResourceUsage(clang_tu->cx_tu);
+    translation_unit_memory=0;
+    for(unsigned c=0;c<usage.numEntries;++c)
+      translation_unit_memory+=usage.entries[c].amount;
+    clang_disposeCXTUResourceUsage(usage);
+    return translation_unit_memory;
+  };
+  
   parsing_in_progress=Terminal::get().print_in_progress("Parsing "+file_path.string());
   parse_initialize();
   
@@ -55,6 +110,8 @@ bool Source::ClangViewParse::save(const std::vector<Source::View*> &views) {
       }
     }
   }
+  if(optimization_remarks_enabled)
+    optimization_remarks_start();
   return true;
 }
 
@@ -91,25 +148,62 @@ void Source::ClangViewParse::parse_initialize() {
   parse_state=ParseState::PROCESSING;
   parse_process_state=ParseProcessState::STARTING;
   
-  auto buffer=get_buffer()->get_text();
-  //Remove includes for first parse for initial syntax highlighting
-  std::size_t pos=0;
-  while((pos=buffer.find("#include", pos))!=std::string::npos) {
-    auto start_pos=pos;
-    pos=buffer.find('\n', pos+8);
-    if(pos==std::string::npos)
-      break;
-    if(start_pos==0 || buffer[start_pos-1]=='\n') {
-      buffer.replace(start_pos, pos-start_pos, pos-start_pos, ' ');
-    }
-    pos++;
-  }
-  clang_tu = std::make_unique<clang::TranslationUnit>(clang_index, file_path.string(), get_compilation_commands(), buffer.raw());
-  clang_tokens=clang_tu->get_tokens(0, buffer.bytes()-1);
-  update_syntax();
+  //The text is copied and the includes are removed in parse_thread
+  auto snapshot=get_snapshot();
+  
+  std::shared_ptr<Project::Build> build=Project::Build::create(file_path);
+  if(build->project_path.empty())
+    Info::get().print(file_path.filename().string()+": could not find a supported build system");
   
   set_status("parsing...");
-  parse_thread=std::thread([this]() {
+  parse_thread=std::thread([this, snapshot, build]() {
+    auto parse_start_time=std::chrono::steady_clock::now();
+    auto buffer=snapshot.str();
+    //Remove includes for first parse for initial syntax highlighting
+    std::size_t pos=0;
+    while((pos=buffer.find("#include", pos))!=std::string::npos) {
+      auto start_pos=pos;
+      pos=buffer.find('\n', pos+8);
+      if(pos==std::string::npos)
+        break;
+      if(start_pos==0 || buffer[start_pos-1]=='\n') {
+        buffer.replace(start_pos, pos-start_pos, pos-start_pos, ' ');
+      }
+      pos++;
+    }
+    
+    boost::filesystem::path file_path;
+    {
+      std::unique_lock<std::mutex> lock(file_path_mutex);
+      file_path=this->file_path;
+    }
+    //The first parse is done here, so that the view is shown before cmake is run, the compilation database is read and the translation unit is created
+    build->update_default(false, true);
+    auto default_build_path=build->get_default_path();
+    {
+      std::unique_lock<std::mutex> parse_lock(parse_mutex);
+      {
+        TRACE_SCOPE("clang::TranslationUnit", file_path.filename().string());
+        clang_tu = std::make_unique<clang::TranslationUnit>(clang_index, file_path.string(), get_compilation_commands(file_path, default_build_path), buffer);
+      }
+      {
+        TRACE_SCOPE("get_tokens", file_path.filename().string());
+        clang_tokens=clang_tu->get_tokens(0, buffer.size()-1);
+      }
+      parse_thread_function_definitions=get_function_definitions(*clang_tokens);
+    }
+    if(parse_state==ParseState::PROCESSING) {
+      dispatcher.post("Clang parse", [this, parse_start_time] {
+        std::unique_lock<std::mutex> parse_lock(parse_mutex, std::defer_lock);
+        if(parse_lock.try_lock()) {
+          function_definitions=std::move(parse_thread_function_definitions);
+          update_syntax();
+          performance.parse_duration=std::chrono::steady_clock::now()-parse_start_time;
+          ++performance.parses;
+        }
+      });
+    }
+    
     while(true) {
       while(parse_state==ParseState::PROCESSING && parse_process_state!=ParseProcessState::STARTING && parse_process_state!=ParseProcessState::PROCESSING)
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -118,12 +212,12 @@ void Source::ClangViewParse::parse_initialize() {
       auto expected=ParseProcessState::STARTING;
       std::unique_lock<std::mutex> parse_lock(parse_mutex, std::defer_lock);
       if(parse_process_state.compare_exchange_strong(expected, ParseProcessState::PREPROCESSING)) {
-        dispatcher.post([this] {
+        dispatcher.post("Clang reparse preprocess", [this] {
           auto expected=ParseProcessState::PREPROCESSING;
           std::unique_lock<std::mutex> parse_lock(parse_mutex, std::defer_lock);
           if(parse_lock.try_lock()) {
             if(parse_process_state.compare_exchange_strong(expected, ParseProcessState::PROCESSING))
-              parse_thread_buffer=get_buffer()->get_text();
+              parse_thread_buffer=get_snapshot();
             parse_lock.unlock();
           }
           else
@@ -131,21 +225,34 @@ void Source::ClangViewParse::parse_initialize() {
         });
       }
       else if (parse_process_state==ParseProcessState::PROCESSING && parse_lock.try_lock()) {
-        auto status=clang_tu->ReparseTranslationUnit(parse_thread_buffer.raw());
+        auto parse_start_time=std::chrono::steady_clock::now();
+        int status;
+        {
+          TRACE_SCOPE("ReparseTranslationUnit", file_path.filename().string());
+          status=clang_tu->ReparseTranslationUnit(parse_thread_buffer.str());
+        }
         parsing_in_progress->done("done");
         if(status==0) {
           auto expected=ParseProcessState::PROCESSING;
           if(parse_process_state.compare_exchange_strong(expected, ParseProcessState::POSTPROCESSING)) {
-            clang_tokens=clang_tu->get_tokens(0, parse_thread_buffer.bytes()-1);
+            {
+              TRACE_SCOPE("get_tokens", file_path.filename().string());
+              clang_tokens=clang_tu->get_tokens(0, parse_thread_buffer.size()-1);
+            }
+            parse_thread_function_definitions=get_function_definitions(*clang_tokens);
             diagnostics=clang_tu->get_diagnostics();
+            ++parse_generation;
             parse_lock.unlock();
-            dispatcher.post([this] {
+            dispatcher.post("Clang reparse postprocess", [this, parse_start_time] {
               std::unique_lock<std::mutex> parse_lock(parse_mutex, std::defer_lock);
               if(parse_lock.try_lock()) {
                 auto expected=ParseProcessState::POSTPROCESSING;
                 if(parse_process_state.compare_exchange_strong(expected, ParseProcessState::IDLE)) {
+                  function_definitions=std::move(parse_thread_function_definitions);
                   update_syntax();
                   update_diagnostics();
+                  performance.parse_duration=std::chrono::steady_clock::now()-parse_start_time;
+                  ++performance.parses;
                   parsed=true;
                   set_status("");
                 }
@@ -159,7 +266,7 @@ void Source::ClangViewParse::parse_initialize() {
         else {
           parse_state=ParseState::STOP;
           parse_lock.unlock();
-          dispatcher.post([this] {
+          dispatcher.post("Clang reparse failed", [this] {
             Terminal::get().print("Error: failed to reparse "+this->file_path.string()+".\n", true);
             set_status("");
             set_info("");
@@ -181,18 +288,14 @@ void Source::ClangViewParse::soft_reparse() {
   delayed_reparse_connection=Glib::signal_timeout().connect([this]() {
     parsed=false;
     auto expected=ParseProcessState::IDLE;
-    if(parse_process_state.compare_exchange_strong(expected, ParseProcessState::STARTING))
+    if(parse_process_state.compare_exchange_strong(expected, ParseProcessState::STARTING)) {
       set_status("parsing...");
+    }
     return false;
   }, 1000);
 }
 
-std::vector<std::string> Source::ClangViewParse::get_compilation_commands() {
-  auto build=Project::Build::create(file_path);
-  if(build->project_path.empty())
-    Info::get().print(file_path.filename().string()+": could not find a supported build system");
-  auto default_build_path=build->get_default_path();
-  build->update_default();
+std::vector<std::string> Source::ClangViewParse::get_compilation_commands(const boost::filesystem::path &file_path, const boost::filesystem::path &default_build_path) {
   clang::CompilationDatabase db(default_build_path.string());
   clang::CompileCommands commands(file_path.string(), db);
   std::vector<clang::CompileCommand> cmds = commands.get_commands();
@@ -232,6 +335,7 @@ std::vector<std::string> Source::ClangViewParse::get_compilation_commands() {
 }
 
 void Source::ClangViewParse::update_syntax() {
+  TRACE_SCOPE("update_syntax", file_path.filename().string());
   auto buffer=get_buffer();
   const auto apply_tag=[this, buffer](const std::pair<clang::Offset, clang::Offset> &offsets, int type) {
     auto type_it=Config::get().source.clang_types.find(type);
@@ -268,6 +372,7 @@ void Source::ClangViewParse::update_syntax() {
 }
 
 void Source::ClangViewParse::update_diagnostics() {
+  TRACE_SCOPE("update_diagnostics", file_path.filename().string());
   diagnostic_offsets.clear();
   diagnostic_tooltips.clear();
   fix_its.clear();
@@ -381,6 +486,294 @@ void Source::ClangViewParse::update_diagnostics() {
 
 void Source::ClangViewParse::show_diagnostic_tooltips(const Gdk::Rectangle &rectangle) {
   diagnostic_tooltips.show(rectangle);
+  optimization_remark_tooltips.show(rectangle);
+}
+
+std::vector<std::string> Source::ClangViewParse::get_compile_arguments(const boost::filesystem::path &file_path, const boost::filesystem::path &build_path) {
+  std::vector<std::string> compile_arguments;
+  clang::CompilationDatabase db(build_path.string());
+  clang::CompileCommands commands(file_path.string(), db);
+  auto cmds=commands.get_commands();
+  if(cmds.empty())
+    return compile_arguments;
+  auto arguments=cmds[0].get_command_as_args();
+  if(arguments.empty())
+    return compile_arguments;
+  
+  //Only clang is used, and the source file and output arguments are left to the caller
+  if(boost::filesystem::path(arguments[0]).filename().string().find("clang")!=std::string::npos)
+    compile_arguments.emplace_back(arguments[0]);
+  else
+    compile_arguments.emplace_back(file_path.extension()==".c"?"clang":"clang++");
+  for(size_t c=1;c<arguments.size();++c) {
+    auto &argument=arguments[c];
+    if(argument=="-o" || argument=="-MF" || argument=="-MT" || argument=="-MQ") {
+      ++c;
+      continue;
+    }
+    if(argument=="-c" || argument=="-MD" || argument=="-MMD" ||
+       (!argument.empty() && argument[0]!='-' && boost::filesystem::path(argument).filename()==file_path.filename()))
+      continue;
+    compile_arguments.emplace_back(argument);
+  }
+  return compile_arguments;
+}
+
+std::string Source::ClangViewParse::get_optimization_remarks_command(const boost::filesystem::path &file_path, const boost::filesystem::path &build_path) {
+  auto arguments=get_compile_arguments(file_path, build_path);
+  if(arguments.empty())
+    return std::string();
+  std::string command;
+  for(auto &argument: arguments)
+    command+=(command.empty()?"":" ")+filesystem::escape_argument(argument);
+  command+=" -c "+filesystem::escape_argument(file_path.string())+" -o /dev/null -fno-color-diagnostics -Rpass='.*' -Rpass-missed='.*' -Rpass-analysis='.*'";
+  return command;
+}
+
+std::string Source::ClangViewParse::get_assembly_command(const boost::filesystem::path &file_path, const boost::filesystem::path &build_path) {
+  auto arguments=get_compile_arguments(file_path, build_path);
+  if(arguments.empty())
+    return std::string();
+  std::string command;
+  bool optimized=false;
+  for(auto &argument: arguments) {
+    if(argument.compare(0, 2, "-O")==0)
+      optimized=argument!="-O0";
+    command+=(command.empty()?"":" ")+filesystem::escape_argument(argument);
+  }
+  //Debug builds are shown as they would be compiled in a release build
+  if(!optimized)
+    command+=" -O2";
+  command+=" -S -g -fno-asynchronous-unwind-tables -fno-color-diagnostics "+filesystem::escape_argument(file_path.string())+" -o -";
+  return command;
+}
+
+std::vector<Source::ClangViewParse::AssemblyFunction> Source::ClangViewParse::get_assembly_functions(const std::string &assembly, const boost::filesystem::path &file_path) {
+  const static std::regex file_regex("^\\s*\\.file\\s+([0-9]+)\\s+\"([^\"]*)\"(\\s+\"([^\"]*)\")?.*$");
+  const static std::regex loc_regex("^\\s*\\.loc\\s+([0-9]+)\\s+([0-9]+).*$");
+  const static std::regex label_regex("^([^\\s:#]+):.*$");
+  const static std::regex local_label_regex("^(\\..*|L[A-Za-z_]+[0-9][0-9_]*|ltmp[0-9]+)$");
+  std::set<std::string> file_ids;
+  std::vector<AssemblyFunction> functions;
+  bool in_function=false;
+  int source_line=0;
+  std::stringstream ss(assembly);
+  std::string line;
+  while(std::getline(ss, line)) {
+    if(line.empty())
+      continue;
+    std::smatch sm;
+    if(line[0]!=' ' && line[0]!='\t') {
+      if(!std::regex_match(line, sm, label_regex))
+        continue;
+      auto name=sm[1].str();
+      if(name.compare(0, 10, ".Lfunc_end")==0 || name.compare(0, 9, "Lfunc_end")==0)
+        in_function=false;
+      else if(std::regex_match(name, local_label_regex)) {
+        if(in_function)
+          functions.back().lines.emplace_back(name+':', 0);
+      }
+      else {
+        functions.emplace_back();
+        functions.back().name=name;
+        in_function=true;
+        source_line=0;
+      }
+      continue;
+    }
+    
+    auto start=line.find_first_not_of(" \t");
+    if(start==std::string::npos)
+      continue;
+    if(std::regex_match(line, sm, file_regex)) {
+      auto path=sm[4].matched?boost::filesystem::path(sm[2].str())/sm[4].str():boost::filesystem::path(sm[2].str());
+      if(path.filename()==file_path.filename())
+        file_ids.emplace(sm[1].str());
+      continue;
+    }
+    if(std::regex_match(line, sm, loc_regex)) {
+      source_line=file_ids.count(sm[1].str())>0?std::stoi(sm[2].str()):0;
+      continue;
+    }
+    //Directives and comments
+    if(line[start]=='.' || line[start]=='#' || line[start]==';' || line.compare(start, 2, "//")==0)
+      continue;
+    if(in_function)
+      functions.back().lines.emplace_back(line.substr(start), source_line);
+  }
+  
+  //Global labels of data have no instructions
+  functions.erase(std::remove_if(functions.begin(), functions.end(), [](const AssemblyFunction &function) {
+    return function.lines.empty();
+  }), functions.end());
+  return functions;
+}
+
+std::vector<Source::ClangViewParse::OptimizationRemark> Source::ClangViewParse::get_optimization_remarks(const std::string &output, const boost::filesystem::path &file_path, const boost::filesystem::path &build_path) {
+  const static std::regex remark_regex("^(.+):([0-9]+):([0-9]+): remark: (.*) \\[-Rpass(|-missed|-analysis)=([^\\]]*)\\]$");
+  std::vector<OptimizationRemark> remarks;
+  std::unordered_map<std::string, bool> paths;
+  std::stringstream ss(output);
+  std::string line;
+  while(std::getline(ss, line)) {
+    std::smatch sm;
+    if(std::regex_match(line, sm, remark_regex)) {
+      auto path_it=paths.find(sm[1].str());
+      if(path_it==paths.end()) {
+        boost::filesystem::path path(sm[1].str());
+        if(path.is_relative())
+          path=build_path/path;
+        path_it=paths.emplace(sm[1].str(), path.filename()==file_path.filename() && filesystem::get_canonical_path(path)==file_path).first;
+      }
+      if(!path_it->second)
+        continue;
+      
+      OptimizationRemark remark;
+      remark.line=std::stoi(sm[2].str());
+      remark.index=std::stoi(sm[3].str());
+      if(sm[5].str()=="-missed")
+        remark.kind="missed";
+      else if(sm[5].str()=="-analysis")
+        remark.kind="analysis";
+      else
+        remark.kind="passed";
+      remark.pass=sm[6].str();
+      remark.message=sm[4].str();
+      remarks.emplace_back(std::move(remark));
+    }
+  }
+  return remarks;
+}
+
+void Source::ClangViewParse::optimization_remarks_start() {
+  if(optimization_remarks_running) {
+    optimization_remarks_pending=true;
+    return;
+  }
+  optimization_remarks_running=true;
+  if(optimization_remarks_thread.joinable())
+    optimization_remarks_thread.join();
+  
+  auto file_path=this->file_path;
+  auto build_path=Project::Build::create(file_path)->get_default_path();
+  optimization_remarks_thread=std::thread([this, file_path, build_path] {
+    TRACE_SCOPE("optimization remarks", file_path.filename().string());
+    auto remarks=std::make_shared<std::vector<OptimizationRemark> >();
+    std::string error;
+    auto command=get_optimization_remarks_command(file_path, build_path);
+    if(command.empty())
+      error=file_path.filename().string()+": could not find compile command for optimization remarks";
+    else {
+      std::string output;
+      Process process(command, build_path.string(), nullptr, [&output](const char *bytes, size_t n) {
+        output.append(bytes, n);
+      });
+      auto exit_status=process.get_exit_status();
+      *remarks=get_optimization_remarks(output, file_path, build_path);
+      if(exit_status!=0 && remarks->empty())
+        error=file_path.filename().string()+": compilation with optimization remarks failed";
+    }
+    dispatcher.post("Clang optimization remarks", [this, remarks, error] {
+      optimization_remarks_running=false;
+      if(!error.empty())
+        Info::get().print(error);
+      if(optimization_remarks_enabled)
+        update_optimization_remarks(*remarks);
+      if(optimization_remarks_pending) {
+        optimization_remarks_pending=false;
+        if(optimization_remarks_enabled)
+          optimization_remarks_start();
+      }
+    });
+  });
+}
+
+void Source::ClangViewParse::update_optimization_remarks(const std::vector<OptimizationRemark> &remarks) {
+  optimization_remark_tooltips.clear();
+  get_buffer()->remove_tag_by_name("optimization_remark_missed", get_buffer()->begin(), get_buffer()->end());
+  get_buffer()->remove_tag_by_name("optimization_remark_passed", get_buffer()->begin(), get_buffer()->end());
+  
+  //Remarks at the same position are shown in the same tooltip
+  std::map<std::pair<int, int>, std::vector<const OptimizationRemark*> > positions;
+  for(auto &remark: remarks)
+    positions[{remark.line, remark.index}].emplace_back(&remark);
+  
+  for(auto &position: positions) {
+    int line=position.first.first-1;
+    if(line<0 || line>=get_buffer()->get_line_count())
+      continue;
+    auto start=get_iter_at_line_end(line);
+    int index=position.first.second-1;
+    if(index>=0 && index<start.get_line_index())
+      start=get_buffer()->get_iter_at_line_index(line, index);
+    auto end=start;
+    if(!end.forward_word_end() || end.get_line()!=line) {
+      end=start;
+      end.forward_char();
+    }
+    
+    std::string tag_name;
+    std::string text;
+    for(auto &remark: position.second) {
+      if(remark->kind=="missed")
+        tag_name="optimization_remark_missed";
+      else if(remark->kind=="passed" && tag_name.empty())
+        tag_name="optimization_remark_passed";
+      if(!text.empty())
+        text+='\n';
+      text+=remark->kind+" ("+remark->pass+"): "+remark->message;
+    }
+    auto create_tooltip_buffer=[this, text]() {
+      auto tooltip_buffer=Gtk::TextBuffer::create(get_buffer()->get_tag_table());
+      tooltip_buffer->insert_with_tag(tooltip_buffer->get_insert()->get_iter(), "Optimization remarks:\n"+text, "def:note");
+      return tooltip_buffer;
+    };
+    optimization_remark_tooltips.emplace_back(create_tooltip_buffer, *this, get_buffer()->create_mark(start), get_buffer()->create_mark(end));
+    if(!tag_name.empty())
+      get_buffer()->apply_tag_by_name(tag_name, start, end);
+  }
+}
+
+std::vector<Source::ClangViewParse::FunctionDefinition> Source::ClangViewParse::get_function_definitions(clang::Tokens &tokens) {
+  std::vector<FunctionDefinition> function_definitions;
+  std::set<std::pair<int, int> > starts;
+  for(auto &token: tokens) {
+    if(token.get_kind()!=clang::Token::Kind::Identifier)
+      continue;
+    auto cursor=token.get_cursor();
+    auto kind=cursor.get_kind();
+    if((kind==clang::Cursor::Kind::FunctionDecl || kind==clang::Cursor::Kind::CXXMethod ||
+        kind==clang::Cursor::Kind::Constructor || kind==clang::Cursor::Kind::Destructor) &&
+       clang_isCursorDefinition(cursor.cx_cursor)) {
+      auto offsets=cursor.get_source_range().get_offsets();
+      if(!starts.emplace(offsets.first.line, offsets.first.index).second)
+        continue;
+      FunctionDefinition definition;
+      definition.spelling=cursor.get_spelling();
+#if CINDEX_VERSION_MAJOR>0 || CINDEX_VERSION_MINOR>=30
+      definition.mangled_name=clang::to_string(clang_Cursor_getMangling(cursor.cx_cursor));
+#endif
+      definition.start_line=offsets.first.line;
+      definition.end_line=offsets.second.line;
+      function_definitions.emplace_back(std::move(definition));
+    }
+  }
+  return function_definitions;
+}
+
+Source::ClangViewParse::FunctionDefinition Source::ClangViewParse::get_function_definition_at_cursor() {
+  FunctionDefinition function_definition;
+  if(!parsed)
+    return function_definition;
+  
+  //The definitions are found in parse_thread, so only the innermost definition at the cursor is looked up here
+  auto line=get_buffer()->get_insert()->get_iter().get_line()+1;
+  for(auto &definition: function_definitions) {
+    if(line>=definition.start_line && line<=definition.end_line &&
+       (function_definition.spelling.empty() || definition.start_line>=function_definition.start_line))
+      function_definition=definition;
+  }
+  return function_definition;
 }
 
 void Source::ClangViewParse::show_type_tooltips(const Gdk::Rectangle &rectangle) {
@@ -414,79 +807,179 @@ void Source::ClangViewParse::show_type_tooltips(const Gdk::Rectangle &rectangle)
         return;
     }
     if(found_token && iter.forward_char()) {
-      auto tokens=clang_tu->get_tokens(iter.get_line()+1, iter.get_line_index()+1,
-                                       iter.get_line()+1, iter.get_line_index()+1);
+      auto request=std::make_unique<TypeTooltipsRequest>();
+      request->line=iter.get_line()+1;
+      request->index=iter.get_line_index()+1;
+      request->parse_generation=parse_generation;
+#ifdef JUCI_ENABLE_DEBUG
+      request->debug_stop_id=Debug::LLDB::get().get_stop_id();
       
-      type_tooltips.clear();
-      for(auto &token: *tokens) {
-        auto cursor=token.get_cursor();
-        if(token.get_kind()==clang::Token::Kind::Identifier && cursor.has_type_description()) {
-          if(token.get_cursor().get_kind()==clang::Cursor::Kind::CallExpr) //These cursors are buggy
-            continue;
-          auto start=get_buffer()->get_iter_at_line_index(token.offsets.first.line-1, token.offsets.first.index-1);
-          auto end=get_buffer()->get_iter_at_line_index(token.offsets.second.line-1, token.offsets.second.index-1);
-          auto create_tooltip_buffer=[this, &token]() {
-            auto tooltip_buffer=Gtk::TextBuffer::create(get_buffer()->get_tag_table());
-            tooltip_buffer->insert_with_tag(tooltip_buffer->get_insert()->get_iter(), "Type: "+token.get_cursor().get_type_description(), "def:note");
-            auto brief_comment=token.get_cursor().get_brief_comments();
-            if(brief_comment!="")
-              tooltip_buffer->insert_with_tag(tooltip_buffer->get_insert()->get_iter(), "\n\n"+brief_comment, "def:note");
+      //Spelling of the token including the preceding members and namespaces, used to get the debug value
+      auto start=iter;
+      auto end=iter;
+      while((*end>='a' && *end<='z') || (*end>='A' && *end<='Z') || (*end>='0' && *end<='9') || *end=='_') {
+        if(!end.forward_char())
+          break;
+      }
+      while((*iter>='a' && *iter<='z') || (*iter>='A' && *iter<='Z') || (*iter>='0' && *iter<='9') || *iter=='_' || *iter=='.') {
+        start=iter;
+        if(!iter.backward_char())
+          break;
+        if(*iter=='>') {
+          if(!(iter.backward_char() && *iter=='-' && iter.backward_char()))
+            break;
+        }
+        else if(*iter==':') {
+          if(!(iter.backward_char() && *iter==':' && iter.backward_char()))
+            break;
+        }
+      }
+      request->spelling=get_buffer()->get_text(start, end).raw();
+#endif
+      
+      auto key=std::make_tuple(request->line, request->index, request->parse_generation, request->debug_stop_id);
+      auto it=type_tooltips_cache.find(key);
+      if(it!=type_tooltips_cache.end()) {
+        ++type_tooltips_generation;
+        show_type_tooltips(it->second);
+        return;
+      }
+      
+      request->generation=++type_tooltips_generation;
+      {
+        std::unique_lock<std::mutex> lock(type_tooltips_mutex);
+        type_tooltips_request=std::move(request);
+      }
+      type_tooltips_condition_variable.notify_one();
+    }
+  }
+}
+
+void Source::ClangViewParse::show_type_tooltips(const std::shared_ptr<std::vector<TypeTooltip> > &type_tooltips) {
+  this->type_tooltips.clear();
+  for(auto &type_tooltip: *type_tooltips) {
+    auto start=get_buffer()->get_iter_at_line_index(type_tooltip.start_line, type_tooltip.start_index);
+    auto end=get_buffer()->get_iter_at_line_index(type_tooltip.end_line, type_tooltip.end_index);
+    auto create_tooltip_buffer=[this, type_tooltips, &type_tooltip]() {
+      auto tooltip_buffer=Gtk::TextBuffer::create(get_buffer()->get_tag_table());
+      tooltip_buffer->insert_with_tag(tooltip_buffer->get_insert()->get_iter(), "Type: "+type_tooltip.type_description, "def:note");
+      if(!type_tooltip.brief_comment.empty())
+        tooltip_buffer->insert_with_tag(tooltip_buffer->get_insert()->get_iter(), "\n\n"+type_tooltip.brief_comment, "def:note");
+      if(!type_tooltip.debug_value.empty())
+        tooltip_buffer->insert_with_tag(tooltip_buffer->get_insert()->get_iter(), "\n\n"+type_tooltip.debug_value, "def:note");
+      return tooltip_buffer;
+    };
+    this->type_tooltips.emplace_back(create_tooltip_buffer, *this, get_buffer()->create_mark(start), get_buffer()->create_mark(end));
+  }
+  this->type_tooltips.show();
+}
 
+void Source::ClangViewParse::get_type_tooltips(const TypeTooltipsRequest &request) {
+  auto type_tooltips=std::make_shared<std::vector<TypeTooltip> >();
 #ifdef JUCI_ENABLE_DEBUG
-            if(Debug::LLDB::get().is_stopped()) {
-              auto location=token.get_cursor().get_referenced().get_source_location();
-              Glib::ustring value_type="Value";
-              
-              auto start=get_buffer()->get_iter_at_line_index(token.offsets.first.line-1, token.offsets.first.index-1);
-              auto end=get_buffer()->get_iter_at_line_index(token.offsets.second.line-1, token.offsets.second.index-1);
-              auto iter=start;
-              while((*iter>='a' && *iter<='z') || (*iter>='A' && *iter<='Z') || (*iter>='0' && *iter<='9') || *iter=='_' || *iter=='.') {
-                start=iter;
-                if(!iter.backward_char())
-                  break;
-                if(*iter=='>') {
-                  if(!(iter.backward_char() && *iter=='-' && iter.backward_char()))
-                    break;
-                }
-                else if(*iter==':') {
-                  if(!(iter.backward_char() && *iter==':' && iter.backward_char()))
-                    break;
-                }
-              }
-              auto spelling=get_buffer()->get_text(start, end).raw();
-              
-              Glib::ustring debug_value=Debug::LLDB::get().get_value(spelling, location.get_path(), location.get_offset().line, location.get_offset().index);
-              if(debug_value.empty()) {
-                value_type="Return value";
-                auto cursor=token.get_cursor();
-                auto offsets=cursor.get_source_range().get_offsets();
-                debug_value=Debug::LLDB::get().get_return_value(cursor.get_source_location().get_path(), offsets.first.line, offsets.first.index);
-              }
-              if(!debug_value.empty()) {
-                size_t pos=debug_value.find(" = ");
-                if(pos!=Glib::ustring::npos) {
-                  Glib::ustring::iterator iter;
-                  while(!debug_value.validate(iter)) {
-                    auto next_char_iter=iter;
-                    next_char_iter++;
-                    debug_value.replace(iter, next_char_iter, "?");
-                  }
-                  tooltip_buffer->insert_with_tag(tooltip_buffer->get_insert()->get_iter(), "\n\n"+value_type+": "+debug_value.substr(pos+3, debug_value.size()-(pos+3)-1), "def:note");
-                }
-              }
-            }
+  class DebugLocations {
+  public:
+    boost::filesystem::path referenced_path;
+    unsigned referenced_line, referenced_index;
+    boost::filesystem::path path;
+    unsigned line, index;
+  };
+  std::vector<DebugLocations> debug_locations;
 #endif
-            
-            return tooltip_buffer;
-          };
-          
-          type_tooltips.emplace_back(create_tooltip_buffer, *this, get_buffer()->create_mark(start), get_buffer()->create_mark(end));
+  {
+    std::unique_lock<std::mutex> parse_lock(parse_mutex);
+    if(request.generation!=type_tooltips_generation || request.parse_generation!=parse_generation || !clang_tu)
+      return;
+    auto tokens=clang_tu->get_tokens(request.line, request.index, request.line, request.index);
+    for(auto &token: *tokens) {
+      auto cursor=token.get_cursor();
+      if(token.get_kind()==clang::Token::Kind::Identifier && cursor.has_type_description()) {
+        if(cursor.get_kind()==clang::Cursor::Kind::CallExpr) //These cursors are buggy
+          continue;
+        type_tooltips->emplace_back();
+        auto &type_tooltip=type_tooltips->back();
+        type_tooltip.start_line=token.offsets.first.line-1;
+        type_tooltip.start_index=token.offsets.first.index-1;
+        type_tooltip.end_line=token.offsets.second.line-1;
+        type_tooltip.end_index=token.offsets.second.index-1;
+        type_tooltip.type_description=cursor.get_type_description();
+        type_tooltip.brief_comment=cursor.get_brief_comments();
+#ifdef JUCI_ENABLE_DEBUG
+        auto referenced_location=cursor.get_referenced().get_source_location();
+        auto referenced_offset=referenced_location.get_offset();
+        auto offset=cursor.get_source_range().get_offsets().first;
+        debug_locations.emplace_back();
+        debug_locations.back().referenced_path=referenced_location.get_path();
+        debug_locations.back().referenced_line=referenced_offset.line;
+        debug_locations.back().referenced_index=referenced_offset.index;
+        debug_locations.back().path=cursor.get_source_location().get_path();
+        debug_locations.back().line=offset.line;
+        debug_locations.back().index=offset.index;
+#endif
+      }
+    }
+  }
+
+#ifdef JUCI_ENABLE_DEBUG
+  //The debugger is asked after the parse_mutex is released, since getting values can take some time
+  if(Debug::LLDB::get().is_stopped()) {
+    for(size_t c=0;c<type_tooltips->size();++c) {
+      if(request.generation!=type_tooltips_generation)
+        return;
+      auto &locations=debug_locations[c];
+      Glib::ustring value_type="Value";
+      Glib::ustring debug_value=Debug::LLDB::get().get_value(request.spelling, locations.referenced_path, locations.referenced_line, locations.referenced_index);
+      if(debug_value.empty()) {
+        value_type="Return value";
+        debug_value=Debug::LLDB::get().get_return_value(locations.path, locations.line, locations.index);
+      }
+      if(!debug_value.empty()) {
+        size_t pos=debug_value.find(" = ");
+        if(pos!=Glib::ustring::npos) {
+          Glib::ustring::iterator iter;
+          while(!debug_value.validate(iter)) {
+            auto next_char_iter=iter;
+            next_char_iter++;
+            debug_value.replace(iter, next_char_iter, "?");
+          }
+          (*type_tooltips)[c].debug_value=value_type+": "+debug_value.substr(pos+3, debug_value.size()-(pos+3)-1);
         }
       }
-      
-      type_tooltips.show();
     }
   }
+#endif
+            
+  auto generation=request.generation;
+  auto key=std::make_tuple(request.line, request.index, request.parse_generation, request.debug_stop_id);
+  type_tooltips_dispatcher.post("Clang type tooltips", [this, generation, key, type_tooltips] {
+    if(std::get<2>(key)!=parse_generation)
+      return;
+    //Only the most recent parse and debugger stop are cached
+    if(!type_tooltips_cache.empty()) {
+      auto &cached_key=type_tooltips_cache.begin()->first;
+      if(std::get<2>(cached_key)!=std::get<2>(key) || std::get<3>(cached_key)!=std::get<3>(key))
+        type_tooltips_cache.clear();
+    }
+    type_tooltips_cache[key]=type_tooltips;
+    if(generation==type_tooltips_generation && parsed)
+      show_type_tooltips(type_tooltips);
+  });
+}
+          
+void Source::ClangViewParse::hide_tooltips() {
+  ++type_tooltips_generation;
+  optimization_remark_tooltips.hide();
+  View::hide_tooltips();
+}
+      
+void Source::ClangViewParse::type_tooltips_thread_stop() {
+  type_tooltips_dispatcher.disconnect();
+  ++type_tooltips_generation;
+  {
+    std::unique_lock<std::mutex> lock(type_tooltips_mutex);
+    type_tooltips_stop=true;
+  }
+  type_tooltips_condition_variable.notify_one();
 }
 
 
@@ -676,27 +1169,41 @@ void Source::ClangViewAutocomplete::autocomplete() {
   autocomplete_state=AutocompleteState::STARTING;
   
   set_status("autocomplete...");
+  auto start_time=std::chrono::steady_clock::now();
   if(autocomplete_thread.joinable())
     autocomplete_thread.join();
-  auto buffer=std::make_shared<Glib::ustring>(get_buffer()->get_text());
+  auto snapshot=get_snapshot();
   auto iter=get_buffer()->get_insert()->get_iter();
   auto line_nr=iter.get_line()+1;
-  auto column_nr=iter.get_line_index()+1;
-  auto pos=iter.get_offset()-1;
-  while(pos>=0 && (((*buffer)[pos]>='a' && (*buffer)[pos]<='z') || ((*buffer)[pos]>='A' && (*buffer)[pos]<='Z') ||
-                   ((*buffer)[pos]>='0' && (*buffer)[pos]<='9') || (*buffer)[pos]=='_')) {
-    buffer->replace(pos, 1, " ");
-    column_nr--;
-    pos--;
-  }
-  autocomplete_thread=std::thread([this, line_nr, column_nr, buffer](){
+  auto line_index=iter.get_line_index();
+  autocomplete_thread=std::thread([this, snapshot, line_nr, line_index, start_time](){
+    auto buffer=snapshot.str();
+    size_t pos=0;
+    for(int line=1;line<line_nr;++line)
+      pos=buffer.find('\n', pos)+1;
+    pos+=line_index;
+    auto column_nr=line_index+1;
+    while(pos>0 && ((buffer[pos-1]>='a' && buffer[pos-1]<='z') || (buffer[pos-1]>='A' && buffer[pos-1]<='Z') ||
+                    (buffer[pos-1]>='0' && buffer[pos-1]<='9') || buffer[pos-1]=='_')) {
+      buffer[pos-1]=' ';
+      column_nr--;
+      pos--;
+    }
+    
     std::unique_lock<std::mutex> lock(parse_mutex);
+    if(!clang_tu) { //The translation unit is not yet created
+      dispatcher.post("Clang autocomplete without translation unit", [this] {
+        set_status("");
+        autocomplete_state=AutocompleteState::IDLE;
+      });
+      return;
+    }
     if(parse_state==ParseState::PROCESSING) {
       parse_process_state=ParseProcessState::IDLE;
-      auto autocomplete_data=std::make_shared<std::vector<AutoCompleteData> >(autocomplete_get_suggestions(buffer->raw(), line_nr, column_nr));
+      auto autocomplete_data=std::make_shared<std::vector<AutoCompleteData> >(autocomplete_get_suggestions(buffer, line_nr, column_nr));
       
       if(parse_state==ParseState::PROCESSING) {
-        dispatcher.post([this, autocomplete_data] {
+        dispatcher.post("Clang autocomplete", [this, autocomplete_data, start_time] {
           if(autocomplete_state==AutocompleteState::CANCELED) {
             set_status("");
             soft_reparse();
@@ -736,6 +1243,8 @@ void Source::ClangViewAutocomplete::autocomplete() {
               get_buffer()->begin_user_action();
               hide_tooltips();
               autocomplete_dialog->show();
+              performance.completion_latency=std::chrono::steady_clock::now()-start_time;
+              ++performance.completions;
             }
             else
               soft_reparse();
@@ -743,7 +1252,7 @@ void Source::ClangViewAutocomplete::autocomplete() {
         });
       }
       else {
-        dispatcher.post([this] {
+        dispatcher.post("Clang autocomplete failed", [this] {
           Terminal::get().print("Error: autocomplete failed, reparsing "+this->file_path.string()+"\n", true);
           autocomplete_state=AutocompleteState::CANCELED;
           full_reparse();
@@ -754,6 +1263,7 @@ void Source::ClangViewAutocomplete::autocomplete() {
 }
 
 std::vector<Source::ClangViewAutocomplete::AutoCompleteData> Source::ClangViewAutocomplete::autocomplete_get_suggestions(const std::string &buffer, int line_number, int column) {
+  TRACE_SCOPE("get_code_completions");
   std::vector<AutoCompleteData> suggestions;
   auto results=clang_tu->get_code_completions(buffer, line_number, column);
   if(results.cx_results==nullptr) {
@@ -1310,6 +1820,82 @@ Source::ClangViewRefactor::ClangViewRefactor(const boost::filesystem::path &file
     }
     return fix_its;
   };
+  
+  show_record_layout=[this]() {
+    if(!parsed) {
+      Info::get().print("Buffer is parsing");
+      return;
+    }
+    //The record of the type of the identifier at the cursor, or else the record the cursor is in
+    CXCursor cursor=clang_getNullCursor();
+    auto identifier=get_identifier();
+    if(identifier) {
+      auto type=clang_getCanonicalType(clang_getCursorType(identifier.cursor.cx_cursor));
+      while(type.kind==CXType_Pointer || type.kind==CXType_LValueReference || type.kind==CXType_RValueReference || type.kind==CXType_ConstantArray) {
+        if(type.kind==CXType_ConstantArray)
+          type=clang_getCanonicalType(clang_getArrayElementType(type));
+        else
+          type=clang_getCanonicalType(clang_getPointeeType(type));
+      }
+      if(type.kind==CXType_Record)
+        cursor=clang_getTypeDeclaration(type);
+    }
+    if(clang_Cursor_isNull(cursor)) {
+      auto iter=get_buffer()->get_insert()->get_iter();
+      auto file=clang_getFile(clang_tu->cx_tu, file_path.string().c_str());
+      cursor=clang_getCursor(clang_tu->cx_tu, clang_getLocation(clang_tu->cx_tu, file, iter.get_line()+1, iter.get_line_index()+1));
+      while(!clang_Cursor_isNull(cursor) && !clang_isTranslationUnit(clang_getCursorKind(cursor)) &&
+            clang_getCursorType(cursor).kind!=CXType_Record)
+        cursor=clang_getCursorSemanticParent(cursor);
+    }
+    if(clang_Cursor_isNull(cursor) || clang_getCursorType(cursor).kind!=CXType_Record) {
+      Info::get().print("No class, struct or union found at cursor");
+      return;
+    }
+    
+    auto definition=clang_getCursorDefinition(cursor);
+    if(!clang_Cursor_isNull(definition))
+      cursor=definition;
+    auto layout=get_record_layout(clang::Cursor(cursor));
+    if(!layout) {
+      Info::get().print("Layout of "+clang::to_string(clang_getTypeSpelling(clang_getCursorType(cursor)))+" is not known, for instance since it is a template");
+      return;
+    }
+    Terminal::get().print(layout->file_path.string()+':'+std::to_string(layout->line)+":1: "+layout->get_text());
+  };
+  
+  show_record_layouts_report=[this](const std::vector<Source::View*> &views) {
+    wait_parsing(views);
+    std::vector<RecordLayout> layouts;
+    std::unordered_set<std::string> usrs;
+    for(auto &view: views) {
+      if(auto clang_view=dynamic_cast<Source::ClangView*>(view)) {
+        class VisitorData {
+        public:
+          std::vector<RecordLayout> &layouts;
+          std::unordered_set<std::string> &usrs;
+        };
+        VisitorData visitor_data{layouts, usrs};
+        clang_visitChildren(clang_getTranslationUnitCursor(clang_view->clang_tu->cx_tu), [](CXCursor cx_cursor, CXCursor parent, CXClientData data) {
+          if(clang_Location_isInSystemHeader(clang_getCursorLocation(cx_cursor)))
+            return CXChildVisit_Continue;
+          auto kind=clang_getCursorKind(cx_cursor);
+          if(kind==CXCursor_StructDecl || kind==CXCursor_ClassDecl || kind==CXCursor_UnionDecl) {
+            auto visitor_data=static_cast<VisitorData*>(data);
+            if(clang_isCursorDefinition(cx_cursor) && visitor_data->usrs.emplace(clang::to_string(clang_getCursorUSR(cx_cursor))).second) {
+              if(auto layout=get_record_layout(clang::Cursor(cx_cursor)))
+                visitor_data->layouts.emplace_back(std::move(*layout));
+            }
+            return CXChildVisit_Recurse;
+          }
+          if(kind==CXCursor_Namespace || kind==CXCursor_LinkageSpec)
+            return CXChildVisit_Recurse;
+          return CXChildVisit_Continue;
+        }, &visitor_data);
+      }
+    }
+    Terminal::get().print(RecordLayout::get_report(layouts, 50));
+  };
 }
 
 Source::ClangViewRefactor::Identifier Source::ClangViewRefactor::get_identifier() {
@@ -1333,6 +1919,47 @@ Source::ClangViewRefactor::Identifier Source::ClangViewRefactor::get_identifier(
   return Identifier();
 }
 
+std::unique_ptr<RecordLayout> Source::ClangViewRefactor::get_record_layout(const clang::Cursor &cursor) {
+  auto type=clang_getCursorType(cursor.cx_cursor);
+  auto size=clang_Type_getSizeOf(type);
+  auto alignment=clang_Type_getAlignOf(type);
+  if(size<0 || alignment<0)
+    return nullptr;
+  
+  auto layout=std::make_unique<RecordLayout>();
+  layout->name=clang::to_string(clang_getTypeSpelling(type));
+  auto source_location=cursor.get_source_location();
+  layout->file_path=source_location.get_path();
+  layout->line=source_location.get_offset().line;
+  layout->size=size;
+  layout->alignment=alignment;
+  
+  class VisitorData {
+  public:
+    CXType type;
+    std::vector<RecordLayout::Field> &fields;
+  };
+  VisitorData visitor_data{type, layout->fields};
+  clang_visitChildren(cursor.cx_cursor, [](CXCursor cx_cursor, CXCursor parent, CXClientData data) {
+    if(clang_getCursorKind(cx_cursor)!=CXCursor_FieldDecl)
+      return CXChildVisit_Continue;
+    auto visitor_data=static_cast<VisitorData*>(data);
+    auto field_type=clang_getCursorType(cx_cursor);
+    RecordLayout::Field field;
+    field.name=clang::to_string(clang_getCursorSpelling(cx_cursor));
+    field.type=clang::to_string(clang_getTypeSpelling(field_type));
+    field.offset=clang_Type_getOffsetOf(visitor_data->type, field.name.c_str());
+    field.bit_field=clang_Cursor_isBitField(cx_cursor);
+    field.size=field.bit_field?clang_getFieldDeclBitWidth(cx_cursor):clang_Type_getSizeOf(field_type)*8;
+    field.alignment=clang_Type_getAlignOf(field_type);
+    //Anonymous fields have no name to look up the offset with
+    if(field.offset>=0 && field.size>=0 && field.alignment>0)
+      visitor_data->fields.emplace_back(std::move(field));
+    return CXChildVisit_Continue;
+  }, &visitor_data);
+  return layout;
+}
+
 void Source::ClangViewRefactor::wait_parsing(const std::vector<Source::View*> &views) {
   std::unique_ptr<Dialog::Message> message;
   std::vector<Source::ClangView*> clang_views;
@@ -1437,7 +2064,7 @@ void Source::ClangView::full_reparse() {
         parse_thread.join();
       if(autocomplete_thread.joinable())
         autocomplete_thread.join();
-      dispatcher.post([this] {
+      dispatcher.post("Clang full reparse", [this] {
         parse_initialize();
         full_reparse_running=false;
       });
@@ -1449,14 +2076,21 @@ void Source::ClangView::async_delete() {
   dispatcher.disconnect();
   delayed_reparse_connection.disconnect();
   delayed_tag_similar_identifiers_connection.disconnect();
+  delayed_configure_connection.disconnect();
   parsing_in_progress->cancel("canceled, freeing resources in the background");
   parse_state=ParseState::STOP;
+  search_thread_stop();
+  type_tooltips_thread_stop();
   delete_thread=std::thread([this](){
     //TODO: Is it possible to stop the clang-process in progress?
     if(full_reparse_thread.joinable())
       full_reparse_thread.join();
     if(parse_thread.joinable())
       parse_thread.join();
+    if(type_tooltips_thread.joinable())
+      type_tooltips_thread.join();
+    if(optimization_remarks_thread.joinable())
+      optimization_remarks_thread.join();
     if(autocomplete_thread.joinable())
       autocomplete_thread.join();
     do_delete_object();
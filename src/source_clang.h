@@ -5,10 +5,14 @@
 #include <atomic>
 #include <mutex>
 #include <set>
+#include <map>
+#include <tuple>
+#include <condition_variable>
 #include "clangmm.h"
 #include "source.h"
 #include "terminal.h"
 #include "dispatcher.h"
+#include "record_layout.h"
 
 namespace Source {
   class ClangViewParse : public View {
@@ -23,6 +27,42 @@ namespace Source {
     void configure() override;
     
     void soft_reparse() override;
+    
+    class OptimizationRemark {
+    public:
+      int line, index;
+      ///passed, missed or analysis
+      std::string kind;
+      std::string pass;
+      std::string message;
+    };
+    ///Returns the remarks in file_path from the output of clang with -Rpass, -Rpass-missed and -Rpass-analysis.
+    ///Relative paths in the output are relative to build_path.
+    static std::vector<OptimizationRemark> get_optimization_remarks(const std::string &output, const boost::filesystem::path &file_path, const boost::filesystem::path &build_path);
+    ///Returns the clang command from the compilation database with optimization remarks enabled, or empty string if file_path is not in the database
+    static std::string get_optimization_remarks_command(const boost::filesystem::path &file_path, const boost::filesystem::path &build_path);
+    
+    class AssemblyFunction {
+    public:
+      std::string name;
+      ///Instructions and local labels, each with its source line in the file, or 0 if unknown
+      std::vector<std::pair<std::string, int> > lines;
+    };
+    ///Returns the functions in the output of clang with -S and -g, where the source lines are lines in file_path
+    static std::vector<AssemblyFunction> get_assembly_functions(const std::string &assembly, const boost::filesystem::path &file_path);
+    ///Returns the clang command from the compilation database that writes optimized assembly with debug line info to stdout,
+    ///or empty string if file_path is not in the database
+    static std::string get_assembly_command(const boost::filesystem::path &file_path, const boost::filesystem::path &build_path);
+    
+    class FunctionDefinition {
+    public:
+      std::string spelling;
+      ///Empty if not supported by libclang
+      std::string mangled_name;
+      int start_line, end_line;
+    };
+    ///Returns the innermost function definition at the cursor, with empty spelling if none
+    FunctionDefinition get_function_definition_at_cursor();
   protected:
     Dispatcher dispatcher;
     void parse_initialize();
@@ -34,6 +74,11 @@ namespace Source {
     
     void show_diagnostic_tooltips(const Gdk::Rectangle &rectangle) override;
     void show_type_tooltips(const Gdk::Rectangle &rectangle) override;
+    void hide_tooltips() override;
+    ///Does not join type_tooltips_thread, since it might be waiting for parse_mutex
+    void type_tooltips_thread_stop();
+    std::thread type_tooltips_thread;
+    std::thread optimization_remarks_thread;
     
     std::set<int> diagnostic_offsets;
     std::vector<FixIt> fix_its;
@@ -43,7 +88,37 @@ namespace Source {
     std::atomic<ParseState> parse_state;
     std::atomic<ParseProcessState> parse_process_state;
   private:
-    Glib::ustring parse_thread_buffer;
+    Snapshot parse_thread_buffer;
+    ///Increased after each successful reparse
+    std::atomic<size_t> parse_generation;
+    size_t translation_unit_memory=0;
+    
+    class TypeTooltip {
+    public:
+      int start_line, start_index, end_line, end_index;
+      std::string type_description;
+      std::string brief_comment;
+      std::string debug_value;
+    };
+    class TypeTooltipsRequest {
+    public:
+      size_t generation;
+      int line, index;
+      size_t parse_generation;
+      uint32_t debug_stop_id=0;
+      std::string spelling;
+    };
+    void show_type_tooltips(const std::shared_ptr<std::vector<TypeTooltip> > &type_tooltips);
+    ///Runs in type_tooltips_thread
+    void get_type_tooltips(const TypeTooltipsRequest &request);
+    ///Key is line, index, parse generation and debugger stop id
+    std::map<std::tuple<int, int, size_t, uint32_t>, std::shared_ptr<std::vector<TypeTooltip> > > type_tooltips_cache;
+    Dispatcher type_tooltips_dispatcher;
+    std::mutex type_tooltips_mutex;
+    std::condition_variable type_tooltips_condition_variable;
+    std::unique_ptr<TypeTooltipsRequest> type_tooltips_request;
+    std::atomic<size_t> type_tooltips_generation;
+    bool type_tooltips_stop=false;
     
     void update_syntax();
     std::set<std::string> last_syntax_tags;
@@ -51,8 +126,26 @@ namespace Source {
     void update_diagnostics();
     std::vector<clang::Diagnostic> diagnostics;
     
+    ///Compiles the saved file with optimization remarks in optimization_remarks_thread, and shows the remarks when done
+    void optimization_remarks_start();
+    void update_optimization_remarks(const std::vector<OptimizationRemark> &remarks);
+    bool optimization_remarks_enabled=false;
+    ///Set if the file is saved while optimization_remarks_thread is running
+    bool optimization_remarks_pending=false;
+    bool optimization_remarks_running=false;
+    Tooltips optimization_remark_tooltips;
+    
+    ///Returns the function definitions in tokens, called in parse_thread while holding parse_mutex
+    static std::vector<FunctionDefinition> get_function_definitions(clang::Tokens &tokens);
+    ///Set in parse_thread, and moved to function_definitions in the main thread when the parse is done
+    std::vector<FunctionDefinition> parse_thread_function_definitions;
+    std::vector<FunctionDefinition> function_definitions;
+    
+    ///Returns the compiler from the compilation database followed by its arguments, without source file, output file and dependency file arguments
+    static std::vector<std::string> get_compile_arguments(const boost::filesystem::path &file_path, const boost::filesystem::path &build_path);
+    
     static clang::Index clang_index;
-    std::vector<std::string> get_compilation_commands();
+    static std::vector<std::string> get_compilation_commands(const boost::filesystem::path &file_path, const boost::filesystem::path &default_build_path);
   };
     
   class ClangViewAutocomplete : public virtual ClangViewParse {
@@ -106,6 +199,8 @@ namespace Source {
   private:
     Identifier get_identifier();
     void wait_parsing(const std::vector<Source::View*> &views);
+    ///Returns nullptr if the layout of the record at cursor is not known, for instance if it is a class template
+    static std::unique_ptr<RecordLayout> get_record_layout(const clang::Cursor &cursor);
     
     std::list<std::pair<Glib::RefPtr<Gtk::TextMark>, Glib::RefPtr<Gtk::TextMark> > > similar_identifiers_marks;
     void tag_similar_identifiers(const Identifier &identifier);
@@ -3,6 +3,7 @@
 #include "terminal.h"
 #include "filesystem.h"
 #include <boost/version.hpp>
+#include <algorithm>
 
 namespace sigc {
 #ifndef SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
@@ -54,10 +55,16 @@ Source::DiffView::DiffView(const boost::filesystem::path &file_path) : Gsv::View
   renderer->tag_removed_below=get_buffer()->create_tag();
   renderer->tag_removed_above=get_buffer()->create_tag();
   
-  configure();
+  //Finding the repository is postponed until the view is shown
+  delayed_configure_connection=Glib::signal_idle().connect([this]() {
+    delayed_configure_connection.disconnect();
+    DiffView::configure();
+    return false;
+  });
 }
 
 Source::DiffView::~DiffView() {
+  delayed_configure_connection.disconnect();
   dispatcher.disconnect();
   if(repository) {
     get_gutter(Gtk::TextWindowType::TEXT_WINDOW_LEFT)->remove(renderer.get());
@@ -74,6 +81,8 @@ Source::DiffView::~DiffView() {
 }
 
 void Source::DiffView::configure() {
+  if(delayed_configure_connection.connected())
+    return;
   if(Config::get().source.show_git_diff) {
     if(repository)
       return;
@@ -108,6 +117,7 @@ void Source::DiffView::configure() {
   parse_state=ParseState::STARTING;
   parse_stop=false;
   monitor_changed=false;
+  has_hunks=false;
   
   buffer_insert_connection=get_buffer()->signal_insert().connect([this](const Gtk::TextBuffer::iterator &iter ,const Glib::ustring &text, int) {
     //Do not perform git diff if no newline is added and line is already marked as added
@@ -161,6 +171,7 @@ void Source::DiffView::configure() {
         parse_state=ParseState::STARTING;
         std::unique_lock<std::mutex> lock(parse_mutex);
         diff=nullptr;
+        has_hunks=false;
         return false;
       }, 500);
     }
@@ -181,12 +192,15 @@ void Source::DiffView::configure() {
         std::unique_lock<std::mutex> parse_lock(parse_mutex, std::defer_lock);
         auto expected=ParseState::STARTING;
         if(parse_state.compare_exchange_strong(expected, ParseState::PREPROCESSING)) {
-          dispatcher.post([this] {
+          dispatcher.post("Diff preprocess", [this] {
             auto expected=ParseState::PREPROCESSING;
             std::unique_lock<std::mutex> parse_lock(parse_mutex, std::defer_lock);
             if(parse_lock.try_lock()) {
-              if(parse_state.compare_exchange_strong(expected, ParseState::PROCESSING))
-                parse_buffer=get_buffer()->get_text();
+              if(parse_state.compare_exchange_strong(expected, ParseState::PROCESSING)) {
+                parse_buffer=get_snapshot();
+                parse_line_count=get_buffer()->get_line_count();
+                set_edited_lines();
+              }
               parse_lock.unlock();
             }
             else
@@ -196,11 +210,12 @@ void Source::DiffView::configure() {
         else if (parse_state==ParseState::PROCESSING && parse_lock.try_lock()) {
           bool expected_monitor_changed=true;
           if(monitor_changed.compare_exchange_strong(expected_monitor_changed, false)) {
+            has_hunks=false;
             try {
               diff=get_diff();
             }
             catch(const std::exception &) {
-              dispatcher.post([this] {
+              dispatcher.post("Diff failed", [this] {
                 get_buffer()->remove_tag(renderer->tag_added, get_buffer()->begin(), get_buffer()->end());
                 get_buffer()->remove_tag(renderer->tag_modified, get_buffer()->begin(), get_buffer()->end());
                 get_buffer()->remove_tag(renderer->tag_removed, get_buffer()->begin(), get_buffer()->end());
@@ -210,9 +225,19 @@ void Source::DiffView::configure() {
               });
             }
           }
-          if(diff)
-            lines=diff->get_lines(parse_buffer.raw());
+          if(diff) {
+            //Only the edited lines are diffed again when the hunks of a previous buffer are known
+            if(has_hunks && edited_start_line>=0)
+              hunks=diff->get_hunks(parse_buffer.str(), hunks, edited_start_line, edited_previous_end_line, edited_end_line);
+            else
+              hunks=diff->get_hunks(parse_buffer.str());
+            has_hunks=true;
+            hunks_buffer_generation=parse_buffer.generation;
+            hunks_line_count=parse_line_count;
+            lines=Git::Repository::Diff::get_lines(hunks);
+          }
           else {
+            has_hunks=false;
             lines.added.clear();
             lines.modified.clear();
             lines.removed.clear();
@@ -220,12 +245,13 @@ void Source::DiffView::configure() {
           auto expected=ParseState::PROCESSING;
           if(parse_state.compare_exchange_strong(expected, ParseState::POSTPROCESSING)) {
             parse_lock.unlock();
-            dispatcher.post([this] {
+            dispatcher.post("Diff postprocess", [this] {
               std::unique_lock<std::mutex> parse_lock(parse_mutex, std::defer_lock);
               if(parse_lock.try_lock()) {
                 auto expected=ParseState::POSTPROCESSING;
-                if(parse_state.compare_exchange_strong(expected, ParseState::IDLE))
+                if(parse_state.compare_exchange_strong(expected, ParseState::IDLE)) {
                   update_lines();
+                }
               }
             });
           }
@@ -234,7 +260,7 @@ void Source::DiffView::configure() {
     }
     catch(const std::exception &e) {
       auto e_what=std::make_shared<std::string>(e.what());
-      dispatcher.post([this, e_what] {
+      dispatcher.post("Diff error", [this, e_what] {
         get_buffer()->remove_tag(renderer->tag_added, get_buffer()->begin(), get_buffer()->end());
         get_buffer()->remove_tag(renderer->tag_modified, get_buffer()->begin(), get_buffer()->end());
         get_buffer()->remove_tag(renderer->tag_removed, get_buffer()->begin(), get_buffer()->end());
@@ -294,8 +320,8 @@ std::string Source::DiffView::git_get_diff_details() {
   if(iter.has_tag(renderer->tag_removed_above))
     --line_nr;
   std::unique_lock<std::mutex> lock(parse_mutex);
-  parse_buffer=get_buffer()->get_text();
-  return diff->get_details(parse_buffer.raw(), line_nr);
+  parse_buffer=get_snapshot();
+  return diff->get_details(parse_buffer.str(), line_nr);
 }
 
 ///Return repository diff instance. Throws exception on error
@@ -311,6 +337,32 @@ std::unique_ptr<Git::Repository::Diff> Source::DiffView::get_diff() {
   return std::make_unique<Git::Repository::Diff>(repository->get_diff(relative_path));
 }
 
+void Source::DiffView::set_edited_lines() {
+  edited_start_line=-1;
+  if(!has_hunks)
+    return;
+  //The edits are merged into one range of characters in the current buffer
+  size_t start=std::string::npos, end=0;
+  for(auto &edit: get_edits(hunks_buffer_generation)) {
+    if(edit.removed==std::string::npos)
+      return;
+    if(start==std::string::npos) {
+      start=edit.offset;
+      end=edit.offset+edit.inserted;
+    }
+    else {
+      end=std::max(end, edit.offset+edit.removed)-edit.removed+edit.inserted;
+      start=std::min(start, edit.offset);
+    }
+  }
+  if(start==std::string::npos)
+    start=end=0;
+  edited_start_line=get_buffer()->get_iter_at_offset(start).get_line();
+  edited_end_line=get_buffer()->get_iter_at_offset(end).get_line()+1;
+  //The lines after the edited lines are unchanged, so the line count tells where the edited lines ended in the previous buffer
+  edited_previous_end_line=edited_end_line-(parse_line_count-hunks_line_count);
+}
+
 void Source::DiffView::update_lines() {
   get_buffer()->remove_tag(renderer->tag_added, get_buffer()->begin(), get_buffer()->end());
   get_buffer()->remove_tag(renderer->tag_modified, get_buffer()->begin(), get_buffer()->end());
@@ -9,9 +9,10 @@
 #include <atomic>
 #include <mutex>
 #include "git.h"
+#include "source_snapshot.h"
 
 namespace Source {
-  class DiffView : virtual public Gsv::View {
+  class DiffView : virtual public SnapshotView {
     enum class ParseState {IDLE, STARTING, PREPROCESSING, PROCESSING, POSTPROCESSING};
     
     class Renderer : public Gsv::GutterRenderer {
@@ -43,6 +44,8 @@ namespace Source {
     boost::filesystem::path file_path;
     ///Only needed when using file_path in a thread, or when changing file_path
     std::mutex file_path_mutex;
+  protected:
+    sigc::connection delayed_configure_connection;
   private:
     std::unique_ptr<Renderer> renderer;
     Dispatcher dispatcher;
@@ -55,7 +58,13 @@ namespace Source {
     std::atomic<ParseState> parse_state;
     std::mutex parse_mutex;
     std::atomic<bool> parse_stop;
-    Glib::ustring parse_buffer;
+    Snapshot parse_buffer;
+    int parse_line_count;
+    ///The lines [edited_start_line, edited_previous_end_line) of the buffer the hunks were found for were replaced by
+    ///the lines [edited_start_line, edited_end_line) of parse_buffer. edited_start_line is -1 if all the lines must be diffed.
+    int edited_start_line, edited_previous_end_line, edited_end_line;
+    ///Sets the edited lines from the edits made since the hunks were found, called on the main thread
+    void set_edited_lines();
     sigc::connection buffer_insert_connection;
     sigc::connection buffer_erase_connection;
     sigc::connection monitor_changed_connection;
@@ -63,6 +72,10 @@ namespace Source {
     sigc::connection delayed_monitor_changed_connection;
     std::atomic<bool> monitor_changed;
     
+    std::vector<Git::Repository::Diff::Hunk> hunks;
+    bool has_hunks;
+    size_t hunks_buffer_generation;
+    int hunks_line_count;
     Git::Repository::Diff::Lines lines;
     void update_lines();
   };
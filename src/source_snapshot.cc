@@ -0,0 +1,200 @@
+#include "source_snapshot.h"
+#include <algorithm>
+
+namespace sigc {
+#ifndef SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
+  template <typename Functor>
+  struct functor_trait<Functor, false> {
+    typedef decltype (::sigc::mem_fun(std::declval<Functor&>(),
+                                      &Functor::operator())) _intermediate;
+    typedef typename _intermediate::result_type result_type;
+    typedef Functor functor_type;
+  };
+#else
+  SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
+#endif
+}
+
+const size_t Source::SnapshotBuffer::chunk_size;
+const size_t Source::SnapshotBuffer::max_edits;
+
+const std::string &Source::Snapshot::str() const {
+  static const std::string empty_string;
+  if(!chunks)
+    return empty_string;
+  std::call_once(text->once_flag, [this] {
+    text->text.reserve(bytes);
+    for(auto &chunk: *chunks)
+      text->text+=*chunk.text;
+  });
+  return text->text;
+}
+
+Source::SnapshotBuffer::SnapshotBuffer(const Glib::RefPtr<Gtk::TextBuffer> &buffer) : chunks(std::make_shared<std::vector<Snapshot::Chunk> >()) {
+  auto text=buffer->get_text();
+  insert(0, text.data(), text.bytes());
+  
+  //Connected before the default handlers, while the iterators still point into the unchanged buffer
+  insert_connection=buffer->signal_insert().connect([this](const Gtk::TextBuffer::iterator &iter, const Glib::ustring &text, int bytes) {
+    insert(iter.get_offset(), text.data(), bytes);
+  }, false);
+  erase_connection=buffer->signal_erase().connect([this](const Gtk::TextBuffer::iterator &start_iter, const Gtk::TextBuffer::iterator &end_iter) {
+    erase(start_iter.get_offset(), end_iter.get_offset()-start_iter.get_offset());
+  }, false);
+}
+
+Source::SnapshotBuffer::~SnapshotBuffer() {
+  insert_connection.disconnect();
+  erase_connection.disconnect();
+}
+
+Source::Snapshot Source::SnapshotBuffer::get() {
+  if(!text)
+    text=std::make_shared<Snapshot::Text>();
+  Snapshot snapshot;
+  snapshot.chunks=chunks;
+  snapshot.text=text;
+  snapshot.bytes=bytes;
+  snapshot.generation=generation;
+  return snapshot;
+}
+
+std::vector<Source::Edit> Source::SnapshotBuffer::get_edits(size_t generation) {
+  std::vector<Edit> result;
+  if(generation>=this->generation)
+    return result;
+  if(edits.empty() || generation+1<edits.front().generation) {
+    result.emplace_back(Edit{0, std::string::npos, characters, this->generation});
+    return result;
+  }
+  for(auto it=edits.begin()+(generation+1-edits.front().generation);it!=edits.end();++it) {
+    if(!result.empty()) {
+      auto &last=result.back();
+      //Coalesce with the previous edit if the removed range touches the previously inserted text
+      if(it->offset<=last.offset+last.inserted && it->offset+it->removed>=last.offset) {
+        auto start=std::min(last.offset, it->offset);
+        auto end=std::max(last.offset+last.inserted, it->offset+it->removed);
+        last.removed=end+last.removed-last.inserted-start;
+        last.inserted=end-it->removed+it->inserted-start;
+        last.offset=start;
+        last.generation=it->generation;
+        continue;
+      }
+    }
+    result.emplace_back(*it);
+  }
+  return result;
+}
+
+void Source::SnapshotBuffer::add_edit(size_t offset, size_t removed, size_t inserted) {
+  if(edits.size()==max_edits)
+    edits.pop_front();
+  edits.emplace_back(Edit{offset, removed, inserted, generation});
+}
+
+std::vector<Source::Snapshot::Chunk> &Source::SnapshotBuffer::get_chunks() {
+  if(chunks.use_count()>1)
+    chunks=std::make_shared<std::vector<Snapshot::Chunk> >(*chunks);
+  text=nullptr;
+  ++generation;
+  return *chunks;
+}
+
+std::pair<size_t, size_t> Source::SnapshotBuffer::find(size_t offset) {
+  for(size_t c=0;c<chunks->size();++c) {
+    auto characters=(*chunks)[c].characters;
+    if(offset<characters || (offset==characters && c+1==chunks->size()))
+      return {c, offset};
+    offset-=characters;
+  }
+  return {chunks->size(), 0};
+}
+
+void Source::SnapshotBuffer::split(size_t index) {
+  auto &chunks=*this->chunks;
+  auto text=chunks[index].text;
+  if(text->size()<2*chunk_size)
+    return;
+  std::vector<Snapshot::Chunk> new_chunks;
+  const char *start=text->data();
+  const char *text_end=text->data()+text->size();
+  while(start<text_end) {
+    auto end=start+std::min<size_t>(chunk_size, text_end-start);
+    //Chunks end at character boundaries
+    while(end<text_end && (*end&0xC0)==0x80)
+      ++end;
+    new_chunks.emplace_back(Snapshot::Chunk{std::make_shared<const std::string>(start, end), static_cast<size_t>(g_utf8_strlen(start, end-start))});
+    start=end;
+  }
+  chunks.erase(chunks.begin()+index);
+  chunks.insert(chunks.begin()+index, new_chunks.begin(), new_chunks.end());
+}
+
+void Source::SnapshotBuffer::insert(size_t offset, const char *text, size_t bytes) {
+  if(bytes==0)
+    return;
+  auto &chunks=get_chunks();
+  auto characters=static_cast<size_t>(g_utf8_strlen(text, bytes));
+  this->bytes+=bytes;
+  this->characters+=characters;
+  add_edit(offset, 0, characters);
+  if(chunks.empty()) {
+    chunks.emplace_back(Snapshot::Chunk{std::make_shared<const std::string>(text, bytes), characters});
+    split(0);
+    return;
+  }
+  auto position=find(offset);
+  auto &chunk=chunks[position.first];
+  auto byte_offset=g_utf8_offset_to_pointer(chunk.text->data(), position.second)-chunk.text->data();
+  auto new_text=std::make_shared<std::string>();
+  new_text->reserve(chunk.text->size()+bytes);
+  new_text->append(*chunk.text, 0, byte_offset);
+  new_text->append(text, bytes);
+  new_text->append(*chunk.text, byte_offset, std::string::npos);
+  chunk.text=std::move(new_text);
+  chunk.characters+=characters;
+  split(position.first);
+}
+
+void Source::SnapshotBuffer::erase(size_t offset, size_t characters) {
+  if(characters==0)
+    return;
+  auto &chunks=get_chunks();
+  this->characters-=characters;
+  add_edit(offset, characters, 0);
+  auto position=find(offset);
+  auto index=position.first;
+  auto character_offset=position.second;
+  while(characters>0 && index<chunks.size()) {
+    auto &chunk=chunks[index];
+    auto erase_characters=std::min(characters, chunk.characters-character_offset);
+    characters-=erase_characters;
+    if(erase_characters==chunk.characters) {
+      bytes-=chunk.text->size();
+      chunks.erase(chunks.begin()+index);
+      continue;
+    }
+    auto start=g_utf8_offset_to_pointer(chunk.text->data(), character_offset)-chunk.text->data();
+    auto end=g_utf8_offset_to_pointer(chunk.text->data()+start, erase_characters)-chunk.text->data();
+    bytes-=end-start;
+    auto new_text=std::make_shared<std::string>();
+    new_text->reserve(chunk.text->size()-(end-start));
+    new_text->append(*chunk.text, 0, start);
+    new_text->append(*chunk.text, end, std::string::npos);
+    chunk.text=std::move(new_text);
+    chunk.characters-=erase_characters;
+    ++index;
+    character_offset=0;
+  }
+  
+  //Small neighbouring chunks are merged
+  for(auto index=position.first+1;index>=position.first && index>0;--index) {
+    if(index<chunks.size() && chunks[index-1].text->size()+chunks[index].text->size()<chunk_size) {
+      chunks[index-1].text=std::make_shared<const std::string>(*chunks[index-1].text+*chunks[index].text);
+      chunks[index-1].characters+=chunks[index].characters;
+      chunks.erase(chunks.begin()+index);
+    }
+  }
+}
+
+Source::SnapshotView::SnapshotView() : Gsv::View(), snapshot_buffer(get_buffer()) {}
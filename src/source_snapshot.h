@@ -0,0 +1,102 @@
+#ifndef JUCI_SOURCE_SNAPSHOT_H_
+#define JUCI_SOURCE_SNAPSHOT_H_
+#include <gtksourceviewmm.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace Source {
+  ///A change of a buffer, where offset, removed and inserted are in characters
+  class Edit {
+  public:
+    size_t offset;
+    size_t removed;
+    size_t inserted;
+    ///The generation of the buffer after the change
+    size_t generation;
+  };
+  
+  ///Immutable text of a buffer at one point in time. Copies are cheap, and the snapshot can be used from any thread.
+  class Snapshot {
+    friend class SnapshotBuffer;
+    class Chunk {
+    public:
+      std::shared_ptr<const std::string> text;
+      size_t characters;
+    };
+    class Text {
+    public:
+      std::once_flag once_flag;
+      std::string text;
+    };
+  public:
+    ///Number of bytes
+    size_t size() const { return bytes; }
+    bool empty() const { return bytes==0; }
+    ///Increased for each change of the buffer, and 0 if the snapshot is not from a buffer
+    size_t generation=0;
+    ///Returns the text as one string. The string is created on the first call, and is shared between the snapshots of the same generation.
+    const std::string &str() const;
+  private:
+    std::shared_ptr<const std::vector<Chunk> > chunks;
+    std::shared_ptr<Text> text;
+    size_t bytes=0;
+  };
+  
+  ///Keeps a copy of a text buffer in chunks that are updated from the buffer's insert and erase signals.
+  ///A snapshot shares the chunks, and a changed chunk is copied instead of modified.
+  class SnapshotBuffer {
+  public:
+    SnapshotBuffer(const Glib::RefPtr<Gtk::TextBuffer> &buffer);
+    ~SnapshotBuffer();
+    
+    ///Must be called from the thread that changes the buffer
+    Snapshot get();
+    size_t get_generation() { return generation; }
+    
+    ///Returns the changes made after the given generation, where changes next to each other are coalesced.
+    ///If the changes are no longer kept, a change of the whole buffer with removed set to std::string::npos is returned.
+    std::vector<Edit> get_edits(size_t generation);
+    
+    static const size_t chunk_size=16384;
+    static const size_t max_edits=1024;
+  private:
+    void insert(size_t offset, const char *text, size_t bytes);
+    void erase(size_t offset, size_t characters);
+    ///Returns the chunks for modification, copied if shared with a snapshot
+    std::vector<Snapshot::Chunk> &get_chunks();
+    ///Returns the chunk index and the character offset in that chunk
+    std::pair<size_t, size_t> find(size_t offset);
+    ///Splits the chunk at index into chunks of about chunk_size bytes
+    void split(size_t index);
+    void add_edit(size_t offset, size_t removed, size_t inserted);
+    
+    std::shared_ptr<std::vector<Snapshot::Chunk> > chunks;
+    std::shared_ptr<Snapshot::Text> text;
+    size_t bytes=0;
+    size_t characters=0;
+    size_t generation=1;
+    std::deque<Edit> edits;
+    
+    sigc::connection insert_connection;
+    sigc::connection erase_connection;
+  };
+  
+  ///Shares the text and the changes of the buffer between the view classes, and with their threads.
+  ///A class that updates after changes keeps the generation it last updated at, and asks for the edits after it.
+  class SnapshotView : virtual public Gsv::View {
+  public:
+    SnapshotView();
+    
+    ///Returns the current text of the buffer, without copying the text
+    Snapshot get_snapshot() { return snapshot_buffer.get(); }
+    size_t get_generation() { return snapshot_buffer.get_generation(); }
+    std::vector<Edit> get_edits(size_t generation) { return snapshot_buffer.get_edits(generation); }
+  private:
+    SnapshotBuffer snapshot_buffer;
+  };
+}
+
+#endif // JUCI_SOURCE_SNAPSHOT_H_
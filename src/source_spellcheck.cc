@@ -1,6 +1,8 @@
 #include "source_spellcheck.h"
 #include "config.h"
+#include "trace.h"
 #include <iostream>
+#include <algorithm>
 
 namespace sigc {
 #ifndef SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
@@ -86,7 +88,16 @@ Source::SpellCheckView::SpellCheckView() : Gsv::View() {
     }
     delayed_spellcheck_error_clear.disconnect();
     delayed_spellcheck_error_clear=Glib::signal_timeout().connect([this]() {
-      auto iter=get_buffer()->begin();
+      //The context classes can only have changed after the first edited line
+      auto edits=get_edits(spellcheck_error_clear_generation);
+      spellcheck_error_clear_generation=get_generation();
+      if(edits.empty())
+        return false;
+      auto offset=edits.front().offset;
+      for(auto &edit: edits)
+        offset=std::min(offset, edit.offset);
+      auto iter=get_buffer()->get_iter_at_offset(offset);
+      iter.set_line_offset(0);
       Gtk::TextIter begin_no_spellcheck_iter;
       if(spellcheck_all) {
         bool spell_check=!get_source_buffer()->iter_has_context_class(iter, "no-spell-check");
@@ -232,6 +243,7 @@ void Source::SpellCheckView::spellcheck(const Gtk::TextIter& start, const Gtk::T
 }
 
 void Source::SpellCheckView::spellcheck() {
+  TRACE_SCOPE("SpellCheckView::spellcheck");
   auto iter=get_buffer()->begin();
   Gtk::TextIter begin_spellcheck_iter;
   if(spellcheck_all) {
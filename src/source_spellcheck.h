@@ -3,9 +3,10 @@
 #include <gtksourceviewmm.h>
 #include <aspell.h>
 #include "selectiondialog.h"
+#include "source_snapshot.h"
 
 namespace Source {
-  class SpellCheckView : virtual public Gsv::View {
+  class SpellCheckView : virtual public SnapshotView {
   public:
     SpellCheckView();
     ~SpellCheckView();
@@ -34,6 +35,8 @@ namespace Source {
     std::vector<std::string> spellcheck_get_suggestions(const Gtk::TextIter& start, const Gtk::TextIter& end);
     sigc::connection delayed_spellcheck_suggestions_connection;
     sigc::connection delayed_spellcheck_error_clear;
+    ///The buffer generation of the last error clear
+    size_t spellcheck_error_clear_generation=0;
     
     void spellcheck(const Gtk::TextIter& start, const Gtk::TextIter& end);
   };
@@ -157,6 +157,20 @@ void Terminal::kill_last_async_process(bool force) {
     processes.back()->kill(force);
 }
 
+size_t Terminal::get_background_job_count() {
+  size_t count=0;
+  {
+    std::unique_lock<std::mutex> lock(processes_mutex);
+    count+=processes.size();
+  }
+  std::unique_lock<std::mutex> lock(in_progresses_mutex);
+  for(auto &in_progress: in_progresses) {
+    if(!in_progress->stop)
+      ++count;
+  }
+  return count;
+}
+
 void Terminal::kill_async_processes(bool force) {
   std::unique_lock<std::mutex> lock(processes_mutex);
   for(auto &process: processes)
@@ -285,13 +299,31 @@ std::shared_ptr<Terminal::InProgress> Terminal::print_in_progress(std::string st
 }
 
 void Terminal::async_print(const std::string &message, bool bold) {
-  dispatcher.post([this, message, bold] {
-    Terminal::get().print(message, bold);
+  {
+    std::unique_lock<std::mutex> lock(async_print_mutex);
+    bool post=async_print_messages.empty();
+    //Consecutive messages with the same style are printed together
+    if(!post && async_print_messages.back().second==bold)
+      async_print_messages.back().first+=message;
+    else
+      async_print_messages.emplace_back(message, bold);
+    if(!post)
+      return;
+  }
+  dispatcher.post("Terminal async print", [this] {
+    std::vector<std::pair<std::string, bool> > messages;
+    {
+      std::unique_lock<std::mutex> lock(async_print_mutex);
+      messages=std::move(async_print_messages);
+      async_print_messages.clear();
+    }
+    for(auto &message: messages)
+      print(message.first, message.second);
   });
 }
 
 void Terminal::async_print(size_t line_nr, const std::string &message) {
-  dispatcher.post([this, line_nr, message] {
+  dispatcher.post("Terminal async print line", [this, line_nr, message] {
     if(line_nr<deleted_lines)
       return;
     
@@ -44,6 +44,8 @@ public:
   void async_process(const std::string &command, const boost::filesystem::path &path="", std::function<void(int exit_status)> callback=nullptr);
   void kill_last_async_process(bool force=false);
   void kill_async_processes(bool force=false);
+  ///Returns the number of running async processes and unfinished progress messages
+  size_t get_background_job_count();
   
   size_t print(const std::string &message, bool bold=false);
   std::shared_ptr<InProgress> print_in_progress(std::string start_msg);
@@ -73,6 +75,10 @@ private:
   
   std::unordered_set<InProgress*> in_progresses;
   std::mutex in_progresses_mutex;
+  
+  ///Messages from async_print that are not yet printed
+  std::vector<std::pair<std::string, bool> > async_print_messages;
+  std::mutex async_print_mutex;
 };
 
 #endif  // JUCI_TERMINAL_H_
@@ -0,0 +1,188 @@
+#include "trace.h"
+#include "filesystem.h"
+#include <unordered_map>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+
+std::atomic<bool> Trace::enabled(false);
+std::atomic<int> Trace::active_scopes(0);
+std::mutex Trace::buffers_mutex;
+std::vector<std::shared_ptr<Trace::Buffer> > Trace::buffers;
+size_t Trace::threads=0;
+std::thread::id Trace::main_thread_id=std::this_thread::get_id();
+std::chrono::steady_clock::time_point Trace::start_time=std::chrono::steady_clock::now();
+std::atomic<std::chrono::steady_clock::rep> Trace::last_event_time(std::chrono::steady_clock::now().time_since_epoch().count());
+
+namespace {
+  void copy_name(std::array<char, 80> &name, const char *text, size_t size, size_t offset=0) {
+    size=std::min(size, name.size()-1-offset);
+    std::memcpy(name.data()+offset, text, size);
+    name[offset+size]=0;
+  }
+}
+
+Trace::Scope::Scope(const char *name) : active(true) {
+  copy_name(this->name, name, std::strlen(name));
+  ++active_scopes;
+  start=std::chrono::steady_clock::now();
+}
+
+Trace::Scope::Scope(const char *name, const std::string &detail) : active(true) {
+  auto size=std::strlen(name);
+  copy_name(this->name, name, size);
+  if(size+1<this->name.size()-1) {
+    this->name[size]=' ';
+    copy_name(this->name, detail.c_str(), detail.size(), size+1);
+  }
+  ++active_scopes;
+  start=std::chrono::steady_clock::now();
+}
+
+Trace::Scope::Scope(Scope &&other) : active(other.active), start(other.start), name(other.name) {
+  other.active=false;
+}
+
+Trace::Scope::~Scope() {
+  if(active) {
+    add(name, start, std::chrono::steady_clock::now());
+    --active_scopes;
+  }
+}
+
+Trace::ThreadBuffer::~ThreadBuffer() {
+  if(buffer)
+    buffer->finished=true;
+}
+
+Trace::Buffer &Trace::get_buffer() {
+  thread_local ThreadBuffer thread_buffer;
+  if(!thread_buffer.buffer) {
+    auto buffer=std::make_shared<Buffer>();
+    buffer->end=0;
+    buffer->begin=0;
+    buffer->finished=false;
+    std::unique_lock<std::mutex> lock(buffers_mutex);
+    buffer->thread=std::this_thread::get_id()==main_thread_id?0:++threads;
+    size_t finished_buffers=0;
+    for(auto &buffer: buffers) {
+      if(buffer->finished)
+        ++finished_buffers;
+    }
+    for(auto it=buffers.begin();it!=buffers.end() && finished_buffers>=max_finished_buffers;) {
+      if((*it)->finished) {
+        it=buffers.erase(it);
+        --finished_buffers;
+      }
+      else
+        ++it;
+    }
+    buffers.emplace_back(buffer);
+    thread_buffer.buffer=std::move(buffer);
+  }
+  return *thread_buffer.buffer;
+}
+
+void Trace::add(const std::array<char, 80> &name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end) {
+  auto &buffer=get_buffer();
+  auto index=buffer.end.load(std::memory_order_relaxed);
+  auto &slot=buffer.slots[index%buffer_size];
+  slot.name=name;
+  slot.start=start;
+  slot.end=end;
+  buffer.end.store(index+1, std::memory_order_release);
+  last_event_time.store(end.time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+std::chrono::steady_clock::time_point Trace::get_last_event_time() {
+  return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(last_event_time.load(std::memory_order_relaxed)));
+}
+
+void Trace::clear() {
+  std::unique_lock<std::mutex> lock(buffers_mutex);
+  for(auto &buffer: buffers)
+    buffer->begin=buffer->end.load(std::memory_order_acquire);
+  start_time=std::chrono::steady_clock::now();
+  last_event_time=start_time.time_since_epoch().count();
+}
+
+std::vector<Trace::Event> Trace::get_events() {
+  std::vector<Event> events;
+  std::unique_lock<std::mutex> lock(buffers_mutex);
+  for(auto &buffer: buffers) {
+    auto end=buffer->end.load(std::memory_order_acquire);
+    auto begin=std::max(buffer->begin.load(), end>buffer_size?end-buffer_size:0);
+    std::vector<Slot> slots;
+    slots.reserve(end-begin);
+    for(auto index=begin;index<end;++index)
+      slots.emplace_back(buffer->slots[index%buffer_size]);
+    //Events that the thread overwrote while they were copied are skipped, including the slot it might be writing
+    std::atomic_thread_fence(std::memory_order_acquire);
+    auto new_end=buffer->end.load(std::memory_order_relaxed);
+    auto valid_begin=new_end>=buffer_size?new_end-buffer_size+1:0;
+    for(auto index=std::max(begin, valid_begin);index<end;++index) {
+      auto &slot=slots[index-begin];
+      slot.name.back()=0;
+      events.emplace_back(Event{slot.name.data(), buffer->thread, slot.start, slot.end});
+    }
+  }
+  std::stable_sort(events.begin(), events.end(), [](const Event &lhs, const Event &rhs) {
+    return lhs.start<rhs.start;
+  });
+  return events;
+}
+
+bool Trace::write(const boost::filesystem::path &file_path) {
+  auto events=get_events();
+  std::chrono::steady_clock::time_point start_time;
+  {
+    std::unique_lock<std::mutex> lock(buffers_mutex);
+    start_time=Trace::start_time;
+  }
+  std::stringstream ss;
+  ss << "{\"traceEvents\":[";
+  ss << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"main\"}}";
+  for(auto &event: events) {
+    std::string name;
+    for(auto &chr: event.name) {
+      if(chr=='"' || chr=='\\')
+        name+='\\';
+      if(static_cast<unsigned char>(chr)>=' ')
+        name+=chr;
+    }
+    ss << ",\n{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+       << ",\"ts\":" << std::chrono::duration_cast<std::chrono::microseconds>(event.start-start_time).count()
+       << ",\"dur\":" << std::chrono::duration_cast<std::chrono::microseconds>(event.end-event.start).count() << "}";
+  }
+  ss << "\n]}\n";
+  return filesystem::write(file_path, ss.str());
+}
+
+std::string Trace::get_summary(size_t max_lines) {
+  std::vector<std::pair<std::string, std::pair<std::chrono::steady_clock::duration, size_t> > > durations;
+  std::unordered_map<std::string, size_t> names;
+  for(auto &event: get_events()) {
+    auto it=names.find(event.name);
+    if(it==names.end()) {
+      it=names.emplace(event.name, durations.size()).first;
+      durations.emplace_back(event.name, std::make_pair(std::chrono::steady_clock::duration::zero(), 0));
+    }
+    durations[it->second].second.first+=event.end-event.start;
+    ++durations[it->second].second.second;
+  }
+  std::stable_sort(durations.begin(), durations.end(), [](const std::pair<std::string, std::pair<std::chrono::steady_clock::duration, size_t> > &lhs,
+                                                          const std::pair<std::string, std::pair<std::chrono::steady_clock::duration, size_t> > &rhs) {
+    return lhs.second.first>rhs.second.first;
+  });
+  
+  std::stringstream ss;
+  for(size_t c=0;c<durations.size() && c<max_lines;++c) {
+    ss << std::setw(10) << std::fixed << std::setprecision(1)
+       << std::chrono::duration_cast<std::chrono::microseconds>(durations[c].second.first).count()/1000.0 << " ms  " << durations[c].first;
+    if(durations[c].second.second>1)
+      ss << " (" << durations[c].second.second << " times)";
+    ss << '\n';
+  }
+  return ss.str();
+}
@@ -0,0 +1,97 @@
+#ifndef JUCI_TRACE_H_
+#define JUCI_TRACE_H_
+#include <boost/filesystem.hpp>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <array>
+
+#define JUCI_TRACE_CONCATENATE_(a, b) a##b
+#define JUCI_TRACE_CONCATENATE(a, b) JUCI_TRACE_CONCATENATE_(a, b)
+///Traces the rest of the enclosing scope. The arguments, a name and optionally a std::string detail, are only evaluated when tracing is enabled.
+#define TRACE_SCOPE(...) auto JUCI_TRACE_CONCATENATE(trace_scope_, __LINE__)=Trace::enabled.load(std::memory_order_relaxed)?Trace::Scope(__VA_ARGS__):Trace::Scope()
+
+///Records the duration of named scopes that can be written as a Chrome trace (see chrome://tracing).
+///Each thread writes to its own ring buffer without locks, and the oldest events of a thread are overwritten when its buffer is full.
+class Trace {
+public:
+  class Event {
+  public:
+    std::string name;
+    ///Index of the thread in the order the threads were first traced, where 0 is the main thread
+    size_t thread;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+  };
+  
+  class Scope {
+  public:
+    ///An inactive scope
+    Scope() : active(false) {}
+    Scope(const char *name);
+    Scope(const char *name, const std::string &detail);
+    Scope(Scope &&other);
+    ~Scope();
+  private:
+    bool active;
+    std::chrono::steady_clock::time_point start;
+    std::array<char, 80> name;
+  };
+  
+  static std::atomic<bool> enabled;
+  ///Number of scopes that are not yet finished
+  static std::atomic<int> active_scopes;
+  
+  static std::chrono::steady_clock::time_point get_last_event_time();
+  static void clear();
+  ///Returns the recorded events of all threads, sorted on start time
+  static std::vector<Event> get_events();
+  
+  ///Returns false on error
+  static bool write(const boost::filesystem::path &file_path);
+  ///Returns the events with the longest total duration, one event name per line
+  static std::string get_summary(size_t max_lines);
+  
+  ///Events per thread that are kept
+  static const size_t buffer_size=4096;
+  ///Buffers of threads that have ended are removed when there are more than this
+  static const size_t max_finished_buffers=64;
+private:
+  class Slot {
+  public:
+    std::array<char, 80> name;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+  };
+  class Buffer {
+  public:
+    size_t thread;
+    std::array<Slot, buffer_size> slots;
+    ///Number of events written, only changed by the thread of the buffer
+    std::atomic<size_t> end;
+    ///Events before this are cleared
+    std::atomic<size_t> begin;
+    std::atomic<bool> finished;
+  };
+  class ThreadBuffer {
+  public:
+    ~ThreadBuffer();
+    std::shared_ptr<Buffer> buffer;
+  };
+  
+  static Buffer &get_buffer();
+  static void add(const std::array<char, 80> &name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+  
+  static std::mutex buffers_mutex;
+  static std::vector<std::shared_ptr<Buffer> > buffers;
+  static size_t threads;
+  static std::thread::id main_thread_id;
+  static std::chrono::steady_clock::time_point start_time;
+  static std::atomic<std::chrono::steady_clock::rep> last_event_time;
+};
+
+#endif // JUCI_TRACE_H_
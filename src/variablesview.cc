@@ -0,0 +1,183 @@
+#include "variablesview.h"
+#include <algorithm>
+
+namespace sigc {
+#ifndef SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
+  template <typename Functor>
+  struct functor_trait<Functor, false> {
+    typedef decltype (::sigc::mem_fun(std::declval<Functor&>(),
+                                      &Functor::operator())) _intermediate;
+    typedef typename _intermediate::result_type result_type;
+    typedef Functor functor_type;
+  };
+#else
+  SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
+#endif
+}
+
+VariablesView::VariablesView() {
+  set_title("Variables");
+  set_default_size(600, 600);
+  
+  tree_store=Gtk::TreeStore::create(column_record);
+  tree_view.set_model(tree_store);
+  tree_view.append_column("Name", column_record.name);
+  auto value_column=Gtk::manage(new Gtk::TreeViewColumn("Value", value_renderer));
+  value_column->add_attribute(value_renderer.property_text(), column_record.value);
+  value_column->add_attribute(value_renderer.property_foreground_set(), column_record.changed);
+  value_renderer.property_foreground()="#cc0000";
+  tree_view.append_column(*value_column);
+  tree_view.set_search_column(column_record.name);
+  
+  //The children are read when a row is expanded the first time after it has been set
+  tree_view.signal_test_expand_row().connect([this](const Gtk::TreeModel::iterator &iter, const Gtk::TreeModel::Path &path) {
+    auto children=iter->children();
+    if(children.size()==1 && children.begin()->get_value(column_record.type)==PLACEHOLDER)
+      update_children(children, iter->get_value(column_record.key), page_size);
+    //Rows without children, for instance after the process has been resumed, are not expanded
+    return children.size()==0;
+  });
+  
+  tree_view.signal_row_activated().connect([this](const Gtk::TreeModel::Path &path, Gtk::TreeViewColumn *column) {
+    auto iter=tree_store->get_iter(path);
+    if(iter->get_value(column_record.type)==MORE)
+      add_page(iter);
+    else if(iter->get_value(column_record.type)==VARIABLE && on_activate)
+      on_activate(iter->get_value(column_record.key));
+  });
+  
+  tree_view.set_has_tooltip(true);
+  tree_view.signal_query_tooltip().connect([this](int x, int y, bool keyboard_tooltip, const Glib::RefPtr<Gtk::Tooltip> &tooltip) {
+    Gtk::TreeModel::iterator iter;
+    if(!get_tooltip || !tree_view.get_tooltip_context_iter(x, y, keyboard_tooltip, iter) || iter->get_value(column_record.type)!=VARIABLE)
+      return false;
+    auto text=get_tooltip(iter->get_value(column_record.key));
+    if(text.empty())
+      return false;
+    tooltip->set_text(text);
+    tree_view.set_tooltip_row(tooltip, tree_store->get_path(iter));
+    return true;
+  });
+  
+  menu_item_show_memory.set_label("Show Memory");
+  menu_item_show_memory.signal_activate().connect([this] {
+    if(on_show_memory)
+      on_show_memory(menu_popup_row_key);
+  });
+  menu.append(menu_item_show_memory);
+  menu.show_all();
+  
+  tree_view.signal_button_press_event().connect([this](GdkEventButton *event) {
+    if(event->type==GDK_BUTTON_PRESS && event->button==GDK_BUTTON_SECONDARY) {
+      Gtk::TreeModel::Path path;
+      if(tree_view.get_path_at_pos(static_cast<int>(event->x), static_cast<int>(event->y), path)) {
+        auto iter=tree_store->get_iter(path);
+        if(iter->get_value(column_record.type)==VARIABLE) {
+          menu_popup_row_key=iter->get_value(column_record.key);
+          menu.popup(event->button, event->time);
+          return true;
+        }
+      }
+    }
+    return false;
+  }, false);
+  
+  scrolled_window.add(tree_view);
+  add(scrolled_window);
+}
+
+void VariablesView::show(GetChildren get_children, size_t expanded_levels) {
+  this->get_children=std::move(get_children);
+  tree_store->clear();
+  update_children(tree_store->children(), "", page_size);
+  
+  auto iter=tree_store->children().begin();
+  for(size_t level=0;level<expanded_levels && iter;++level) {
+    tree_view.expand_row(tree_store->get_path(iter), false);
+    iter=iter->children().begin();
+  }
+  
+  show_all();
+  present();
+}
+
+void VariablesView::refresh() {
+  if(!get_children)
+    return;
+  update_children(tree_store->children(), "", page_size);
+}
+
+void VariablesView::update_children(const Gtk::TreeNodeChildren &children, const std::string &key, size_t minimum_size) {
+  size_t shown_size=0;
+  for(auto iter=children.begin();iter!=children.end();++iter) {
+    if(iter->get_value(column_record.type)==VARIABLE)
+      ++shown_size;
+  }
+  size_t size=0;
+  auto rows=get_children(key, 0, std::max(shown_size, minimum_size), size);
+  
+  //Rows with the same key are updated in place, and the rows that are no longer read are removed
+  auto iter=children.begin();
+  for(auto &row: rows) {
+    auto found=iter;
+    while(found!=children.end() && !(found->get_value(column_record.type)==VARIABLE && found->get_value(column_record.key)==row.key))
+      ++found;
+    if(found!=children.end()) {
+      while(iter!=found)
+        iter=tree_store->erase(iter);
+      set_row(iter, row);
+      ++iter;
+    }
+    else
+      set_row(tree_store->insert(iter), row);
+  }
+  while(iter!=children.end())
+    iter=tree_store->erase(iter);
+  
+  if(rows.size()<size) {
+    auto more_iter=tree_store->append(children);
+    more_iter->set_value(column_record.name, std::string("..."));
+    more_iter->set_value(column_record.value, std::to_string(size-rows.size())+" more");
+    more_iter->set_value(column_record.type, static_cast<int>(MORE));
+  }
+}
+
+void VariablesView::add_page(const Gtk::TreeModel::iterator &more_iter) {
+  auto parent=more_iter->parent();
+  Gtk::TreeNodeChildren children(parent?parent->children():tree_store->children());
+  auto shown_size=children.size()-1;
+  size_t size=0;
+  auto rows=get_children(parent?parent->get_value(column_record.key):std::string(), shown_size, page_size, size);
+  for(auto &row: rows)
+    set_row(tree_store->insert(more_iter), row);
+  if(shown_size+rows.size()<size)
+    more_iter->set_value(column_record.value, std::to_string(size-shown_size-rows.size())+" more");
+  else
+    tree_store->erase(more_iter);
+}
+
+void VariablesView::set_row(const Gtk::TreeModel::iterator &iter, const Row &row) {
+  if(iter->get_value(column_record.key)!=row.key)
+    iter->set_value(column_record.key, row.key);
+  if(iter->get_value(column_record.name)!=row.name)
+    iter->set_value(column_record.name, row.name);
+  if(iter->get_value(column_record.value)!=row.value)
+    iter->set_value(column_record.value, row.value);
+  if(iter->get_value(column_record.changed)!=row.changed)
+    iter->set_value(column_record.changed, row.changed);
+  if(iter->get_value(column_record.type)!=VARIABLE)
+    iter->set_value(column_record.type, static_cast<int>(VARIABLE));
+  
+  auto children=iter->children();
+  if(!row.has_children) {
+    while(children.size()>0)
+      tree_store->erase(children.begin());
+  }
+  else if(tree_view.row_expanded(tree_store->get_path(iter)))
+    update_children(children, row.key, page_size);
+  else if(children.size()!=1 || children.begin()->get_value(column_record.type)!=PLACEHOLDER) {
+    while(children.size()>0)
+      tree_store->erase(children.begin());
+    tree_store->append(children);
+  }
+}
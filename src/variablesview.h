@@ -0,0 +1,84 @@
+#ifndef JUCI_VARIABLESVIEW_H_
+#define JUCI_VARIABLESVIEW_H_
+
+#include <gtkmm.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+///Tree of variables where the children of a row are read when the row is expanded, one page of rows at a time
+class VariablesView : public Gtk::Window {
+  class ColumnRecord : public Gtk::TreeModel::ColumnRecord {
+  public:
+    ColumnRecord() {
+      add(key);
+      add(name);
+      add(value);
+      add(changed);
+      add(type);
+    }
+    Gtk::TreeModelColumn<std::string> key;
+    Gtk::TreeModelColumn<std::string> name;
+    Gtk::TreeModelColumn<std::string> value;
+    Gtk::TreeModelColumn<bool> changed;
+    Gtk::TreeModelColumn<int> type;
+  };
+  ///New rows are PLACEHOLDER rows until they are set
+  enum RowType {PLACEHOLDER, MORE, VARIABLE};
+  
+  VariablesView();
+public:
+  static VariablesView &get() {
+    static VariablesView singleton;
+    return singleton;
+  }
+  
+  class Row {
+  public:
+    ///Identifies the row, also after the rows have been read again
+    std::string key;
+    std::string name;
+    std::string value;
+    ///Highlights the value
+    bool changed=false;
+    bool has_children=false;
+  };
+  ///Returns at most count children, starting at child start, of the row with key, and sets size to the number of children.
+  ///The key of the top level is empty.
+  typedef std::function<std::vector<Row>(const std::string &key, size_t start, size_t count, size_t &size)> GetChildren;
+  
+  ///Shows the top level rows, and expands the first row of the first expanded_levels levels
+  void show(GetChildren get_children, size_t expanded_levels=0);
+  ///Reads the top level and the expanded rows again, and only updates the rows that have changed
+  void refresh();
+  
+  std::function<void(const std::string &key)> on_activate;
+  ///Called from the context menu of a row
+  std::function<void(const std::string &key)> on_show_memory;
+  ///Returns the tooltip of a row, for instance its type, called when the tooltip is shown
+  std::function<std::string(const std::string &key)> get_tooltip;
+  
+  static const size_t page_size=100;
+
+private:
+  Gtk::ScrolledWindow scrolled_window;
+  Gtk::TreeView tree_view;
+  Glib::RefPtr<Gtk::TreeStore> tree_store;
+  ColumnRecord column_record;
+  Gtk::CellRendererText value_renderer;
+  Gtk::Menu menu;
+  Gtk::MenuItem menu_item_show_memory;
+  std::string menu_popup_row_key;
+  
+  GetChildren get_children;
+  
+  ///Reads the children of the row with key again, at least as many as are shown, and updates the rows that have changed
+  void update_children(const Gtk::TreeNodeChildren &children, const std::string &key, size_t minimum_size);
+  ///Reads the next page of children and adds them before the MORE row
+  void add_page(const Gtk::TreeModel::iterator &more_iter);
+  ///Only sets the columns that have changed. The children of expanded rows are updated,
+  ///and the children of collapsed rows are read again when the rows are expanded.
+  void set_row(const Gtk::TreeModel::iterator &iter, const Row &row);
+};
+
+#endif // JUCI_VARIABLESVIEW_H_
@@ -0,0 +1,232 @@
+#include "watchdog.h"
+#include <glibmm.h>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <array>
+#include <ctime>
+#ifndef _WIN32
+#include <execinfo.h>
+#include <csignal>
+#include <cstring>
+#include <cstdlib>
+#include <pthread.h>
+#include <cxxabi.h>
+#endif
+
+std::atomic<const char *> Watchdog::task(nullptr);
+
+namespace {
+#ifndef _WIN32
+  pthread_t main_thread;
+  std::array<void *, 64> backtrace_frames;
+  std::atomic<int> backtrace_size(-1);
+  
+  void backtrace_signal_handler(int) {
+    backtrace_size.store(backtrace(backtrace_frames.data(), backtrace_frames.size()), std::memory_order_release);
+  }
+  
+  ///Demangles the C++ symbols in a line from backtrace_symbols
+  std::string demangle(const std::string &line) {
+    std::string result;
+    size_t pos=0;
+    while(true) {
+      auto start=line.find("_Z", pos);
+      if(start==std::string::npos) {
+        result+=line.substr(pos);
+        break;
+      }
+      auto end=line.find_first_of("+) ", start);
+      auto symbol=line.substr(start, end==std::string::npos?std::string::npos:end-start);
+      result+=line.substr(pos, start-pos);
+      int status;
+      auto demangled=abi::__cxa_demangle(symbol.c_str(), nullptr, nullptr, &status);
+      result+=status==0 && demangled?demangled:symbol;
+      std::free(demangled);
+      if(end==std::string::npos)
+        break;
+      pos=end;
+    }
+    return result;
+  }
+#endif
+
+  std::string get_time_string(std::chrono::system_clock::time_point time_point) {
+    auto time=std::chrono::system_clock::to_time_t(time_point);
+    std::array<char, 32> buffer;
+    if(std::strftime(buffer.data(), buffer.size(), "%Y-%m-%d %H:%M:%S", std::localtime(&time))==0)
+      return std::string();
+    return buffer.data();
+  }
+}
+
+Watchdog::~Watchdog() {
+  stop();
+}
+
+void Watchdog::start(std::chrono::milliseconds threshold, const boost::filesystem::path &log_path) {
+  if(thread.joinable() || threshold<=std::chrono::milliseconds::zero())
+    return;
+  this->threshold=threshold;
+  interval=std::max(threshold/2, std::chrono::milliseconds(1));
+  this->log_path=log_path;
+  stopping=false;
+  pending_stalls.clear();
+  histogram.assign(histogram_size, 0);
+  captured_heartbeat=0;
+
+#ifndef _WIN32
+  main_thread=pthread_self();
+  //Loads the unwinder before backtrace is called from the signal handler
+  std::array<void *, 1> frames;
+  backtrace(frames.data(), frames.size());
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_handler=backtrace_signal_handler;
+  action.sa_flags=SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGUSR2, &action, nullptr);
+#endif
+
+  last_heartbeat=std::chrono::steady_clock::now().time_since_epoch().count();
+  heartbeat_connection=Glib::signal_timeout().connect([this] {
+    heartbeat();
+    return true;
+  }, std::chrono::duration_cast<std::chrono::milliseconds>(interval).count());
+  thread=std::thread([this] {
+    run();
+  });
+}
+
+void Watchdog::stop() {
+  if(!thread.joinable())
+    return;
+  heartbeat_connection.disconnect();
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    stopping=true;
+  }
+  condition_variable.notify_one();
+  thread.join();
+  
+  size_t stalls=0;
+  for(auto &count: get_histogram())
+    stalls+=count;
+  if(stalls>0) {
+    std::ofstream stream(log_path.string(), std::ofstream::app);
+    stream << get_time_string(std::chrono::system_clock::now()) << " main loop stalls this session: " << stalls << "\n" << get_histogram_string();
+  }
+}
+
+void Watchdog::heartbeat() {
+  auto now=std::chrono::steady_clock::now().time_since_epoch().count();
+  auto previous=last_heartbeat.exchange(now);
+  auto duration=std::chrono::steady_clock::duration(now-previous)-interval;
+  if(duration>=threshold) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      pending_stalls.emplace_back(PendingStall{previous, duration});
+    }
+    condition_variable.notify_one();
+  }
+}
+
+std::vector<size_t> Watchdog::get_histogram() {
+  std::unique_lock<std::mutex> lock(mutex);
+  return histogram;
+}
+
+std::string Watchdog::get_histogram_string() {
+  auto histogram=get_histogram();
+  auto threshold_ms=std::chrono::duration_cast<std::chrono::milliseconds>(threshold).count();
+  std::stringstream ss;
+  for(size_t c=0;c<histogram.size();++c) {
+    ss << std::setw(8) << (threshold_ms<<c) << " ms";
+    if(c+1<histogram.size())
+      ss << " - " << std::setw(8) << (threshold_ms<<(c+1)) << " ms: ";
+    else
+      ss << " or more:    ";
+    ss << histogram[c] << '\n';
+  }
+  return ss.str();
+}
+
+void Watchdog::run() {
+  auto check_interval=std::max(threshold/4, std::chrono::steady_clock::duration(std::chrono::milliseconds(1)));
+  std::unique_lock<std::mutex> lock(mutex);
+  while(true) {
+    condition_variable.wait_for(lock, check_interval);
+    auto stopping=this->stopping;
+    std::vector<PendingStall> pending_stalls;
+    pending_stalls.swap(this->pending_stalls);
+    lock.unlock();
+    
+    auto now=std::chrono::steady_clock::now();
+    auto heartbeat=last_heartbeat.load();
+    if(!stopping && heartbeat!=captured_heartbeat && now-std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(heartbeat))>=threshold+interval)
+      capture();
+    
+    for(auto &pending_stall: pending_stalls) {
+      Stall stall;
+      auto heartbeat_time=std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(pending_stall.heartbeat));
+      stall.time=std::chrono::system_clock::now()-std::chrono::duration_cast<std::chrono::system_clock::duration>(now-heartbeat_time);
+      stall.duration=std::chrono::duration_cast<std::chrono::milliseconds>(pending_stall.duration);
+      if(pending_stall.heartbeat==captured_heartbeat) {
+        stall.task=captured_task;
+        stall.backtrace=captured_backtrace;
+      }
+      log(stall);
+      
+      size_t index=0;
+      for(auto multiple=pending_stall.duration/threshold;multiple>=2 && index+1<histogram_size;multiple/=2)
+        ++index;
+      std::unique_lock<std::mutex> histogram_lock(mutex);
+      ++histogram[index];
+    }
+    
+    lock.lock();
+    if(stopping)
+      break;
+  }
+}
+
+void Watchdog::capture() {
+  captured_heartbeat=last_heartbeat.load();
+  auto task=Watchdog::task.load(std::memory_order_relaxed);
+  captured_task=task?task:"";
+  captured_backtrace.clear();
+#ifndef _WIN32
+  backtrace_size.store(-1);
+  if(pthread_kill(main_thread, SIGUSR2)!=0)
+    return;
+  for(int c=0;c<100 && backtrace_size.load(std::memory_order_acquire)<0;++c)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  auto size=backtrace_size.load(std::memory_order_acquire);
+  //The stall ended before the backtrace was taken
+  if(size<=0 || last_heartbeat.load()!=captured_heartbeat)
+    return;
+  if(auto symbols=backtrace_symbols(backtrace_frames.data(), size)) {
+    //The first two frames are the signal handler and the signal trampoline
+    for(int c=2;c<size;++c)
+      captured_backtrace.emplace_back(demangle(symbols[c]));
+    std::free(symbols);
+  }
+#endif
+}
+
+void Watchdog::log(const Stall &stall) {
+  boost::system::error_code ec;
+  auto size=boost::filesystem::file_size(log_path, ec);
+  if(!ec && size>=max_log_size)
+    boost::filesystem::rename(log_path, log_path.string()+".1", ec);
+  
+  std::ofstream stream(log_path.string(), std::ofstream::app);
+  if(!stream)
+    return;
+  stream << get_time_string(stall.time) << " stall of " << stall.duration.count() << " ms";
+  if(!stall.task.empty())
+    stream << " in " << stall.task;
+  stream << '\n';
+  for(size_t c=0;c<stall.backtrace.size();++c)
+    stream << "  #" << c << ' ' << stall.backtrace[c] << '\n';
+}
@@ -0,0 +1,92 @@
+#ifndef JUCI_WATCHDOG_H_
+#define JUCI_WATCHDOG_H_
+#include <boost/filesystem.hpp>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+#include <sigc++/sigc++.h>
+
+///Logs when the main loop is blocked for longer than a threshold, together with the running task and the backtrace of the main thread.
+///The main loop sends heartbeats that a separate thread checks.
+class Watchdog {
+public:
+  ///Names the task that the main thread runs, until the task goes out of scope.
+  ///The name must be valid until the watchdog is stopped.
+  class Task {
+  public:
+    Task(const char *name) : previous(task.exchange(name, std::memory_order_relaxed)) {}
+    ~Task() { task.store(previous, std::memory_order_relaxed); }
+  private:
+    const char *previous;
+  };
+  
+  class Stall {
+  public:
+    std::chrono::system_clock::time_point time;
+    std::chrono::milliseconds duration;
+    std::string task;
+    ///Backtrace of the main thread during the stall, innermost frame first. Empty if the backtrace could not be captured in time.
+    std::vector<std::string> backtrace;
+  };
+
+private:
+  Watchdog() {}
+public:
+  static Watchdog &get() {
+    static Watchdog singleton;
+    return singleton;
+  }
+  ~Watchdog();
+  
+  ///Must be called from the main thread. Stalls are appended to log_path, which is rotated when it gets too large.
+  void start(std::chrono::milliseconds threshold, const boost::filesystem::path &log_path);
+  ///Stops the watchdog and appends the histogram of this session's stalls to the log
+  void stop();
+  ///Called by the main loop, normally from a timeout that start() adds
+  void heartbeat();
+  
+  ///Number of stalls per duration range, where range i is [threshold*2^i, threshold*2^(i+1)) and the last range is open-ended
+  std::vector<size_t> get_histogram();
+  std::string get_histogram_string();
+  
+  static const size_t histogram_size=8;
+  ///The log is moved to log_path with .1 appended when it gets larger than this
+  static const size_t max_log_size=1024*1024;
+  
+  static std::atomic<const char *> task;
+private:
+  class PendingStall {
+  public:
+    std::chrono::steady_clock::rep heartbeat;
+    std::chrono::steady_clock::duration duration;
+  };
+  
+  void run();
+  ///Captures the task and backtrace of the main thread while it is blocked
+  void capture();
+  void log(const Stall &stall);
+  
+  std::chrono::steady_clock::duration threshold=std::chrono::steady_clock::duration::zero();
+  std::chrono::steady_clock::duration interval=std::chrono::steady_clock::duration::zero();
+  boost::filesystem::path log_path;
+  std::atomic<std::chrono::steady_clock::rep> last_heartbeat;
+  sigc::connection heartbeat_connection;
+  
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable condition_variable;
+  bool stopping=false;
+  std::vector<PendingStall> pending_stalls;
+  std::vector<size_t> histogram;
+  
+  ///Heartbeat that the captured task and backtrace belong to
+  std::chrono::steady_clock::rep captured_heartbeat=0;
+  std::string captured_task;
+  std::vector<std::string> captured_backtrace;
+};
+
+#endif // JUCI_WATCHDOG_H_
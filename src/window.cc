@@ -9,6 +9,9 @@
 #include "entrybox.h"
 #include "info.h"
 #include "ctags.h"
+#include "trace.h"
+#include "performance_hud.h"
+#include "assemblyview.h"
 
 namespace sigc {
 #ifndef SIGC_FUNCTORS_DEDUCE_RESULT_TYPE_WITH_DECLTYPE
@@ -37,8 +40,12 @@ Window::Window() {
   auto directories_scrolled_window=Gtk::manage(new Gtk::ScrolledWindow());
   directories_scrolled_window->add(Directories::get());
   
+  auto notebook_and_assembly_hpaned=Gtk::manage(new Gtk::HPaned());
+  notebook_and_assembly_hpaned->pack1(Notebook::get(), true, true);
+  notebook_and_assembly_hpaned->pack2(AssemblyView::get(), false, true);
+  
   auto notebook_vbox=Gtk::manage(new Gtk::VBox());
-  notebook_vbox->pack_start(Notebook::get());
+  notebook_vbox->pack_start(*notebook_and_assembly_hpaned);
   notebook_vbox->pack_end(EntryBox::get(), Gtk::PACK_SHRINK);
   
   auto terminal_scrolled_window=Gtk::manage(new Gtk::ScrolledWindow());
@@ -58,6 +65,7 @@ Window::Window() {
   info_and_status_hbox->pack_start(Notebook::get().info, Gtk::PACK_SHRINK);
   info_and_status_hbox->set_center_widget(Project::debug_status_label());
   info_and_status_hbox->pack_end(Notebook::get().status, Gtk::PACK_SHRINK);
+  info_and_status_hbox->pack_end(PerformanceHud::get(), Gtk::PACK_SHRINK);
   
   auto vbox=Gtk::manage(new Gtk::VBox());
   vbox->pack_start(*hpaned);
@@ -125,6 +133,8 @@ Window::Window() {
     view->set_status(view->status);
     view->set_info(view->info);
     
+    AssemblyView::get().on_change_view(view);
+    
 #ifdef JUCI_ENABLE_DEBUG
     if(Project::debugging)
       Project::debug_update_stop();
@@ -142,6 +152,7 @@ Window::Window() {
       }
     }
 #endif
+    AssemblyView::get().on_close_view(view);
     EntryBox::get().hide();
   };
   
@@ -171,7 +182,10 @@ Window::Window() {
 } // Window constructor
 
 void Window::configure() {
-  Config::get().load();
+  {
+    TRACE_SCOPE("Config::load");
+    Config::get().load();
+  }
   auto screen = Gdk::Screen::get_default();
   if(css_provider)
     Gtk::StyleContext::remove_provider_for_screen(screen, css_provider);
@@ -479,39 +493,69 @@ void Window::set_menu_actions() {
   
   menu.add_action("source_find_symbol_ctags", [this]() {
     if(auto view=Notebook::get().get_current_view()) {
-      auto pair=Ctags::get_result(view->file_path.parent_path());
-      auto path=std::move(pair.first);
-      auto stream=std::move(pair.second);
-      stream->seekg(0, std::ios::end);
-      if(stream->tellg()==0)
-        return;
-      stream->seekg(0, std::ios::beg);
-      
       auto dialog_iter=view->get_iter_for_dialog();
       view->selection_dialog=std::make_unique<SelectionDialog>(*view, view->get_buffer()->create_mark(dialog_iter), true, true);
-      auto rows=std::make_shared<std::unordered_map<std::string, Source::Offset> >();
-        
-      std::string line;
-      while(std::getline(*stream, line)) {
-        auto location=Ctags::get_location(line, true);
-        
-        std::string row=location.file_path.string()+":"+std::to_string(location.line+1)+": "+location.source;
-        (*rows)[row]=Source::Offset(location.line, location.index, location.file_path);
-        view->selection_dialog->add_row(row);
-      }
-        
-      if(rows->size()==0)
-        return;
-      view->selection_dialog->on_select=[this, rows, path](const std::string &selected, bool hide_window) {
-        auto offset=rows->at(selected);
+      class Rows {
+      public:
+        std::mutex mutex;
+        boost::filesystem::path path;
+        std::unordered_map<std::string, Ctags::Location> locations;
+      };
+      auto rows=std::make_shared<Rows>();
+      
+      view->selection_dialog->set_row_markup([rows](const std::string &row) {
+        std::unique_lock<std::mutex> lock(rows->mutex);
+        auto it=rows->locations.find(row);
+        if(it==rows->locations.end())
+          return Glib::Markup::escape_text(row).raw();
+        return Glib::Markup::escape_text(it->second.file_path.string()).raw()+":"+std::to_string(it->second.line+1)+": "+Ctags::get_source_markup(it->second);
+      });
+      auto path=view->file_path.parent_path();
+      view->selection_dialog->add_rows_async([rows, path](const SelectionDialog::AddRow &add_row) {
+        auto pair=Ctags::get_result(path);
+        {
+          std::unique_lock<std::mutex> lock(rows->mutex);
+          rows->path=std::move(pair.first);
+        }
+        auto stream=std::move(pair.second);
+        std::string line;
+        while(std::getline(*stream, line)) {
+          auto location=Ctags::get_location(line, false);
+          if(!location)
+            continue;
+          std::string row=location.file_path.string()+":"+std::to_string(location.line+1)+": "+location.source;
+          {
+            std::unique_lock<std::mutex> lock(rows->mutex);
+            rows->locations[row]=std::move(location);
+          }
+          if(!add_row(std::move(row)))
+            return;
+        }
+      });
+      view->selection_dialog->on_rows_finished=[view, rows] {
+        std::unique_lock<std::mutex> lock(rows->mutex);
+        if(rows->locations.empty())
+          view->selection_dialog->hide();
+      };
+      view->selection_dialog->on_select=[this, rows](const std::string &selected, bool hide_window) {
+        boost::filesystem::path path;
+        Ctags::Location location;
+        {
+          std::unique_lock<std::mutex> lock(rows->mutex);
+          auto it=rows->locations.find(selected);
+          if(it==rows->locations.end())
+            return;
+          path=rows->path;
+          location=it->second;
+        }
         boost::filesystem::path declaration_file;
         boost::system::error_code ec;
-        declaration_file=boost::filesystem::canonical(path/offset.file_path, ec);
+        declaration_file=boost::filesystem::canonical(path/location.file_path, ec);
         if(ec)
           return;
         Notebook::get().open(declaration_file);
         auto view=Notebook::get().get_current_view();
-        view->place_cursor_at_line_index(offset.line, offset.index);
+        view->place_cursor_at_line_index(location.line, location.index);
         view->scroll_to_cursor_delayed(view, true, false);
         view->hide_tooltips();
       };
@@ -768,6 +812,30 @@ void Window::set_menu_actions() {
       }
     }
   });
+  menu.add_action("source_toggle_optimization_remarks", [this]() {
+    if(auto view=Notebook::get().get_current_view()) {
+      if(view->toggle_optimization_remarks)
+        view->toggle_optimization_remarks();
+    }
+  });
+  menu.add_action("source_show_record_layout", [this]() {
+    if(auto view=Notebook::get().get_current_view()) {
+      if(view->show_record_layout)
+        view->show_record_layout();
+    }
+  });
+  menu.add_action("source_show_record_layouts_report", [this]() {
+    if(auto view=Notebook::get().get_current_view()) {
+      if(view->show_record_layouts_report)
+        view->show_record_layouts_report(Notebook::get().get_views());
+    }
+  });
+  menu.add_action("source_toggle_assembly", [this]() {
+    if(AssemblyView::get().get_visible())
+      AssemblyView::get().hide_view();
+    else if(auto view=dynamic_cast<Source::ClangViewParse*>(Notebook::get().get_current_view()))
+      AssemblyView::get().show_view(view);
+  });
   menu.add_action("source_apply_fix_its", [this]() {
     if(auto view=Notebook::get().get_current_view()) {
       if(view->get_fix_its) {
@@ -863,6 +931,22 @@ void Window::set_menu_actions() {
 
     Project::current->recreate_build();
   });
+  menu.add_action("project_run_benchmarks", [this]() {
+    if(Project::compiling || Project::debugging) {
+      Info::get().print("Compile or debug in progress");
+      return;
+    }
+    
+    Project::current=Project::create();
+    
+    if(Config::get().project.save_on_compile_or_run)
+      Project::save_files(Project::current->build->project_path);
+    
+    Project::current->run_benchmarks();
+  });
+  menu.add_action("project_toggle_benchmark_baseline", [this]() {
+    Project::create()->toggle_benchmark_baseline();
+  });
   
   menu.add_action("run_command", [this]() {
     EntryBox::get().clear();
@@ -952,6 +1036,23 @@ void Window::set_menu_actions() {
     
     Project::current->debug_start();
   });
+  menu.add_action("debug_profile", [this](){
+    if(Project::compiling) {
+      Info::get().print("Compile in progress");
+      return;
+    }
+    else if(Project::debugging) {
+      Info::get().print("Debugging in progress");
+      return;
+    }
+    
+    Project::current=Project::create();
+    
+    if(Config::get().project.save_on_compile_or_run)
+      Project::save_files(Project::current->build->project_path);
+    
+    Project::current->debug_profile();
+  });
   menu.add_action("debug_stop", [this]() {
     if(Project::current)
       Project::current->debug_stop();
@@ -980,6 +1081,23 @@ void Window::set_menu_actions() {
     if(Project::current)
       Project::current->debug_show_variables();
   });
+  menu.add_action("debug_show_memory", [this]() {
+    EntryBox::get().clear();
+    EntryBox::get().entries.emplace_back(last_debug_memory_expression, [this](const std::string& content){
+      if(content!="") {
+        if(Project::current)
+          Project::current->debug_show_memory(content);
+        last_debug_memory_expression=content;
+      }
+      EntryBox::get().hide();
+    }, 30);
+    auto entry_it=EntryBox::get().entries.begin();
+    entry_it->set_placeholder_text("Address or Variable");
+    EntryBox::get().buttons.emplace_back("Show memory", [this, entry_it](){
+      entry_it->activate();
+    });
+    EntryBox::get().show();
+  });
   menu.add_action("debug_run_command", [this]() {
     EntryBox::get().clear();
     EntryBox::get().entries.emplace_back(last_run_debug_command, [this](const std::string& content){
@@ -1046,6 +1164,25 @@ void Window::set_menu_actions() {
   menu.add_action("window_clear_terminal", [this] {
     Terminal::get().clear();
   });
+  menu.add_action("window_toggle_tracing", [this] {
+    if(!Trace::enabled) {
+      Trace::clear();
+      Trace::enabled=true;
+      Info::get().print("Tracing started");
+      return;
+    }
+    Trace::enabled=false;
+    auto trace_path=Config::get().juci_home_path()/"trace.json";
+    if(Trace::write(trace_path)) {
+      Terminal::get().print("Trace written to "+trace_path.string()+" (open in chrome://tracing):\n", true);
+      Terminal::get().print(Trace::get_summary(20));
+    }
+    else
+      Terminal::get().print("Error: could not write "+trace_path.string()+"\n", true);
+  });
+  menu.add_action("window_toggle_performance_hud", [this] {
+    PerformanceHud::get().toggle();
+  });
 }
 
 void Window::activate_menu_items(bool activate) {
@@ -1064,6 +1201,10 @@ void Window::activate_menu_items(bool activate) {
   menu.actions["source_implement_method"]->set_enabled(activate ? static_cast<bool>(notebook.get_current_view()->get_method) : false);
   menu.actions["source_goto_next_diagnostic"]->set_enabled(activate ? static_cast<bool>(notebook.get_current_view()->goto_next_diagnostic) : false);
   menu.actions["source_apply_fix_its"]->set_enabled(activate ? static_cast<bool>(notebook.get_current_view()->get_fix_its) : false);
+  menu.actions["source_toggle_optimization_remarks"]->set_enabled(activate ? static_cast<bool>(notebook.get_current_view()->toggle_optimization_remarks) : false);
+  menu.actions["source_show_record_layout"]->set_enabled(activate ? static_cast<bool>(notebook.get_current_view()->show_record_layout) : false);
+  menu.actions["source_show_record_layouts_report"]->set_enabled(activate ? static_cast<bool>(notebook.get_current_view()->show_record_layouts_report) : false);
+  menu.actions["source_toggle_assembly"]->set_enabled(activate ? dynamic_cast<Source::ClangViewParse*>(notebook.get_current_view())!=nullptr : false);
 #ifdef JUCI_ENABLE_DEBUG
   menu.actions["debug_toggle_breakpoint"]->set_enabled(activate ? static_cast<bool>(notebook.get_current_view()->toggle_breakpoint) : false);
 #endif
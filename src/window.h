@@ -32,6 +32,7 @@ private:
   std::string last_replace;
   std::string last_run_command;
   std::string last_run_debug_command;
+  std::string last_debug_memory_expression;
   bool case_sensitive_search=true;
   bool regex_search=false;
   bool search_entry_shown=false;
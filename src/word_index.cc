@@ -0,0 +1,278 @@
+#include "word_index.h"
+#include "filesystem.h"
+#include "source.h"
+#include <glib.h>
+#include <algorithm>
+
+WordIndex::WordIndex() {
+  thread=std::thread([this] {
+    while(true) {
+      boost::filesystem::path project_path;
+      std::shared_ptr<Git::Repository> repository;
+      bool project_changed;
+      std::set<boost::filesystem::path> files;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition_variable.wait(lock, [this] {
+          return stop || this->project_changed || !pending_files.empty();
+        });
+        if(stop)
+          return;
+        project_path=this->project_path;
+        repository=this->repository;
+        project_changed=this->project_changed;
+        this->project_changed=false;
+        files=std::move(pending_files);
+        pending_files.clear();
+      }
+      
+      if(project_changed) {
+        this->files.clear();
+        words_count.clear();
+        boost::system::error_code ec;
+        boost::filesystem::recursive_directory_iterator end_it;
+        for(boost::filesystem::recursive_directory_iterator it(project_path, ec);!ec && it!=end_it;it.increment(ec)) {
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            if(stop || this->project_changed)
+              break;
+          }
+          boost::system::error_code file_ec;
+          if(boost::filesystem::is_directory(it->path(), file_ec)) {
+            if(skip_directory(it->path(), repository))
+              it.no_push();
+            continue;
+          }
+          auto filename=it->path().filename().string();
+          if(!filename.empty() && filename[0]=='.')
+            continue;
+          if(boost::filesystem::is_regular_file(it->path(), file_ec) && !(repository && repository->is_ignored(it->path())))
+            add_file(it->path(), get_language_id(it->path()));
+        }
+        update_words();
+      }
+      
+      if(!files.empty())
+        update_files(files);
+    }
+  });
+}
+
+WordIndex::~WordIndex() {
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    stop=true;
+  }
+  condition_variable.notify_one();
+  if(thread.joinable())
+    thread.join();
+}
+
+void WordIndex::open(const boost::filesystem::path &project_path) {
+  //The languages are loaded here, in the main thread, since the index thread only reads them
+  Gsv::LanguageManager::get_default()->get_language_ids();
+  std::shared_ptr<Git::Repository> repository;
+  try {
+    repository=Git::get_repository(project_path);
+  }
+  catch(const std::exception &) {}
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    this->project_path=project_path;
+    this->repository=repository;
+    project_changed=true;
+    pending_files.clear();
+  }
+  condition_variable.notify_one();
+}
+
+void WordIndex::update(const boost::filesystem::path &file_path) {
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    if(project_path.empty() || !filesystem::file_in_path(file_path, project_path))
+      return;
+    pending_files.emplace(file_path);
+  }
+  condition_variable.notify_one();
+}
+
+std::vector<std::string> WordIndex::get_words(const std::string &prefix, size_t max_words, const std::string &language_id, const boost::filesystem::path &exclude_file_path) {
+  std::shared_ptr<const std::vector<Word> > words;
+  std::shared_ptr<const FileWords> exclude_words;
+  {
+    std::unique_lock<std::mutex> lock(words_mutex);
+    auto words_it=this->words.find(language_id);
+    if(words_it==this->words.end())
+      return {};
+    words=words_it->second;
+    auto it=words_files.find(exclude_file_path.string());
+    if(it!=words_files.end())
+      exclude_words=it->second.words;
+  }
+  
+  std::vector<const Word*> matches;
+  for(auto it=std::lower_bound(words->begin(), words->end(), Word(prefix, 0));it!=words->end() && it->word.compare(0, prefix.size(), prefix)==0;++it) {
+    if(it->word.size()==prefix.size() || (exclude_words && exclude_words->count(it->word)>0))
+      continue;
+    matches.emplace_back(&*it);
+  }
+  
+  auto matches_end=matches.begin()+std::min(max_words, matches.size());
+  std::partial_sort(matches.begin(), matches_end, matches.end(), [](const Word *lhs, const Word *rhs) {
+    if(lhs->count!=rhs->count)
+      return lhs->count>rhs->count;
+    return lhs->word<rhs->word;
+  });
+  
+  std::vector<std::string> result;
+  for(auto it=matches.begin();it!=matches_end;++it)
+    result.emplace_back((*it)->word);
+  return result;
+}
+
+WordIndex::FileWords WordIndex::get_file_words(const std::string &text) {
+  FileWords file_words;
+  auto is_word_char=[](unsigned char chr) {
+    return (chr>='a' && chr<='z') || (chr>='A' && chr<='Z') || (chr>='0' && chr<='9') || chr=='_' || chr>=128;
+  };
+  size_t start=std::string::npos;
+  for(size_t c=0;c<=text.size();++c) {
+    if(c<text.size() && is_word_char(text[c])) {
+      if(start==std::string::npos)
+        start=c;
+    }
+    else if(start!=std::string::npos) {
+      if(c-start>=minimum_word_size && !(text[start]>='0' && text[start]<='9'))
+        ++file_words[text.substr(start, c-start)];
+      start=std::string::npos;
+    }
+  }
+  return file_words;
+}
+
+std::string WordIndex::get_language_id(const boost::filesystem::path &file_path) {
+  auto language=Source::guess_language(file_path);
+  if(language)
+    return language->get_id();
+  return std::string();
+}
+
+bool WordIndex::skip_directory(const boost::filesystem::path &directory_path, const std::shared_ptr<Git::Repository> &repository) {
+  auto filename=directory_path.filename().string();
+  if(!filename.empty() && filename[0]=='.')
+    return true;
+  boost::system::error_code ec;
+  if(boost::filesystem::exists(directory_path/"CMakeCache.txt", ec))
+    return true;
+  return repository && repository->is_ignored(directory_path);
+}
+
+void WordIndex::add_file(const boost::filesystem::path &file_path, const std::string &language_id) {
+  remove_file(file_path);
+  
+  boost::system::error_code ec;
+  auto file_size=boost::filesystem::file_size(file_path, ec);
+  if(ec || file_size>maximum_file_size)
+    return;
+  auto text=filesystem::read(file_path);
+  if(text.find('\0')!=std::string::npos || !g_utf8_validate(text.data(), text.size(), nullptr))
+    return;
+  
+  auto file_words=std::make_shared<FileWords>(get_file_words(text));
+  auto &language_words_count=words_count[language_id];
+  for(auto &word: *file_words)
+    language_words_count[word.first]+=word.second;
+  files.emplace(file_path.string(), File{language_id, file_words});
+}
+
+void WordIndex::remove_file(const boost::filesystem::path &file_path) {
+  auto it=files.find(file_path.string());
+  if(it==files.end())
+    return;
+  auto &language_words_count=words_count[it->second.language_id];
+  for(auto &word: *it->second.words) {
+    auto count_it=language_words_count.find(word.first);
+    if(count_it!=language_words_count.end()) {
+      if(count_it->second<=word.second)
+        language_words_count.erase(count_it);
+      else
+        count_it->second-=word.second;
+    }
+  }
+  files.erase(it);
+}
+
+void WordIndex::update_files(const std::set<boost::filesystem::path> &file_paths) {
+  //The words of the files before and after the update, per language id
+  std::unordered_map<std::string, std::set<std::string> > changed_words;
+  auto add_changed_words=[this, &changed_words](const boost::filesystem::path &file_path) {
+    auto it=files.find(file_path.string());
+    if(it!=files.end()) {
+      auto &language_changed_words=changed_words[it->second.language_id];
+      for(auto &word: *it->second.words)
+        language_changed_words.emplace(word.first);
+    }
+  };
+  for(auto &file_path: file_paths) {
+    add_changed_words(file_path);
+    boost::system::error_code ec;
+    if(boost::filesystem::is_regular_file(file_path, ec))
+      add_file(file_path, get_language_id(file_path));
+    else
+      remove_file(file_path);
+    add_changed_words(file_path);
+  }
+  
+  //The changed words are merged into the sorted words of their language.
+  //this->words is only changed in this thread, and can therefore be read here without locking words_mutex.
+  std::vector<std::pair<std::string, std::shared_ptr<const std::vector<Word> > > > words;
+  for(auto &language_changed_words: changed_words) {
+    auto &language_words_count=words_count[language_changed_words.first];
+    auto language_words=std::make_shared<std::vector<Word> >();
+    language_words->reserve(language_words_count.size());
+    std::vector<Word>::const_iterator it{}, end{};
+    auto words_it=this->words.find(language_changed_words.first);
+    if(words_it!=this->words.end()) {
+      it=words_it->second->begin();
+      end=words_it->second->end();
+    }
+    for(auto &word: language_changed_words.second) {
+      for(;it!=end && it->word<word;++it)
+        language_words->emplace_back(*it);
+      if(it!=end && it->word==word)
+        ++it;
+      auto count_it=language_words_count.find(word);
+      if(count_it!=language_words_count.end())
+        language_words->emplace_back(word, count_it->second);
+    }
+    language_words->insert(language_words->end(), it, end);
+    words.emplace_back(language_changed_words.first, std::move(language_words));
+  }
+  
+  std::unique_lock<std::mutex> lock(words_mutex);
+  for(auto &language_words: words)
+    this->words[language_words.first]=std::move(language_words.second);
+  for(auto &file_path: file_paths) {
+    auto it=files.find(file_path.string());
+    if(it!=files.end())
+      words_files[file_path.string()]=it->second;
+    else
+      words_files.erase(file_path.string());
+  }
+}
+
+void WordIndex::update_words() {
+  std::unordered_map<std::string, std::shared_ptr<const std::vector<Word> > > words;
+  for(auto &language_words_count: words_count) {
+    auto language_words=std::make_shared<std::vector<Word> >();
+    language_words->reserve(language_words_count.second.size());
+    for(auto &word: language_words_count.second)
+      language_words->emplace_back(word.first, word.second);
+    std::sort(language_words->begin(), language_words->end());
+    words.emplace(language_words_count.first, language_words);
+  }
+  
+  std::unique_lock<std::mutex> lock(words_mutex);
+  this->words=std::move(words);
+  words_files=files;
+}
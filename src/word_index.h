@@ -0,0 +1,81 @@
+#ifndef JUCI_WORD_INDEX_H_
+#define JUCI_WORD_INDEX_H_
+#include <boost/filesystem.hpp>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include "git.h"
+
+///Words of the files in the opened project, per language, maintained in a background thread
+class WordIndex {
+  class Word {
+  public:
+    Word(const std::string &word, size_t count) : word(word), count(count) {}
+    std::string word;
+    size_t count;
+    bool operator<(const Word &rhs) const {return word<rhs.word;}
+  };
+  
+  WordIndex();
+public:
+  static WordIndex &get() {
+    static WordIndex singleton;
+    return singleton;
+  }
+  ~WordIndex();
+  
+  ///Clears the index and indexes the files in project_path, except build directories and files ignored by git
+  void open(const boost::filesystem::path &project_path);
+  ///Reindexes file_path if it is in the opened project
+  void update(const boost::filesystem::path &file_path);
+  
+  ///Returns words starting with prefix in the files of the given language, the most frequent words first.
+  ///Words that are in exclude_file_path are left out, since these are already completed from the buffer.
+  std::vector<std::string> get_words(const std::string &prefix, size_t max_words, const std::string &language_id, const boost::filesystem::path &exclude_file_path=boost::filesystem::path());
+  
+  static const size_t minimum_word_size=3;
+  static const size_t maximum_file_size=1024*1024;
+private:
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable condition_variable;
+  bool stop=false;
+  boost::filesystem::path project_path;
+  std::shared_ptr<Git::Repository> repository;
+  bool project_changed=false;
+  std::set<boost::filesystem::path> pending_files;
+  
+  typedef std::unordered_map<std::string, size_t> FileWords;
+  class File {
+  public:
+    std::string language_id;
+    std::shared_ptr<const FileWords> words;
+  };
+  ///Only used in thread
+  std::unordered_map<std::string, File> files;
+  ///Word counts per language id. Only used in thread.
+  std::unordered_map<std::string, std::unordered_map<std::string, size_t> > words_count;
+  
+  std::mutex words_mutex;
+  ///Words per language id, sorted on word, replaced after each update
+  std::unordered_map<std::string, std::shared_ptr<const std::vector<Word> > > words;
+  std::unordered_map<std::string, File> words_files;
+  
+  static FileWords get_file_words(const std::string &text);
+  static std::string get_language_id(const boost::filesystem::path &file_path);
+  ///Returns true if directory_path is hidden, a build directory or ignored by git
+  static bool skip_directory(const boost::filesystem::path &directory_path, const std::shared_ptr<Git::Repository> &repository);
+  void add_file(const boost::filesystem::path &file_path, const std::string &language_id);
+  void remove_file(const boost::filesystem::path &file_path);
+  ///Reindexes or removes the given files, and merges their changed words into the words of their languages
+  void update_files(const std::set<boost::filesystem::path> &file_paths);
+  ///Recreates the words of every language from words_count
+  void update_words();
+};
+
+#endif // JUCI_WORD_INDEX_H_
@@ -0,0 +1,74 @@
+#include <glib.h>
+#include "benchmark_results.h"
+#include "filesystem.h"
+#include <cmath>
+
+int main() {
+  auto tests_path=boost::filesystem::canonical(JUCI_TESTS_PATH);
+  auto project_path=tests_path/"tmp"/"benchmark_results";
+  auto directory=project_path/"build"/"benchmarks";
+  boost::filesystem::create_directories(directory);
+  g_assert(filesystem::write(project_path/"bench.cpp", "#include <benchmark/benchmark.h>\n\n"
+                                                       "static void BM_sort(benchmark::State &state) {}\n"
+                                                       "BENCHMARK(BM_sort)->Range(8, 1024);\n\n"
+                                                       "template <class T> static void BM_copy(benchmark::State &state) {}\n"
+                                                       "BENCHMARK_TEMPLATE(BM_copy, int);\n"));
+  g_assert(filesystem::write(project_path/"build"/"CMakeCache.txt"));
+  g_assert(filesystem::write(project_path/"build"/"generated.cpp", "BENCHMARK(BM_sort);\n"));
+  
+  BenchmarkResults baseline;
+  g_assert(baseline.add(R"({
+  "context": {"date": "2017-01-01"},
+  "benchmarks": [
+    {"name": "BM_sort/8", "run_name": "BM_sort/8", "run_type": "iteration", "iterations": 10, "real_time": 10.5, "cpu_time": 10.0, "time_unit": "ns"},
+    {"name": "BM_sort/8", "run_name": "BM_sort/8", "run_type": "iteration", "iterations": 10, "real_time": 12.5, "cpu_time": 12.0, "time_unit": "ns"},
+    {"name": "BM_copy<int>_mean", "iterations": 3, "real_time": 2.0, "cpu_time": 2.0, "time_unit": "us"},
+    {"name": "BM_copy<int>_stddev", "iterations": 3, "real_time": 0.01, "cpu_time": 0.01, "time_unit": "us"}
+  ]
+})"));
+  g_assert_cmpuint(baseline.results.size(), ==, 2);
+  g_assert(baseline.results[0].name=="BM_sort/8");
+  g_assert(std::abs(baseline.results[0].time-11.0)<1e-9);
+  g_assert(std::abs(baseline.results[0].stddev-std::sqrt(2.0))<1e-9);
+  g_assert(baseline.results[1].name=="BM_copy<int>");
+  g_assert(std::abs(baseline.results[1].time-2000.0)<1e-9);
+  g_assert(std::abs(baseline.results[1].stddev-10.0)<1e-9);
+  g_assert(!baseline.add("not json"));
+  
+  BenchmarkResults results;
+  results.commit="0123456789abcdef";
+  results.time=1500000000;
+  results.results={{"BM_sort/8", 11.5, 1.0}, {"BM_copy<int>", 2100.0, 10.0}, {"BM_new", 5.0, 0.0}};
+  auto deltas=results.compare(baseline);
+  g_assert_cmpuint(deltas.size(), ==, 3);
+  g_assert(!deltas[0].significant);
+  g_assert(deltas[1].significant);
+  g_assert(std::abs(deltas[1].change-0.05)<1e-9);
+  g_assert(deltas[2].old_time<0.0);
+  
+  g_assert(results.get_file_name()=="1500000000_0123456789ab.json");
+  g_assert(results.save(directory/results.get_file_name()));
+  baseline.time=1400000000;
+  g_assert(baseline.save(directory/baseline.get_file_name()));
+  auto runs=BenchmarkResults::get_runs(directory);
+  g_assert_cmpuint(runs.size(), ==, 2);
+  g_assert(runs[1].filename()=="1500000000_0123456789ab.json");
+  BenchmarkResults loaded;
+  g_assert(loaded.load(runs[1]));
+  g_assert(loaded.commit==results.commit);
+  g_assert(loaded.time==results.time);
+  g_assert_cmpuint(loaded.results.size(), ==, 3);
+  g_assert(loaded.results[1].name=="BM_copy<int>");
+  g_assert(std::abs(loaded.results[1].time-2100.0)<1e-9);
+  
+  g_assert(BenchmarkResults::get_function_name("BM_copy<int>/8")=="BM_copy");
+  auto registrations=BenchmarkResults::find_registrations(project_path, {"BM_sort", "BM_copy", "BM_missing"});
+  g_assert_cmpuint(registrations.size(), ==, 2);
+  g_assert(registrations.at("BM_sort").first==project_path/"bench.cpp");
+  g_assert_cmpint(registrations.at("BM_sort").second, ==, 4);
+  g_assert_cmpint(registrations.at("BM_copy").second, ==, 7);
+  g_assert(BenchmarkResults::format_time(11.0)=="11.0 ns");
+  g_assert(BenchmarkResults::format_time(2100.0)=="2.10 us");
+  
+  boost::filesystem::remove_all(project_path);
+}
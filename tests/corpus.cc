@@ -0,0 +1,315 @@
+#include "corpus.h"
+#include "filesystem.h"
+#include "git.h"
+#include <stdexcept>
+
+Corpus::Corpus(const boost::filesystem::path &path, const Options &options) : path(path), options(options), generator(options.seed) {
+  if(this->options.targets==0)
+    this->options.targets=1;
+  if(this->options.translation_units<this->options.targets)
+    this->options.translation_units=this->options.targets;
+  if(this->options.header_depth==0)
+    this->options.header_depth=1;
+  
+  boost::system::error_code ec;
+  if(boost::filesystem::exists(path, ec))
+    throw std::runtime_error(path.string()+" already exists");
+  boost::filesystem::create_directories(path/"include", ec);
+  if(ec)
+    throw std::runtime_error("could not create "+path.string()+": "+ec.message());
+  
+  std::string cmake="cmake_minimum_required(VERSION 2.8.12)\n\nproject(corpus)\n\n"
+                    "set(CMAKE_CXX_FLAGS \"${CMAKE_CXX_FLAGS} -std=c++1y -Wall\")\n\n"
+                    "include_directories(include)\n\n";
+  for(size_t target=0;target<this->options.targets;++target)
+    cmake+="add_subdirectory(target_"+std::to_string(target)+")\n";
+  write(path/"CMakeLists.txt", cmake);
+  write(path/".gitignore", "build/\n");
+  
+  for(size_t level=0;level<this->options.header_depth;++level) {
+    headers.emplace_back(path/"include"/("level_"+std::to_string(level)+".h"));
+    write(headers.back(), get_header(level));
+  }
+  
+  for(size_t unit=0;unit<this->options.translation_units;++unit) {
+    translation_units.emplace_back(path/("target_"+std::to_string(unit%this->options.targets))/("unit_"+std::to_string(unit)+".cpp"));
+    boost::filesystem::create_directories(translation_units.back().parent_path(), ec);
+    write(translation_units.back(), get_translation_unit(unit, 0));
+  }
+  
+  if(this->options.large_file_lines>0) {
+    large_file=path/"target_0"/"large.cpp";
+    write(large_file, get_large_file());
+  }
+  
+  for(size_t file=0;file<this->options.diagnostics_files;++file) {
+    diagnostics_files.emplace_back(path/("target_"+std::to_string(file%this->options.targets))/("diagnostics_"+std::to_string(file)+".cpp"));
+    write(diagnostics_files.back(), get_diagnostics_file(file));
+  }
+  
+  for(size_t target=0;target<this->options.targets;++target) {
+    auto target_name="target_"+std::to_string(target);
+    std::string sources;
+    std::string declarations;
+    std::string calls;
+    for(size_t unit=target;unit<this->options.translation_units;unit+=this->options.targets) {
+      sources+=" unit_"+std::to_string(unit)+".cpp";
+      declarations+="int unit_"+std::to_string(unit)+"_entry(int value);\n";
+      calls+="  sum+=unit_"+std::to_string(unit)+"_entry(argc);\n";
+    }
+    if(target==0 && !large_file.empty())
+      sources+=" large.cpp";
+    write(path/target_name/"main.cpp", "#include <iostream>\n\n"+declarations+"\nint main(int argc, char *argv[]) {\n  int sum=0;\n"+calls+"  std::cout << sum << std::endl;\n}\n");
+    
+    cmake="add_executable("+target_name+" main.cpp"+sources+")\n";
+    std::string diagnostics_sources;
+    for(size_t file=target;file<this->options.diagnostics_files;file+=this->options.targets)
+      diagnostics_sources+=" diagnostics_"+std::to_string(file)+".cpp";
+    if(!diagnostics_sources.empty()) {
+      //The diagnostics files do not compile, but are in compile_commands.json
+      cmake+="\nadd_library("+target_name+"_diagnostics STATIC EXCLUDE_FROM_ALL"+diagnostics_sources+")\n"
+             "target_compile_options("+target_name+"_diagnostics PRIVATE -Wextra -Wconversion)\n";
+    }
+    write(path/target_name/"CMakeLists.txt", cmake);
+  }
+  
+  if(this->options.commits>0)
+    create_git_history();
+}
+
+boost::filesystem::path Corpus::get_temp_path() {
+  return boost::filesystem::temp_directory_path()/boost::filesystem::unique_path("juci_corpus_%%%%-%%%%-%%%%");
+}
+
+void Corpus::remove() {
+  boost::system::error_code ec;
+  boost::filesystem::remove_all(path, ec);
+}
+
+void Corpus::write(const boost::filesystem::path &path, const std::string &content) {
+  if(!filesystem::write(path, content))
+    throw std::runtime_error("could not write "+path.string());
+}
+
+std::string Corpus::get_header(size_t level) {
+  auto name="Level_"+std::to_string(level);
+  auto suffix="_"+std::to_string(level);
+  bool deepest=level+1==options.header_depth;
+  auto base="Level_"+std::to_string(level+1)+"<T, N+1>";
+  
+  std::string content="#pragma once\n";
+  if(deepest)
+    content+="#include <algorithm>\n#include <map>\n#include <memory>\n#include <string>\n#include <utility>\n#include <vector>\n";
+  else
+    content+="#include \"level_"+std::to_string(level+1)+".h\"\n";
+  content+="\nnamespace corpus {\n"
+           "  ///Level "+std::to_string(level)+" of the header hierarchy, where every level adds members to the level below\n"
+           "  template <typename T, int N>\n";
+  if(deepest) {
+    content+="  class "+name+" {\n"
+             "  public:\n"
+             "    using value_type=T;\n";
+  }
+  else {
+    content+="  class "+name+" : public "+base+" {\n"
+             "  public:\n"
+             "    using value_type=typename "+base+"::value_type;\n";
+  }
+  content+="    static constexpr int level="+std::to_string(level)+";\n"
+           "    std::vector<T> values"+suffix+";\n"
+           "    std::map<std::string, std::unique_ptr<T>> named_values"+suffix+";\n"
+           "    \n"
+           "    template <typename... Args>\n"
+           "    void emplace"+suffix+"(Args &&... args) {\n"
+           "      values"+suffix+".emplace_back(std::forward<Args>(args)...);\n"
+           "    }\n"
+           "    \n"
+           "    template <typename F>\n"
+           "    auto transform"+suffix+"(F function) const -> std::vector<decltype(function(std::declval<T>()))> {\n"
+           "      std::vector<decltype(function(std::declval<T>()))> result;\n"
+           "      for(auto &value: values"+suffix+")\n"
+           "        result.emplace_back(function(value));\n"
+           "      return result;\n"
+           "    }\n"
+           "    \n"
+           "    T sum"+suffix+"() const {\n"
+           "      T sum=T();\n"
+           "      for(auto &value: values"+suffix+")\n"
+           "        sum+=value;\n"
+           "      return sum;\n"
+           "    }\n"
+           "  };\n"
+           "  \n"
+           "  template <int N>\n"
+           "  class Factorial"+suffix+" {\n"
+           "  public:\n"
+           "    static constexpr long value=N*Factorial"+suffix+"<N-1>::value;\n"
+           "  };\n"
+           "  template <>\n"
+           "  class Factorial"+suffix+"<0> {\n"
+           "  public:\n"
+           "    static constexpr long value=1;\n"
+           "  };\n"
+           "}\n";
+  return content;
+}
+
+std::string Corpus::get_translation_unit(size_t unit, size_t revision) {
+  static const std::vector<std::string> sentences={
+    "Returns the sum of the values after they have been transformed",
+    "The values are stored in every level of the hierarchy",
+    "This function is called from the main function of the target",
+    "Computes a number that depends on the revision of this file",
+    "Adds the given value to the values of the first level"
+  };
+  
+  auto unit_string=std::to_string(unit);
+  auto functions=5+unit%10;
+  std::string content="#include \"../include/level_0.h\"\n\n"
+                      "//Unit "+unit_string+" of target "+std::to_string(unit%options.targets)+", revision "+std::to_string(revision)+"\n\n"
+                      "namespace unit_"+unit_string+" {\n";
+  for(size_t function=0;function<functions;++function) {
+    auto function_string=std::to_string(function);
+    content+="  ///"+sentences[(unit+function)%sentences.size()]+"\n"
+             "  int function_"+function_string+"(int value) {\n"
+             "    corpus::Level_0<double, "+std::to_string(function%8)+"> level;\n"
+             "    level.emplace_0(value*1.5);\n"
+             "    level.emplace_0(value+"+std::to_string(revision)+".0);\n"
+             "    auto result=level.transform_0([](double x) {\n"
+             "      return static_cast<int>(x)+"+function_string+";\n"
+             "    });\n"
+             "    int sum=corpus::Factorial_0<"+std::to_string(function%10)+">::value;\n"
+             "    for(auto &x: result)\n"
+             "      sum+=x;\n"
+             "    return sum+static_cast<int>(level.sum_0());\n"
+             "  }\n"
+             "  \n";
+  }
+  content+="}\n\n"
+           "int unit_"+unit_string+"_entry(int value) {\n"
+           "  int sum=0;\n";
+  for(size_t function=0;function<functions;++function)
+    content+="  sum+=unit_"+unit_string+"::function_"+std::to_string(function)+"(value);\n";
+  content+="  return sum;\n"
+           "}\n";
+  return content;
+}
+
+std::string Corpus::get_large_file() {
+  std::string content="#include \"../include/level_0.h\"\n\n"
+                      "//A large file with many small functions\n\n"
+                      "namespace large {\n";
+  size_t lines=5;
+  for(size_t function=0;lines<options.large_file_lines;++function) {
+    auto function_string=std::to_string(function);
+    content+="  ///Function number "+function_string+" of the large file\n"
+             "  int function_"+function_string+"(const std::vector<int> &values) {\n"
+             "    int sum=0;\n"
+             "    for(auto &value: values) {\n"
+             "      if(value%"+std::to_string(function%7+2)+"==0)\n"
+             "        sum+=value;\n"
+             "    }\n"
+             "    return sum;\n"
+             "  }\n"
+             "  \n";
+    lines+=10;
+  }
+  content+="}\n";
+  return content;
+}
+
+std::string Corpus::get_diagnostics_file(size_t file) {
+  std::string content="#include \"../include/level_0.h\"\n\n"
+                      "//Every statement below gives a warning, and some give errors\n\n"
+                      "int diagnostics_"+std::to_string(file)+"(const std::vector<int> &values) {\n"
+                      "  int count=0;\n";
+  //libclang stops reporting errors after 20, so most diagnostics are warnings
+  size_t errors=0;
+  for(size_t c=0;c<options.diagnostics_per_file;++c) {
+    auto c_string=std::to_string(c);
+    switch(generator()%4) {
+    case 0:
+      content+="  int unused_"+c_string+"=count;\n";
+      break;
+    case 1:
+      content+="  int signed_"+c_string+"="+c_string+";\n"
+               "  if(values.size()<signed_"+c_string+")\n"
+               "    ++count;\n";
+      break;
+    case 2:
+      content+="  short narrowed_"+c_string+"=values.size();\n"
+               "  count+=narrowed_"+c_string+";\n";
+      break;
+    default:
+      if(errors<15) {
+        content+="  count+=undeclared_"+c_string+";\n";
+        ++errors;
+      }
+      else
+        content+="  double unused_"+c_string+"=count;\n";
+    }
+  }
+  content+="  return count;\n"
+           "}\n";
+  return content;
+}
+
+void Corpus::create_git_history() {
+  Git::initialize();
+  std::lock_guard<std::mutex> lock(Git::mutex);
+  const auto check=[](int code, const std::string &action) {
+    Git::Error error;
+    error.code=code;
+    if(error)
+      throw std::runtime_error("could not "+action+": "+error.message());
+  };
+  
+  git_repository *repository_pointer;
+  check(git_repository_init(&repository_pointer, path.string().c_str(), 0), "create git repository in "+path.string());
+  std::unique_ptr<git_repository, void(*)(git_repository *)> repository(repository_pointer, git_repository_free);
+  
+  for(size_t commit=0;commit<options.commits;++commit) {
+    if(commit>0) {
+      auto changes=1+generator()%3;
+      for(size_t c=0;c<changes;++c) {
+        auto unit=generator()%translation_units.size();
+        write(translation_units[unit], get_translation_unit(unit, commit));
+      }
+    }
+    
+    git_index *index_pointer;
+    check(git_repository_index(&index_pointer, repository.get()), "open git index");
+    std::unique_ptr<git_index, void(*)(git_index *)> index(index_pointer, git_index_free);
+    check(git_index_add_all(index.get(), nullptr, 0, nullptr, nullptr), "add files to git index");
+    check(git_index_write(index.get()), "write git index");
+    git_oid tree_id;
+    check(git_index_write_tree(&tree_id, index.get()), "write git tree");
+    git_tree *tree_pointer;
+    check(git_tree_lookup(&tree_pointer, repository.get(), &tree_id), "find git tree");
+    std::unique_ptr<git_tree, void(*)(git_tree *)> tree(tree_pointer, git_tree_free);
+    
+    //Fixed commit times keep the commit ids the same between runs
+    git_signature *signature_pointer;
+    check(git_signature_new(&signature_pointer, "Corpus", "corpus@localhost", 1500000000+commit*3600, 0), "create git signature");
+    std::unique_ptr<git_signature, void(*)(git_signature *)> signature(signature_pointer, git_signature_free);
+    
+    auto message="Commit "+std::to_string(commit)+"\n";
+    git_oid commit_id;
+    if(commit==0)
+      check(git_commit_create_v(&commit_id, repository.get(), "HEAD", signature.get(), signature.get(), nullptr, message.c_str(), tree.get(), 0), "create git commit");
+    else {
+      git_oid parent_id;
+      check(git_reference_name_to_id(&parent_id, repository.get(), "HEAD"), "find git HEAD");
+      git_commit *parent_pointer;
+      check(git_commit_lookup(&parent_pointer, repository.get(), &parent_id), "find git commit");
+      std::unique_ptr<git_commit, void(*)(git_commit *)> parent(parent_pointer, git_commit_free);
+      check(git_commit_create_v(&commit_id, repository.get(), "HEAD", signature.get(), signature.get(), nullptr, message.c_str(), tree.get(), 1, parent.get()), "create git commit");
+    }
+  }
+  
+  //Uncommitted changes, as seen in the git diff of an open file
+  for(size_t c=0;c<options.modified_files;++c) {
+    auto unit=generator()%translation_units.size();
+    write(translation_units[unit], get_translation_unit(unit, options.commits));
+  }
+}
@@ -0,0 +1,58 @@
+#ifndef JUCI_CORPUS_H_
+#define JUCI_CORPUS_H_
+#include <boost/filesystem.hpp>
+#include <string>
+#include <vector>
+#include <random>
+
+///A generated CMake project with a git history, used as input to the benchmarks and the latency harness.
+///The same options and seed always give the same files.
+class Corpus {
+public:
+  class Options {
+  public:
+    size_t targets=4;
+    ///Translation units in total, spread over the targets
+    size_t translation_units=40;
+    ///Number of headers in the include chain of every translation unit
+    size_t header_depth=10;
+    size_t commits=20;
+    size_t diagnostics_files=2;
+    ///Warnings and errors in each of the diagnostics files
+    size_t diagnostics_per_file=200;
+    ///Lines of the large translation unit in the first target
+    size_t large_file_lines=20000;
+    ///Translation units that are changed after the last commit
+    size_t modified_files=4;
+    unsigned seed=0;
+  };
+  
+  ///Creates the project in path, which should not exist. Throws std::runtime_error on failure.
+  Corpus(const boost::filesystem::path &path, const Options &options);
+  
+  boost::filesystem::path path;
+  std::vector<boost::filesystem::path> translation_units;
+  std::vector<boost::filesystem::path> headers;
+  ///Files that are not part of the default build, with compile commands that enable all warnings
+  std::vector<boost::filesystem::path> diagnostics_files;
+  boost::filesystem::path large_file;
+  
+  ///Returns a new directory name in the system temporary directory
+  static boost::filesystem::path get_temp_path();
+  void remove();
+
+private:
+  Options options;
+  std::mt19937 generator;
+  
+  void write(const boost::filesystem::path &path, const std::string &content);
+  
+  std::string get_header(size_t level);
+  ///The revision changes the content of the translation unit in each commit that changes it
+  std::string get_translation_unit(size_t unit, size_t revision);
+  std::string get_large_file();
+  std::string get_diagnostics_file(size_t file);
+  void create_git_history();
+};
+
+#endif // JUCI_CORPUS_H_
@@ -0,0 +1,54 @@
+#include <glib.h>
+#include "corpus.h"
+#include "filesystem.h"
+#include "git.h"
+#include <gtkmm.h>
+
+int main() {
+  auto app=Gtk::Application::create();
+  
+  auto tests_path=boost::filesystem::canonical(JUCI_TESTS_PATH);
+  boost::filesystem::remove_all(tests_path/"tmp"/"corpus_1");
+  boost::filesystem::remove_all(tests_path/"tmp"/"corpus_2");
+  
+  Corpus::Options options;
+  options.targets=2;
+  options.translation_units=5;
+  options.header_depth=3;
+  options.commits=4;
+  options.diagnostics_files=1;
+  options.diagnostics_per_file=10;
+  options.large_file_lines=100;
+  options.modified_files=1;
+  
+  Corpus corpus(tests_path/"tmp"/"corpus_1", options);
+  g_assert_cmpuint(corpus.translation_units.size(), ==, 5);
+  g_assert_cmpuint(corpus.headers.size(), ==, 3);
+  g_assert_cmpuint(corpus.diagnostics_files.size(), ==, 1);
+  for(auto &path: corpus.translation_units)
+    g_assert(boost::filesystem::exists(path));
+  g_assert(filesystem::read(corpus.headers[0]).find("#include \"level_1.h\"")!=std::string::npos);
+  g_assert(filesystem::read(corpus.path/"target_1"/"CMakeLists.txt").find("unit_3.cpp")!=std::string::npos);
+  g_assert_cmpuint(filesystem::read_lines(corpus.large_file).size(), >=, 100);
+  
+  {
+    auto repository=Git::get_repository(corpus.path);
+    g_assert_cmpuint(repository->get_head_commit().size(), ==, 40);
+    g_assert_cmpuint(repository->get_status().modified.size(), >, 0);
+    
+    //The same options give the same commits
+    Corpus same_corpus(tests_path/"tmp"/"corpus_2", options);
+    g_assert(Git::get_repository(same_corpus.path)->get_head_commit()==repository->get_head_commit());
+    same_corpus.remove();
+    g_assert(!boost::filesystem::exists(same_corpus.path));
+  }
+  
+  try {
+    Corpus existing_corpus(corpus.path, options);
+    g_assert(false);
+  }
+  catch(const std::runtime_error &) {}
+  
+  corpus.remove();
+  g_assert(!boost::filesystem::exists(corpus.path));
+}
@@ -15,6 +15,7 @@ int main() {
     
     g_assert(repository->get_path()==git_path);
     g_assert(repository->get_work_path()==jucipp_path);
+    g_assert_cmpuint(repository->get_head_commit().size(), ==, 40);
     
     auto status=repository->get_status();
     
@@ -23,6 +24,19 @@ int main() {
     g_assert_cmpuint(lines.added.size(), ==, 1);
     g_assert_cmpuint(lines.modified.size(), ==, 1);
     g_assert_cmpuint(lines.removed.size(), ==, 1);
+    
+    auto hunks=diff.get_hunks("#include added\n#include <glib.h>\n#include modified\n#include \"git.h\"\n");
+    std::string buffer("#include added\n#include <glib.h>\n#include <gtkmm.h>\n#include \"git.h\"\n");
+    auto edited_hunks=diff.get_hunks(buffer, hunks, 2, 3, 3);
+    auto expected_hunks=diff.get_hunks(buffer);
+    g_assert_cmpuint(edited_hunks.size(), ==, 2);
+    g_assert_cmpuint(edited_hunks.size(), ==, expected_hunks.size());
+    for(size_t c=0;c<edited_hunks.size();++c) {
+      g_assert_cmpint(edited_hunks[c].old_start, ==, expected_hunks[c].old_start);
+      g_assert_cmpint(edited_hunks[c].old_lines, ==, expected_hunks[c].old_lines);
+      g_assert_cmpint(edited_hunks[c].new_start, ==, expected_hunks[c].new_start);
+      g_assert_cmpint(edited_hunks[c].new_lines, ==, expected_hunks[c].new_lines);
+    }
   }
   catch(const std::exception &e) {
     std::cerr << e.what() << std::endl;
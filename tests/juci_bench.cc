@@ -0,0 +1,272 @@
+#include <glib.h>
+#include "source_clang.h"
+#include "config.h"
+#include "filesystem.h"
+#include "ctags.h"
+#include "cmake.h"
+#include "git.h"
+#include "benchmark_results.h"
+#include "corpus.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+//Benchmarks of the components of juCi++ itself. The results are written in the JSON format of Google Benchmark,
+//to the file given as argument or else to stdout, so that runs can be compared with BenchmarkResults across releases.
+//The times are wall clock times, since most of these are latencies seen by the user.
+
+//Requires display server to work
+//However, it is possible to use the Broadway backend if the benchmarks are run in a pure terminal environment:
+//broadwayd&
+//./juci_bench results.json
+
+class Benchmarks {
+public:
+  class Result {
+  public:
+    std::string name;
+    size_t repetitions;
+    double mean, median, stddev, min, max;
+  };
+  
+  std::vector<Result> results;
+  
+  void run(const std::string &name, size_t repetitions, const std::function<void()> &function) {
+    std::vector<double> times;
+    for(size_t c=0;c<repetitions;++c) {
+      auto start=std::chrono::steady_clock::now();
+      function();
+      times.emplace_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now()-start).count());
+    }
+    add(name, std::move(times));
+  }
+  
+  ///Adds times in nanoseconds that were measured by the caller
+  void add(const std::string &name, std::vector<double> times) {
+    if(times.empty())
+      return;
+    std::sort(times.begin(), times.end());
+    Result result;
+    result.name=name;
+    result.repetitions=times.size();
+    result.mean=0.0;
+    for(auto &time: times)
+      result.mean+=time;
+    result.mean/=times.size();
+    result.median=times.size()%2==1?times[times.size()/2]:(times[times.size()/2-1]+times[times.size()/2])/2.0;
+    result.stddev=0.0;
+    if(times.size()>1) {
+      for(auto &time: times)
+        result.stddev+=(time-result.mean)*(time-result.mean);
+      result.stddev=std::sqrt(result.stddev/(times.size()-1));
+    }
+    result.min=times.front();
+    result.max=times.back();
+    std::cerr << std::left << std::setw(40) << name << std::right << std::setw(12) << BenchmarkResults::format_time(result.mean)
+              << std::setw(12) << BenchmarkResults::format_time(result.median) << std::setw(12) << BenchmarkResults::format_time(result.max) << std::endl;
+    results.emplace_back(std::move(result));
+  }
+  
+  std::string get_json(const std::string &commit) const {
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(0);
+    ss << "{\n  \"context\": {\n    \"executable\": \"juci_bench\",\n    \"commit\": \"" << commit << "\",\n    \"date\": " << std::time(nullptr) << "\n  },\n  \"benchmarks\": [";
+    bool first=true;
+    for(auto &result: results) {
+      for(auto &aggregate: std::vector<std::pair<std::string, double> >{{"mean", result.mean}, {"median", result.median}, {"stddev", result.stddev}, {"min", result.min}, {"max", result.max}}) {
+        ss << (first?"\n":",\n") << "    {\"name\": \"" << result.name << '_' << aggregate.first << "\", \"run_name\": \"" << result.name
+           << "\", \"run_type\": \"aggregate\", \"aggregate_name\": \"" << aggregate.first << "\", \"repetitions\": " << result.repetitions
+           << ", \"iterations\": " << result.repetitions << ", \"real_time\": " << aggregate.second << ", \"cpu_time\": " << aggregate.second
+           << ", \"time_unit\": \"ns\"}";
+        first=false;
+      }
+    }
+    ss << "\n  ]\n}\n";
+    return ss.str();
+  }
+};
+
+void flush_events() {
+  while(Gtk::Main::events_pending())
+    Gtk::Main::iteration(false);
+}
+
+int main(int argc, char *argv[]) {
+  auto app=Gtk::Application::create();
+  Gsv::init();
+  
+  auto tests_path=boost::filesystem::canonical(JUCI_TESTS_PATH);
+  auto bench_path=tests_path/"tmp"/"juci_bench";
+  boost::filesystem::remove_all(bench_path);
+  boost::filesystem::create_directories(bench_path);
+  
+  Config::get().project.default_build_path="./build";
+  Config::get().source.spellcheck_language="en";
+  
+  Benchmarks benchmarks;
+  
+  //Buffers with the size of a large source file
+  auto source_content=filesystem::read(tests_path.parent_path()/"src"/"source.cc");
+  g_assert(!source_content.empty());
+  std::string large_content;
+  for(size_t c=0;c<10;++c)
+    large_content+=source_content;
+  
+  {
+    std::string content;
+    while(content.size()<10*1024*1024)
+      content+=large_content;
+    auto file_path=bench_path/"large_file";
+    benchmarks.run("filesystem_write_10MB", 10, [&] {
+      g_assert(filesystem::write(file_path, content));
+    });
+    benchmarks.run("filesystem_read_10MB", 10, [&] {
+      g_assert_cmpuint(filesystem::read(file_path).size(), ==, content.size());
+    });
+  }
+  
+  {
+    std::string tags;
+    for(size_t file=0;file<1000;++file) {
+      auto file_name="src/file_"+std::to_string(file)+".cpp";
+      auto class_name="Class_"+std::to_string(file);
+      for(size_t method=0;method<100;++method) {
+        auto method_name="method_"+std::to_string(method);
+        tags+=method_name+'\t'+file_name+"\t/^  void "+method_name+"(int value, const std::string &text) {$/;\"\tline:"+std::to_string(method*10+1)+"\tclass:"+class_name+'\n';
+      }
+    }
+    benchmarks.run("Ctags_get_locations_100000_tags", 5, [&] {
+      std::stringstream stream(tags);
+      auto locations=Ctags::get_locations(bench_path, stream, "Class_500::method_50", "void (int, const std::string &)");
+      g_assert_cmpuint(locations.size(), ==, 1);
+    });
+  }
+  
+  {
+    auto path=bench_path/"cmake";
+    boost::filesystem::create_directories(path);
+    for(size_t depth=0;depth<50;++depth) {
+      std::string content;
+      if(depth==0)
+        content+="cmake_minimum_required(VERSION 2.8)\n\nproject(juci_bench)\n\n";
+      for(size_t c=0;c<20;++c)
+        content+="# Comment about the variables of level "+std::to_string(depth)+"\nset(variable_"+std::to_string(depth)+'_'+std::to_string(c)+" \"${CMAKE_PROJECT_NAME}\"\n    value_"+std::to_string(c)+")\n";
+      content+="add_subdirectory(level_"+std::to_string(depth+1)+")\n";
+      content+="add_executable(target_"+std::to_string(depth)+" main.cpp\n               ${variable_"+std::to_string(depth)+"_0})\n";
+      filesystem::write(path/"CMakeLists.txt", content);
+      path/="level_"+std::to_string(depth+1);
+      boost::filesystem::create_directories(path);
+    }
+    benchmarks.run("CMake_get_functions_parameters_50_levels", 10, [&] {
+      CMake cmake(path);
+      g_assert_cmpuint(cmake.get_functions_parameters("add_executable").size(), ==, 50);
+    });
+  }
+  
+  std::string commit;
+  try {
+    auto repository=Git::get_repository(tests_path);
+    commit=repository->get_head_commit();
+    auto diff=repository->get_diff(boost::filesystem::path("src")/"source.cc");
+    auto buffer=large_content;
+    for(size_t pos=0;(pos=buffer.find("\n\n", pos))!=std::string::npos;pos+=100)
+      buffer.replace(pos, 2, "\n  //Modified\n");
+    benchmarks.run("Git_Diff_get_lines_large_buffer", 10, [&] {
+      diff.get_lines(buffer);
+    });
+  }
+  catch(const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+  }
+  
+  {
+    Source::View source_view(bench_path/"large_file.cpp", Gsv::LanguageManager::get_default()->get_language("cpp"));
+    source_view.get_buffer()->set_text(large_content);
+    flush_events();
+    benchmarks.run("find_tab_char_and_size_large_buffer", 10, [&] {
+      g_assert(source_view.find_tab_char_and_size().first==' ');
+    });
+    
+    if(source_view.spellcheck_checker) {
+      source_view.get_source_buffer()->ensure_highlight(source_view.get_buffer()->begin(), source_view.get_buffer()->end());
+      benchmarks.run("SpellCheckView_spellcheck_large_buffer", 5, [&] {
+        source_view.spellcheck();
+      });
+    }
+    else
+      std::cerr << "Skipping spellcheck benchmark: no aspell dictionary for " << Config::get().source.spellcheck_language << std::endl;
+  }
+  
+  const auto benchmark_clang_view=[&benchmarks](const std::string &name, const boost::filesystem::path &file_path) {
+    Source::ClangView *clang_view=nullptr;
+    std::vector<double> parse_times;
+    for(size_t c=0;c<5;++c) {
+      if(clang_view) {
+        clang_view->async_delete();
+        clang_view->delete_thread.join();
+        flush_events();
+      }
+      auto start=std::chrono::steady_clock::now();
+      clang_view=new Source::ClangView(file_path, Gsv::LanguageManager::get_default()->get_language("cpp"));
+      while(!clang_view->parsed)
+        flush_events();
+      parse_times.emplace_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now()-start).count());
+    }
+    benchmarks.add("ClangViewParse_parse/"+name, std::move(parse_times));
+    
+    //The reparse is started directly instead of after the delay following a buffer change
+    benchmarks.run("ClangViewParse_reparse/"+name, 10, [&] {
+      clang_view->get_buffer()->insert(clang_view->get_buffer()->end(), "//\n");
+      clang_view->delayed_reparse_connection.disconnect();
+      clang_view->parsed=false;
+      clang_view->parse_process_state=Source::ClangViewParse::ParseProcessState::STARTING;
+      while(!clang_view->parsed)
+        flush_events();
+    });
+    
+    benchmarks.run("ClangViewParse_update_syntax/"+name, 20, [&] {
+      clang_view->update_syntax();
+    });
+    
+    clang_view->async_delete();
+    clang_view->delete_thread.join();
+    flush_events();
+  };
+  benchmark_clang_view("test_file", tests_path/"source_clang_test_files"/"main.cpp");
+  
+  //A unit with a deep template header hierarchy, and a large file, from a generated project
+  try {
+    Corpus::Options options;
+    options.diagnostics_files=0;
+    Corpus corpus(bench_path/"corpus", options);
+    benchmark_clang_view("corpus_unit", corpus.translation_units[0]);
+    benchmark_clang_view("corpus_large_file", corpus.large_file);
+    
+    auto repository=Git::get_repository(corpus.path);
+    benchmarks.run("Git_Repository_get_status_corpus", 10, [&] {
+      repository->clear_saved_status();
+      repository->get_status();
+    });
+  }
+  catch(const std::exception &e) {
+    std::cerr << e.what() << std::endl;
+  }
+  
+  boost::filesystem::remove_all(bench_path);
+  
+  auto json=benchmarks.get_json(commit);
+  if(argc>1) {
+    if(!filesystem::write(argv[1], json)) {
+      std::cerr << "Error: could not write " << argv[1] << std::endl;
+      return 1;
+    }
+  }
+  else
+    std::cout << json;
+  
+  return 0;
+}
@@ -0,0 +1,56 @@
+#include "corpus.h"
+#include <iostream>
+#include <map>
+
+//Creates a synthetic CMake project with a git history for performance tests, for instance:
+//./juci_corpus --translation-units 1000 --commits 500 /tmp/corpus
+
+int main(int argc, char *argv[]) {
+  Corpus::Options options;
+  std::map<std::string, size_t*> arguments={
+    {"--targets", &options.targets},
+    {"--translation-units", &options.translation_units},
+    {"--header-depth", &options.header_depth},
+    {"--commits", &options.commits},
+    {"--diagnostics-files", &options.diagnostics_files},
+    {"--diagnostics-per-file", &options.diagnostics_per_file},
+    {"--large-file-lines", &options.large_file_lines},
+    {"--modified-files", &options.modified_files}
+  };
+  size_t seed=options.seed;
+  arguments.emplace("--seed", &seed);
+  
+  boost::filesystem::path path;
+  for(int c=1;c<argc;++c) {
+    std::string argument=argv[c];
+    auto it=arguments.find(argument);
+    if(it!=arguments.end() && c+1<argc) {
+      try {
+        *it->second=std::stoul(argv[++c]);
+        continue;
+      }
+      catch(const std::exception &) {}
+    }
+    if(argument.empty() || argument[0]=='-' || !path.empty()) {
+      std::cerr << "Usage: " << argv[0];
+      for(auto &argument: arguments)
+        std::cerr << " [" << argument.first << " N]";
+      std::cerr << " [path]" << std::endl;
+      return 1;
+    }
+    path=argument;
+  }
+  options.seed=seed;
+  if(path.empty())
+    path=Corpus::get_temp_path();
+  
+  try {
+    Corpus corpus(path, options);
+    std::cout << corpus.path.string() << std::endl;
+  }
+  catch(const std::exception &e) {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,369 @@
+#include "source_clang.h"
+#include "config.h"
+#include "filesystem.h"
+#include "dispatcher.h"
+#include "corpus.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+//Measures the time from a key press to the next paint of the frame clock, in a Source::ClangView in a window.
+//Without arguments, typing is replayed in four scenarios on a generated project: plain typing, typing during reparse,
+//typing with the completion popup and typing in a large file.
+//Keystrokes can also be recorded and replayed. The replay starts with the cursor at the start of the file,
+//so the cursor should be moved with the keyboard when recording:
+//./juci_latency --record keys.txt file.cpp
+//./juci_latency --replay keys.txt file.cpp
+
+//Requires display server to work
+//However, it is possible to use the Broadway backend if the harness is run in a pure terminal environment:
+//broadwayd&
+//GDK_BACKEND=broadway ./juci_latency
+
+class Keystroke {
+public:
+  guint keyval;
+  guint state;
+  ///Milliseconds since the previous keystroke
+  int delay;
+};
+
+class Scenario {
+public:
+  std::string name;
+  ///Milliseconds from key press to the next paint
+  std::vector<double> latencies;
+  ///Milliseconds from a key press that starts completion to the completion popup is shown
+  std::vector<double> completion_latencies;
+  size_t missed_paints=0;
+  ///Time the main loop dispatched events, compared to the duration of the scenario
+  double busy_fraction=0.0;
+  size_t max_pending=0;
+  double mean_pending=0.0;
+};
+
+///Returns the keystrokes needed to type text, with delay milliseconds between each keystroke
+std::vector<Keystroke> get_keystrokes(const std::string &text, int delay) {
+  std::vector<Keystroke> keystrokes;
+  for(auto chr: Glib::ustring(text)) {
+    guint keyval;
+    if(chr=='\n')
+      keyval=GDK_KEY_Return;
+    else if(chr=='\t')
+      keyval=GDK_KEY_Tab;
+    else if(chr=='\x1b')
+      keyval=GDK_KEY_Escape;
+    else
+      keyval=gdk_unicode_to_keyval(chr);
+    keystrokes.emplace_back(Keystroke{keyval, 0, delay});
+  }
+  return keystrokes;
+}
+
+///Each line of a recording is: delay keyval_name state
+std::vector<Keystroke> read_keystrokes(const boost::filesystem::path &path) {
+  std::vector<Keystroke> keystrokes;
+  for(auto &line: filesystem::read_lines(path)) {
+    std::stringstream ss(line);
+    Keystroke keystroke;
+    std::string name;
+    if(!(ss >> keystroke.delay >> name >> keystroke.state))
+      continue;
+    keystroke.keyval=gdk_keyval_from_name(name.c_str());
+    if(keystroke.keyval!=GDK_KEY_VoidSymbol)
+      keystrokes.emplace_back(keystroke);
+  }
+  return keystrokes;
+}
+
+double get_percentile(std::vector<double> values, double percentile) {
+  if(values.empty())
+    return 0.0;
+  std::sort(values.begin(), values.end());
+  auto rank=static_cast<size_t>(std::ceil(percentile*values.size()));
+  return values[std::max<size_t>(rank, 1)-1];
+}
+
+GdkEvent *create_key_event(GdkEventType type, Gtk::TextView &text_view, const Keystroke &keystroke) {
+  auto event=gdk_event_new(type);
+  auto window=text_view.get_window(Gtk::TEXT_WINDOW_TEXT)->gobj();
+  event->key.window=static_cast<GdkWindow*>(g_object_ref(window));
+  event->key.send_event=TRUE;
+  event->key.time=GDK_CURRENT_TIME;
+  event->key.state=keystroke.state;
+  event->key.keyval=keystroke.keyval;
+  char utf8[7]={0, 0, 0, 0, 0, 0, 0};
+  auto unicode=gdk_keyval_to_unicode(keystroke.keyval);
+  if(unicode>=' ')
+    g_unichar_to_utf8(unicode, utf8);
+  event->key.string=g_strdup(utf8);
+  event->key.length=strlen(utf8);
+  GdkKeymapKey *keys;
+  gint keys_size;
+  auto display=gdk_window_get_display(window);
+  if(gdk_keymap_get_entries_for_keyval(gdk_keymap_get_for_display(display), keystroke.keyval, &keys, &keys_size)) {
+    event->key.hardware_keycode=keys[0].keycode;
+    event->key.group=keys[0].group;
+    g_free(keys);
+  }
+#if GTK_CHECK_VERSION(3, 20, 0)
+  gdk_event_set_device(event, gdk_seat_get_keyboard(gdk_display_get_default_seat(display)));
+#endif
+  return event;
+}
+
+class Harness {
+public:
+  Harness() {
+    window.set_default_size(800, 600);
+    window.add(scrolled_window);
+    window.show_all();
+  }
+  
+  void open(const boost::filesystem::path &file_path) {
+    close();
+    view=new Source::ClangView(file_path, Gsv::LanguageManager::get_default()->get_language("cpp"));
+    scrolled_window.add(*view);
+    view->show();
+    view->grab_focus();
+    while(!view->parsed)
+      iterate();
+    after_paint_connection=view->get_frame_clock()->signal_after_paint().connect([this] {
+      last_paint=std::chrono::steady_clock::now();
+    });
+  }
+  
+  void close() {
+    if(!view)
+      return;
+    after_paint_connection.disconnect();
+    scrolled_window.remove();
+    view->async_delete();
+    view->delete_thread.join();
+    view=nullptr;
+    while(Gtk::Main::events_pending())
+      Gtk::Main::iteration(false);
+  }
+  
+  ///Places the cursor at the start of the first line containing text
+  void place_cursor(const std::string &text, int line_offset=0) {
+    Gtk::TextIter match_start, match_end;
+    if(view->get_buffer()->begin().forward_search(text, Gtk::TEXT_SEARCH_TEXT_ONLY, match_start, match_end))
+      view->place_cursor_at_line_offset(match_start.get_line()+line_offset, 0);
+    view->scroll_to(view->get_buffer()->get_insert());
+    wait(200);
+  }
+  
+  ///Runs the main loop for the given milliseconds
+  void wait(int milliseconds) {
+    auto end=std::chrono::steady_clock::now()+std::chrono::milliseconds(milliseconds);
+    while(std::chrono::steady_clock::now()<end)
+      iterate();
+  }
+  
+  Scenario replay(const std::string &name, const std::vector<Keystroke> &keystrokes) {
+    Scenario scenario;
+    scenario.name=name;
+    busy_time=std::chrono::steady_clock::duration::zero();
+    auto start=std::chrono::steady_clock::now();
+    size_t pending_sum=0;
+    std::chrono::steady_clock::time_point completion_start;
+    bool completion_started=false;
+    for(auto &keystroke: keystrokes) {
+      auto key_time=std::chrono::steady_clock::now()+std::chrono::milliseconds(keystroke.delay);
+      while(std::chrono::steady_clock::now()<key_time) {
+        iterate();
+        if(completion_started && view->autocomplete_dialog && view->autocomplete_dialog->shown) {
+          scenario.completion_latencies.emplace_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-completion_start).count());
+          completion_started=false;
+        }
+      }
+      
+      size_t pending=Dispatcher::pending;
+      pending_sum+=pending;
+      scenario.max_pending=std::max(scenario.max_pending, pending);
+      
+      bool popup_shown=view->autocomplete_dialog && view->autocomplete_dialog->shown;
+      //The key press is sent to on_key_press_event like GTK+ does, and the release through the signal where the completion popup listens
+      auto event=create_key_event(GDK_KEY_PRESS, *view, keystroke);
+      auto key_press_time=std::chrono::steady_clock::now();
+      last_paint=key_press_time;
+      view->on_key_press_event(&event->key);
+      gdk_event_free(event);
+      if(!popup_shown && (keystroke.keyval==GDK_KEY_period || keystroke.keyval==GDK_KEY_colon || keystroke.keyval==GDK_KEY_greater)) {
+        completion_start=key_press_time;
+        completion_started=true;
+      }
+      
+      auto timeout=key_press_time+std::chrono::seconds(1);
+      while(last_paint==key_press_time && std::chrono::steady_clock::now()<timeout)
+        iterate();
+      if(last_paint!=key_press_time)
+        scenario.latencies.emplace_back(std::chrono::duration<double, std::milli>(last_paint-key_press_time).count());
+      else
+        ++scenario.missed_paints;
+      
+      event=create_key_event(GDK_KEY_RELEASE, *view, keystroke);
+      gtk_widget_event(GTK_WIDGET(view->gobj()), event);
+      gdk_event_free(event);
+    }
+    //Lets the view finish the work started by the last keystrokes
+    wait(1500);
+    auto duration=std::chrono::steady_clock::now()-start;
+    scenario.busy_fraction=std::chrono::duration<double>(busy_time).count()/std::chrono::duration<double>(duration).count();
+    if(!keystrokes.empty())
+      scenario.mean_pending=static_cast<double>(pending_sum)/keystrokes.size();
+    return scenario;
+  }
+  
+  ///Records the keystrokes typed in the view until the window is closed
+  std::vector<Keystroke> record() {
+    std::vector<Keystroke> keystrokes;
+    auto last_time=std::chrono::steady_clock::now();
+    auto connection=view->signal_key_press_event().connect([&keystrokes, &last_time](GdkEventKey *event) {
+      auto now=std::chrono::steady_clock::now();
+      keystrokes.emplace_back(Keystroke{event->keyval, event->state&(GDK_SHIFT_MASK|GDK_CONTROL_MASK|GDK_MOD1_MASK),
+                                        static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(now-last_time).count())});
+      last_time=now;
+      return false;
+    }, false);
+    while(window.get_visible())
+      Gtk::Main::iteration(true);
+    connection.disconnect();
+    return keystrokes;
+  }
+  
+  Gtk::Window window;
+  Gtk::ScrolledWindow scrolled_window;
+  Source::ClangView *view=nullptr;
+
+private:
+  sigc::connection after_paint_connection;
+  std::chrono::steady_clock::time_point last_paint;
+  std::chrono::steady_clock::duration busy_time;
+  
+  void iterate() {
+    auto start=std::chrono::steady_clock::now();
+    if(g_main_context_iteration(nullptr, FALSE))
+      busy_time+=std::chrono::steady_clock::now()-start;
+    else
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+};
+
+void print(const std::vector<Scenario> &scenarios) {
+  std::cout << std::left << std::setw(24) << "scenario" << std::right << std::setw(6) << "keys" << std::setw(9) << "p50 ms" << std::setw(9) << "p99 ms"
+            << std::setw(9) << "max ms" << std::setw(8) << "missed" << std::setw(7) << "busy" << std::setw(13) << "pending max"
+            << std::setw(14) << "pending mean" << std::setw(15) << "completion ms" << std::endl;
+  std::cout << std::fixed << std::setprecision(1);
+  for(auto &scenario: scenarios) {
+    std::cout << std::left << std::setw(24) << scenario.name << std::right << std::setw(6) << scenario.latencies.size()+scenario.missed_paints
+              << std::setw(9) << get_percentile(scenario.latencies, 0.5) << std::setw(9) << get_percentile(scenario.latencies, 0.99)
+              << std::setw(9) << get_percentile(scenario.latencies, 1.0) << std::setw(8) << scenario.missed_paints
+              << std::setw(6) << scenario.busy_fraction*100.0 << '%' << std::setw(13) << scenario.max_pending
+              << std::setw(14) << scenario.mean_pending << std::setw(15);
+    if(!scenario.completion_latencies.empty())
+      std::cout << get_percentile(scenario.completion_latencies, 0.5);
+    else
+      std::cout << '-';
+    std::cout << std::endl;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  auto app=Gtk::Application::create();
+  Gsv::init();
+  
+  Config::get().project.default_build_path="./build";
+  
+  boost::filesystem::path record_path, replay_path, file_path;
+  for(int c=1;c<argc;++c) {
+    std::string argument=argv[c];
+    if(argument=="--record" && c+1<argc)
+      record_path=argv[++c];
+    else if(argument=="--replay" && c+1<argc)
+      replay_path=argv[++c];
+    else if(!argument.empty() && argument[0]!='-' && file_path.empty())
+      file_path=boost::filesystem::absolute(argument);
+    else {
+      std::cerr << "Usage: " << argv[0] << " [--record keys.txt | --replay keys.txt] [file]" << std::endl;
+      return 1;
+    }
+  }
+  
+  std::unique_ptr<Corpus> corpus;
+  if(file_path.empty()) {
+    try {
+      Corpus::Options options;
+      options.translation_units=8;
+      options.diagnostics_files=0;
+      corpus=std::make_unique<Corpus>(Corpus::get_temp_path(), options);
+      file_path=corpus->translation_units[0];
+    }
+    catch(const std::exception &e) {
+      std::cerr << "Error: " << e.what() << std::endl;
+      return 1;
+    }
+  }
+  
+  Harness harness;
+  std::vector<Scenario> scenarios;
+  if(!record_path.empty()) {
+    harness.open(file_path);
+    auto keystrokes=harness.record();
+    std::string content;
+    for(auto &keystroke: keystrokes)
+      content+=std::to_string(keystroke.delay)+' '+gdk_keyval_name(keystroke.keyval)+' '+std::to_string(keystroke.state)+'\n';
+    if(!filesystem::write(record_path, content))
+      std::cerr << "Error: could not write " << record_path.string() << std::endl;
+  }
+  else if(!replay_path.empty()) {
+    auto keystrokes=read_keystrokes(replay_path);
+    harness.open(file_path);
+    scenarios.emplace_back(harness.replay("replay", keystrokes));
+  }
+  else if(!corpus) {
+    harness.open(file_path);
+    harness.place_cursor("\n", 1);
+    scenarios.emplace_back(harness.replay("plain_typing", get_keystrokes("int typed_value=2;\n", 80)));
+  }
+  else {
+    //A typing speed of 80 ms between keystrokes, with pauses that start reparses
+    std::string line="    int typed_value=value*2+1;\n";
+    std::string lines;
+    for(size_t c=0;c<3;++c)
+      lines+=line;
+    
+    harness.open(file_path);
+    harness.place_cursor("    return sum+static_cast<int>");
+    scenarios.emplace_back(harness.replay("plain_typing", get_keystrokes(lines, 80)));
+    
+    auto keystrokes=get_keystrokes(lines, 80);
+    for(size_t c=0;c<keystrokes.size();c+=line.size())
+      keystrokes[c].delay=1100;
+    scenarios.emplace_back(harness.replay("typing_during_reparse", keystrokes));
+    
+    keystrokes=get_keystrokes("    level.su", 80);
+    auto end_keystrokes=get_keystrokes("\x1bm_0();\n", 80);
+    //The first keystroke after the period waits for the completion popup
+    end_keystrokes[0].delay=1000;
+    keystrokes.insert(keystrokes.end(), end_keystrokes.begin(), end_keystrokes.end());
+    scenarios.emplace_back(harness.replay("completion_popup", keystrokes));
+    
+    harness.open(corpus->large_file);
+    harness.place_cursor("function_1000(", 2);
+    scenarios.emplace_back(harness.replay("large_file", get_keystrokes(lines, 80)));
+  }
+  harness.close();
+  if(corpus)
+    corpus->remove();
+  
+  if(!scenarios.empty())
+    print(scenarios);
+  return 0;
+}
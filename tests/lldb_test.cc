@@ -61,6 +61,22 @@ int main() {
       g_assert_cmpuint(value.size(), >, 16);
       auto value_substr=value.substr(0, 16);
       g_assert_cmpstr(value_substr.c_str(), ==, "(int) an_int = 1");
+      uint32_t children_size;
+      g_assert(Debug::LLDB::get().get_children(variables.at(0), 0, 10, children_size).empty());
+      g_assert_cmpuint(children_size, ==, 0);
+      line_nr=0;
+      Debug::LLDB::get().step_over();
+      for(;;) {
+        if(line_nr>0 && Debug::LLDB::get().is_stopped())
+          break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+      g_assert_cmpint(line_nr, ==, 4);
+      //an_int was read at the previous stop
+      variables=Debug::LLDB::get().get_variables();
+      g_assert_cmpstr(variables.at(0).name.c_str(), ==, "an_int");
+      g_assert_cmpstr(variables.at(0).value.c_str(), ==, "2");
+      g_assert(variables.at(0).changed);
       line_nr=0;
       Debug::LLDB::get().continue_debug();
     }
@@ -0,0 +1,36 @@
+#include <glib.h>
+#include "profile.h"
+
+int main() {
+  Profile profile;
+  profile.add_backtrace({{"memcpy", "", 0}, {"copy", "/test/main.cpp", 5}, {"main", "/test/main.cpp", 10}});
+  profile.add_backtrace({{"copy", "/test/main.cpp", 5}, {"main", "/test/main.cpp", 10}});
+  profile.add_backtrace({{"f;g", "/test/main.cpp", 20}, {"f;g", "/test/main.cpp", 20}, {"main", "/test/main.cpp", 11}});
+  profile.add_backtrace({});
+  
+  g_assert_cmpuint(profile.samples, ==, 3);
+  g_assert_cmpuint(profile.stacks.size(), ==, 3);
+  g_assert_cmpuint(profile.stacks.at("main;copy;memcpy"), ==, 1);
+  g_assert_cmpuint(profile.stacks.at("main;copy"), ==, 1);
+  g_assert_cmpuint(profile.stacks.at("main;f:g;f:g"), ==, 1);
+  
+  auto &lines=profile.lines.at("/test/main.cpp");
+  g_assert_cmpuint(lines.at(5).self, ==, 2);
+  g_assert_cmpuint(lines.at(5).total, ==, 2);
+  g_assert_cmpuint(lines.at(10).self, ==, 0);
+  g_assert_cmpuint(lines.at(10).total, ==, 2);
+  g_assert_cmpuint(lines.at(20).self, ==, 1);
+  g_assert_cmpuint(lines.at(20).total, ==, 1);
+  
+  auto summary=profile.get_summary(2);
+  g_assert(summary.find("3 samples")==0);
+  g_assert(summary.find("/test/main.cpp:5:1: 66.7% self, 66.7% total\n")!=std::string::npos);
+  g_assert(summary.find("/test/main.cpp:20:1: 33.3% self, 33.3% total\n")!=std::string::npos);
+  g_assert(summary.find("/test/main.cpp:10:1:")==std::string::npos);
+  
+  auto flame_graph=profile.get_flame_graph();
+  g_assert(flame_graph.find("<svg")!=std::string::npos);
+  g_assert(flame_graph.find("<title>main (3 samples, 100.0%)</title>")!=std::string::npos);
+  g_assert(flame_graph.find("<title>copy (2 samples, 66.7%)</title>")!=std::string::npos);
+  g_assert(flame_graph.find("<title>f:g (1 samples, 33.3%)</title>")!=std::string::npos);
+}
@@ -0,0 +1,55 @@
+#include <glib.h>
+#include "record_layout.h"
+
+int main() {
+  RecordLayout layout;
+  layout.name="Test";
+  layout.file_path="/test/main.cpp";
+  layout.line=3;
+  layout.size=24;
+  layout.alignment=8;
+  layout.fields={{"a", "char", 0, 8, 1, false}, {"b", "double", 64, 64, 8, false}, {"c", "int", 128, 32, 4, false}};
+  auto paddings=layout.get_paddings();
+  g_assert_cmpuint(paddings.size(), ==, 2);
+  g_assert_cmpint(paddings[0].offset, ==, 1);
+  g_assert_cmpint(paddings[0].size, ==, 7);
+  g_assert_cmpint(paddings[1].offset, ==, 20);
+  g_assert_cmpint(paddings[1].size, ==, 4);
+  g_assert_cmpint(layout.get_padding_size(), ==, 11);
+  auto optimal_order=layout.get_optimal_order();
+  g_assert(optimal_order[0].name=="b");
+  g_assert(optimal_order[1].name=="c");
+  g_assert(optimal_order[2].name=="a");
+  g_assert_cmpint(layout.get_optimal_size(), ==, 16);
+  auto text=layout.get_text();
+  g_assert(text.find("Test: 24 bytes, alignment 8, 11 bytes padding\n")==0);
+  g_assert(text.find("      20      4         4 bytes padding\n")!=std::string::npos);
+  g_assert(text.find("Reordering saves 8 bytes (16 bytes): b, c, a\n")!=std::string::npos);
+  
+  RecordLayout bit_fields;
+  bit_fields.size=16;
+  bit_fields.alignment=8;
+  bit_fields.fields={{"x", "unsigned", 0, 3, 4, true}, {"y", "unsigned", 3, 5, 4, true}, {"p", "void *", 64, 64, 8, false}};
+  g_assert_cmpint(bit_fields.get_padding_size(), ==, 7);
+  g_assert_cmpint(bit_fields.get_optimal_size(), ==, 16);
+  g_assert(bit_fields.get_text().find("     0:3     5b      4  unsigned y\n")!=std::string::npos);
+  
+  RecordLayout union_layout;
+  union_layout.size=8;
+  union_layout.alignment=8;
+  union_layout.fields={{"i", "int", 0, 32, 4, false}, {"d", "double", 0, 64, 8, false}};
+  g_assert_cmpint(union_layout.get_padding_size(), ==, 0);
+  g_assert_cmpint(union_layout.get_optimal_size(), ==, 8);
+  
+  RecordLayout cache_lines;
+  cache_lines.size=128;
+  cache_lines.alignment=8;
+  cache_lines.fields={{"a", "char[60]", 0, 480, 1, false}, {"b", "double", 480, 64, 1, false}, {"c", "char[60]", 544, 480, 1, false}};
+  text=cache_lines.get_text();
+  g_assert(text.find("  --- cache line boundary at 64 ---\n")!=std::string::npos);
+  g_assert(text.find("double b (crosses cache line)\n")!=std::string::npos);
+  
+  auto report=RecordLayout::get_report({union_layout, layout}, 10);
+  g_assert(report.find("1 of 2 records have padding\n")==0);
+  g_assert(report.find("/test/main.cpp:3:1: Test: 11 bytes padding of 24 bytes, reordering saves 8 bytes\n")!=std::string::npos);
+}
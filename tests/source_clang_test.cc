@@ -33,6 +33,9 @@ int main() {
   while(!clang_view->parsed)
     flush_events();
   g_assert_cmpuint(clang_view->diagnostics.size(), ==, 0);
+  g_assert_cmpuint(clang_view->performance.parses, >, 0);
+  g_assert(clang_view->performance.parse_duration>std::chrono::steady_clock::duration::zero());
+  g_assert_cmpuint(clang_view->get_translation_unit_memory(), >, 0);
   
   //test get_declaration and get_implementation
   clang_view->place_cursor_at_line_index(13, 7);
@@ -80,6 +83,66 @@ int main() {
   g_assert_cmpuint(clang_view->diagnostics.size(), >, 0);
   g_assert_cmpuint(clang_view->get_fix_its().size(), >, 0);
   
+  //test get_optimization_remarks
+  {
+    auto build_path=clang_view->file_path.parent_path()/"build";
+    auto remarks=Source::ClangViewParse::get_optimization_remarks(
+      "../main.cpp:12:5: remark: foo inlined into main [-Rpass=inline]\n"
+      "main.cpp:20:3: remark: loop not vectorized [-Rpass-missed=loop-vectorize]\n"+
+      clang_view->file_path.string()+":20:3: remark: loop not vectorized [-Rpass-missed=loop-vectorize]\n"
+      "/usr/include/c++/vector:100:1: remark: bar not inlined [-Rpass-missed=inline]\n"
+      "../main.cpp:7: error: not a remark\n", clang_view->file_path, build_path);
+    g_assert_cmpuint(remarks.size(), ==, 2);
+    g_assert_cmpint(remarks[0].line, ==, 12);
+    g_assert_cmpint(remarks[0].index, ==, 5);
+    g_assert(remarks[0].kind=="passed");
+    g_assert(remarks[0].pass=="inline");
+    g_assert(remarks[0].message=="foo inlined into main");
+    g_assert_cmpint(remarks[1].line, ==, 20);
+    g_assert(remarks[1].kind=="missed");
+    g_assert(remarks[1].pass=="loop-vectorize");
+  }
+  
+  //test get_assembly_functions
+  {
+    auto functions=Source::ClangViewParse::get_assembly_functions(
+      "\t.text\n"
+      "\t.file\t\"main.cpp\"\n"
+      "\t.globl\t_Z3fooi                 # -- Begin function _Z3fooi\n"
+      "_Z3fooi:                                # @_Z3fooi\n"
+      "\t.file\t1 \"/test\" \"main.cpp\"\n"
+      "\t.file\t2 \"/usr/include\" \"stdio.h\"\n"
+      "\t.loc\t1 3 0                   # main.cpp:3:0\n"
+      "# %bb.0:\n"
+      "\t.loc\t1 4 10 prologue_end\n"
+      "\tleal\t1(%rdi), %eax\n"
+      ".LBB0_1:\n"
+      "\t.loc\t2 7 3\n"
+      "\tretq\n"
+      ".Lfunc_end0:\n"
+      "\t.size\t_Z3fooi, .Lfunc_end0-_Z3fooi\n"
+      "\t.globl\tmain\n"
+      "main:\n"
+      "\t.loc\t1 8 0\n"
+      "\txorl\t%eax, %eax\n"
+      ".Lfunc_end1:\n"
+      "\t.data\n"
+      "global_value:\n"
+      "\t.long\t1\n", "/test/main.cpp");
+    g_assert_cmpuint(functions.size(), ==, 2);
+    g_assert(functions[0].name=="_Z3fooi");
+    g_assert_cmpuint(functions[0].lines.size(), ==, 3);
+    g_assert(functions[0].lines[0].first=="leal\t1(%rdi), %eax");
+    g_assert_cmpint(functions[0].lines[0].second, ==, 4);
+    g_assert(functions[0].lines[1].first==".LBB0_1:");
+    g_assert_cmpint(functions[0].lines[1].second, ==, 0);
+    g_assert(functions[0].lines[2].first=="retq");
+    g_assert_cmpint(functions[0].lines[2].second, ==, 0);
+    g_assert(functions[1].name=="main");
+    g_assert_cmpuint(functions[1].lines.size(), ==, 1);
+    g_assert_cmpint(functions[1].lines[0].second, ==, 8);
+  }
+  
   clang_view->async_delete();
   clang_view->delete_thread.join();
   flush_events();
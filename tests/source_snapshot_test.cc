@@ -0,0 +1,127 @@
+#include <glib.h>
+#include "source_snapshot.h"
+#include <gtkmm.h>
+#include <random>
+
+int main() {
+  auto app=Gtk::Application::create();
+  
+  auto buffer=Gtk::TextBuffer::create();
+  std::string text="int main() {\n  return 0;\n}\n";
+  buffer->set_text(text);
+  Source::SnapshotBuffer snapshot_buffer(buffer);
+  auto snapshot=snapshot_buffer.get();
+  g_assert(snapshot.str()==text);
+  g_assert_cmpuint(snapshot.size(), ==, text.size());
+  
+  buffer->insert(buffer->get_iter_at_offset(13), "  std::cout << \"æøå\";\n");
+  {
+    //Earlier snapshots are not changed
+    g_assert(snapshot.str()==text);
+    auto new_snapshot=snapshot_buffer.get();
+    g_assert(new_snapshot.str()==buffer->get_text());
+    g_assert_cmpuint(new_snapshot.size(), ==, buffer->get_text().bytes());
+    g_assert_cmpuint(new_snapshot.generation, >, snapshot.generation);
+    //Snapshots of the same generation share their text
+    g_assert(&snapshot_buffer.get().str()==&new_snapshot.str());
+  }
+  
+  buffer->erase(buffer->get_iter_at_offset(29), buffer->get_iter_at_offset(32));
+  g_assert(snapshot_buffer.get().str()==buffer->get_text());
+  
+  //Random changes to a text of several chunks
+  std::string line="  std::cout << \"æøå\" << std::endl;\n";
+  std::string large_text;
+  while(large_text.size()<5*Source::SnapshotBuffer::chunk_size)
+    large_text+=line;
+  buffer->set_text(large_text);
+  g_assert(snapshot_buffer.get().str()==large_text);
+  std::mt19937 generator(1);
+  for(size_t c=0;c<1000;++c) {
+    auto characters=buffer->get_char_count();
+    auto offset=std::uniform_int_distribution<int>(0, characters)(generator);
+    if(generator()%2==0)
+      buffer->insert(buffer->get_iter_at_offset(offset), generator()%50==0?large_text:line);
+    else {
+      auto max_erase=generator()%10==0?3*Source::SnapshotBuffer::chunk_size:100;
+      auto end=std::min<int>(characters, offset+std::uniform_int_distribution<int>(1, max_erase)(generator));
+      buffer->erase(buffer->get_iter_at_offset(offset), buffer->get_iter_at_offset(end));
+    }
+    if(c%50==0)
+      g_assert(snapshot_buffer.get().str()==buffer->get_text());
+  }
+  g_assert(snapshot_buffer.get().str()==buffer->get_text());
+  
+  buffer->set_text("");
+  g_assert(snapshot_buffer.get().empty());
+  g_assert(snapshot_buffer.get().str().empty());
+  
+  //Edits
+  {
+    buffer->set_text("int main() {}\n");
+    auto generation=snapshot_buffer.get_generation();
+    g_assert(snapshot_buffer.get_edits(generation).empty());
+    buffer->insert(buffer->get_iter_at_offset(12), "r");
+    buffer->insert(buffer->get_iter_at_offset(13), "e");
+    buffer->insert(buffer->get_iter_at_offset(14), "t");
+    buffer->erase(buffer->get_iter_at_offset(14), buffer->get_iter_at_offset(15));
+    auto edits=snapshot_buffer.get_edits(generation);
+    g_assert_cmpuint(edits.size(), ==, 1);
+    g_assert_cmpuint(edits[0].offset, ==, 12);
+    g_assert_cmpuint(edits[0].removed, ==, 0);
+    g_assert_cmpuint(edits[0].inserted, ==, 2);
+    g_assert_cmpuint(edits[0].generation, ==, snapshot_buffer.get_generation());
+    
+    buffer->erase(buffer->get_iter_at_offset(12), buffer->get_iter_at_offset(14));
+    edits=snapshot_buffer.get_edits(generation);
+    g_assert_cmpuint(edits.size(), ==, 1);
+    g_assert_cmpuint(edits[0].removed, ==, 0);
+    g_assert_cmpuint(edits[0].inserted, ==, 0);
+    
+    buffer->insert(buffer->get_iter_at_offset(0), "æ");
+    edits=snapshot_buffer.get_edits(generation);
+    g_assert_cmpuint(edits.size(), ==, 2);
+    g_assert_cmpuint(edits[1].offset, ==, 0);
+    g_assert_cmpuint(edits[1].inserted, ==, 1);
+    
+    //The edits no longer kept are returned as one edit of the whole buffer
+    for(size_t c=0;c<Source::SnapshotBuffer::max_edits;++c)
+      buffer->insert(buffer->get_iter_at_offset(0), "a");
+    edits=snapshot_buffer.get_edits(generation);
+    g_assert_cmpuint(edits.size(), ==, 1);
+    g_assert_cmpuint(edits[0].offset, ==, 0);
+    g_assert_cmpuint(edits[0].removed, ==, std::string::npos);
+    g_assert_cmpuint(edits[0].inserted, ==, static_cast<size_t>(buffer->get_char_count()));
+  }
+  
+  //Random edits replayed on the earlier text give the current text
+  {
+    buffer->set_text(large_text.substr(0, 10*line.size()));
+    std::vector<std::pair<size_t, Glib::ustring> > texts;
+    for(size_t c=0;c<500;++c) {
+      texts.emplace_back(snapshot_buffer.get_generation(), buffer->get_text());
+      auto characters=buffer->get_char_count();
+      //Edits are mostly close to the previous one, as when typing
+      auto offset=std::uniform_int_distribution<int>(std::max(0, characters/2-3), std::min(characters, characters/2+3))(generator);
+      if(generator()%2==0)
+        buffer->insert(buffer->get_iter_at_offset(offset), generator()%2==0?"æ":"a b");
+      else
+        buffer->erase(buffer->get_iter_at_offset(offset), buffer->get_iter_at_offset(std::min(characters, offset+std::uniform_int_distribution<int>(0, 3)(generator))));
+    }
+    Glib::ustring current_text=buffer->get_text();
+    for(auto &text: texts) {
+      auto edits=snapshot_buffer.get_edits(text.first);
+      g_assert_cmpuint(edits.back().generation, ==, snapshot_buffer.get_generation());
+      //Inserted characters are taken from the current text, which is only possible for the last of the edits
+      auto edit=edits.back();
+      for(auto it=edits.begin();it!=edits.end()-1;++it) {
+        g_assert_cmpuint(it->generation, <, edit.generation);
+        text.second.replace(it->offset, it->removed, Glib::ustring(it->inserted, '?'));
+      }
+      text.second.replace(edit.offset, edit.removed, current_text.substr(edit.offset, edit.inserted));
+      g_assert_cmpuint(text.second.size(), ==, current_text.size());
+      for(size_t c=0;c<current_text.size();++c)
+        g_assert(text.second[c]==current_text[c] || text.second[c]=='?');
+    }
+  }
+}
@@ -16,6 +16,10 @@ SelectionDialog::SelectionDialog(Gtk::TextView& text_view, Glib::RefPtr<Gtk::Tex
 
 SelectionDialogBase::~SelectionDialogBase() {}
 
+SelectionDialog::~SelectionDialog() {}
+
+void SelectionDialog::rows_added() {}
+
 bool SelectionDialog::on_key_press(GdkEventKey* key) { return true; }
 
 CompletionDialog::CompletionDialog(Gtk::TextView &text_view, Glib::RefPtr<Gtk::TextBuffer::Mark> start_mark):
@@ -0,0 +1,77 @@
+#include <glib.h>
+#include "trace.h"
+#include "filesystem.h"
+
+int main() {
+  auto tests_path=boost::filesystem::canonical(JUCI_TESTS_PATH);
+  
+  {
+    TRACE_SCOPE("disabled");
+  }
+  g_assert_cmpuint(Trace::get_events().size(), ==, 0);
+  
+  Trace::enabled=true;
+  {
+    TRACE_SCOPE("outer");
+    g_assert_cmpint(Trace::active_scopes, ==, 1);
+    TRACE_SCOPE("inner", std::string("detail"));
+    g_assert_cmpint(Trace::active_scopes, ==, 2);
+  }
+  g_assert_cmpint(Trace::active_scopes, ==, 0);
+  {
+    auto events=Trace::get_events();
+    g_assert_cmpuint(events.size(), ==, 2);
+    g_assert(events[0].name=="outer");
+    g_assert(events[1].name=="inner detail");
+    g_assert_cmpuint(events[0].thread, ==, 0);
+    g_assert(events[0].start<=events[1].start && events[1].end<=events[0].end);
+  }
+  
+  //Names are truncated
+  {
+    TRACE_SCOPE("long", std::string(200, 'a'));
+  }
+  g_assert_cmpuint(Trace::get_events().back().name.size(), ==, 79);
+  
+  //Events from threads are kept after the threads have ended, and the oldest events are overwritten.
+  //The oldest slot of a full buffer is skipped since the thread might be writing to it.
+  std::thread thread([] {
+    for(size_t c=0;c<Trace::buffer_size+10;++c) {
+      TRACE_SCOPE("thread");
+    }
+  });
+  thread.join();
+  {
+    auto events=Trace::get_events();
+    g_assert_cmpuint(events.size(), ==, Trace::buffer_size+2);
+    size_t thread_events=0;
+    for(auto &event: events) {
+      if(event.name=="thread") {
+        g_assert_cmpuint(event.thread, ==, 1);
+        ++thread_events;
+      }
+    }
+    g_assert_cmpuint(thread_events, ==, Trace::buffer_size-1);
+  }
+  
+  auto trace_path=tests_path/"tmp"/"trace_test.json";
+  g_assert(Trace::write(trace_path));
+  auto content=filesystem::read(trace_path);
+  g_assert(content.find("\"name\":\"inner detail\",\"ph\":\"X\"")!=std::string::npos);
+  g_assert(content.find("\"args\":{\"name\":\"main\"}")!=std::string::npos);
+  g_assert(Trace::get_summary(10).find("thread ("+std::to_string(Trace::buffer_size-1)+" times)")!=std::string::npos);
+  boost::filesystem::remove(trace_path);
+  
+  Trace::clear();
+  g_assert_cmpuint(Trace::get_events().size(), ==, 0);
+  {
+    TRACE_SCOPE("after clear");
+  }
+  g_assert_cmpuint(Trace::get_events().size(), ==, 1);
+  
+  Trace::enabled=false;
+  {
+    TRACE_SCOPE("disabled");
+  }
+  g_assert_cmpuint(Trace::get_events().size(), ==, 1);
+}
@@ -0,0 +1,56 @@
+#include <glib.h>
+#include "watchdog.h"
+#include "filesystem.h"
+#include <gtkmm.h>
+
+int main() {
+  auto app=Gtk::Application::create();
+  
+  auto tests_path=boost::filesystem::canonical(JUCI_TESTS_PATH);
+  auto log_path=tests_path/"tmp"/"watchdog_test.log";
+  auto rotated_log_path=boost::filesystem::path(log_path.string()+".1");
+  boost::filesystem::remove(rotated_log_path);
+  //A full log is rotated
+  g_assert(filesystem::write(log_path, std::string(Watchdog::max_log_size, '-')));
+  
+  auto &watchdog=Watchdog::get();
+  watchdog.start(std::chrono::milliseconds(50), log_path);
+  
+  //Regular heartbeats are not stalls
+  for(size_t c=0;c<4;++c) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    watchdog.heartbeat();
+  }
+  
+  {
+    Watchdog::Task task("watchdog_test task");
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  }
+  watchdog.heartbeat();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  watchdog.heartbeat();
+  
+  watchdog.stop();
+  g_assert(Watchdog::task==nullptr);
+  
+  auto histogram=watchdog.get_histogram();
+  g_assert_cmpuint(histogram.size(), ==, Watchdog::histogram_size);
+  g_assert_cmpuint(histogram[2], ==, 1);
+  size_t stalls=0;
+  for(auto &count: histogram)
+    stalls+=count;
+  g_assert_cmpuint(stalls, ==, 1);
+  
+  g_assert(boost::filesystem::exists(rotated_log_path));
+  auto log=filesystem::read(log_path);
+  g_assert(log.find("stall of ")!=std::string::npos);
+  g_assert(log.find(" ms in watchdog_test task\n")!=std::string::npos);
+#ifndef _WIN32
+  g_assert(log.find("\n  #0 ")!=std::string::npos);
+#endif
+  g_assert(log.find(" main loop stalls this session: 1\n")!=std::string::npos);
+  g_assert(log.find("     200 ms -      400 ms: 1\n")!=std::string::npos);
+  
+  boost::filesystem::remove(log_path);
+  boost::filesystem::remove(rotated_log_path);
+}
@@ -0,0 +1,110 @@
+#include <glib.h>
+#include "word_index.h"
+#include "filesystem.h"
+#include "corpus.h"
+#include <algorithm>
+#include <chrono>
+
+int main() {
+  auto tests_path=boost::filesystem::canonical(JUCI_TESTS_PATH);
+  auto file_path1=tests_path/"tmp"/"word_index_file1.txt";
+  auto file_path2=tests_path/"tmp"/"word_index_file2.txt";
+  
+  {
+    auto file_words=WordIndex::get_file_words("int main() { print_value(value_count); value_count++; 1abc a_ ÆØÅord }");
+    g_assert_cmpuint(file_words.size(), ==, 5);
+    g_assert_cmpuint(file_words["value_count"], ==, 2);
+    g_assert_cmpuint(file_words["print_value"], ==, 1);
+    g_assert_cmpuint(file_words["ÆØÅord"], ==, 1);
+    g_assert(file_words.find("1abc")==file_words.end());
+    g_assert(file_words.find("a_")==file_words.end());
+  }
+  
+  g_assert(filesystem::write(file_path1, "value_count value_count value_first"));
+  g_assert(filesystem::write(file_path2, "value_second value_count"));
+  
+  auto &word_index=WordIndex::get();
+  word_index.add_file(file_path1, "cpp");
+  word_index.add_file(file_path2, "cpp");
+  word_index.update_words();
+  
+  auto words=word_index.get_words("value_", 10, "cpp");
+  g_assert_cmpuint(words.size(), ==, 3);
+  g_assert(words[0]=="value_count");
+  g_assert(words[1]=="value_first");
+  g_assert(words[2]=="value_second");
+  
+  words=word_index.get_words("value_", 1, "cpp");
+  g_assert_cmpuint(words.size(), ==, 1);
+  g_assert(words[0]=="value_count");
+  
+  words=word_index.get_words("value_", 10, "cpp", file_path1);
+  g_assert_cmpuint(words.size(), ==, 1);
+  g_assert(words[0]=="value_second");
+  
+  //Words of other languages are left out
+  g_assert(word_index.get_words("value_", 10, "python").empty());
+  
+  //Changed files are merged into the words of their language
+  g_assert(filesystem::write(file_path2, "value_third"));
+  word_index.update_files({file_path2});
+  words=word_index.get_words("value_", 10, "cpp");
+  g_assert_cmpuint(words.size(), ==, 3);
+  g_assert(words[0]=="value_count");
+  g_assert(words[1]=="value_first");
+  g_assert(words[2]=="value_third");
+  words=word_index.get_words("value_", 10, "cpp", file_path2);
+  g_assert_cmpuint(words.size(), ==, 2);
+  
+  g_assert(boost::filesystem::remove(file_path2));
+  word_index.update_files({file_path2});
+  words=word_index.get_words("value_", 10, "cpp");
+  g_assert_cmpuint(words.size(), ==, 2);
+  g_assert(words[0]=="value_count");
+  g_assert(words[1]=="value_first");
+  
+  g_assert(boost::filesystem::remove(file_path1));
+  word_index.update_files({file_path1});
+  g_assert(word_index.get_words("value_", 10, "cpp").empty());
+  
+  //Build directories are not indexed
+  auto build_path=tests_path/"tmp"/"word_index_build";
+  boost::filesystem::create_directories(build_path);
+  g_assert(!WordIndex::skip_directory(build_path, nullptr));
+  g_assert(filesystem::write(build_path/"CMakeCache.txt", ""));
+  g_assert(WordIndex::skip_directory(build_path, nullptr));
+  boost::filesystem::remove_all(build_path);
+  
+  //Lookups in a large generated project take less than 5 ms. The large file is kept below maximum_file_size.
+  {
+    Corpus::Options options;
+    options.commits=1;
+    options.diagnostics_files=0;
+    options.large_file_lines=30000;
+    Corpus corpus(Corpus::get_temp_path(), options);
+    for(auto &file_path: corpus.translation_units)
+      word_index.add_file(file_path, "cpp");
+    for(auto &file_path: corpus.headers)
+      word_index.add_file(file_path, "cpp");
+    word_index.add_file(corpus.large_file, "cpp");
+    word_index.update_words();
+    
+    std::vector<double> times;
+    for(size_t c=0;c<20;++c) {
+      auto start=std::chrono::steady_clock::now();
+      words=word_index.get_words("function_", 100, "cpp", corpus.translation_units[0]);
+      times.emplace_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count());
+      g_assert_cmpuint(words.size(), ==, 100);
+    }
+    std::sort(times.begin(), times.end());
+    g_assert_cmpfloat(times[times.size()/2], <, 5.0);
+    
+    //Updating a file only merges its words
+    g_assert(filesystem::write(corpus.translation_units[0], "function_updated"));
+    word_index.update_files({corpus.translation_units[0]});
+    words=word_index.get_words("function_upd", 10, "cpp");
+    g_assert_cmpuint(words.size(), ==, 1);
+    
+    corpus.remove();
+  }
+}